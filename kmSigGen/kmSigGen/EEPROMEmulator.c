@@ -0,0 +1,287 @@
+/*
+ * EEPROMEmulator.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifdef _TESTS_ENV
+
+#include <string.h>
+#include "config.h"
+#include "EEPROMEmulator.h"
+#include "Settings.h"
+#include "SignalGeneratorAD9833.h"
+
+// one of that many saves of eeEmuSettingsCheck is interrupted by power failure (power of 2)
+#define EE_EMU_POWER_FAIL_MASK 0x07
+// power failure happens within that many written bytes (two records)
+#define EE_EMU_POWER_FAIL_BYTES 18
+// one of that many saves of eeEmuSettingsCheck is followed by regular restart (power of 2)
+#define EE_EMU_RESTART_MASK 0x0F
+// the longest time EEPROM runs between saves of eeEmuSettingsCheck (queue may get full)
+#define EE_EMU_SAVE_INTERVAL_US 100000UL
+
+// bounds of the eeprom_emu section (provided by the linker), content of the modeled EEPROM
+extern uint8_t __start_eeprom_emu[];
+extern uint8_t __stop_eeprom_emu[];
+
+volatile uint8_t EECR = 0;
+volatile uint8_t EEDR = 0;
+volatile uint16_t EEAR = 0;
+
+static uint32_t _eeEmuWear[E2END + 1];
+// modeled time left of the write in progress
+static uint32_t _eeEmuWriteUs = 0;
+static EeEmuStats _eeEmuStats;
+static bool _eeEmuPowerFailArmed = false;
+static bool _eeEmuPowerFailed = false;
+static uint32_t _eeEmuPowerFailBytes = 0;
+static uint32_t _eeEmuRandom = 1;
+
+// private functions
+uint32_t eeEmuNextRandom(void);
+void eeEmuProgram(void);
+uint32_t eeEmuAdvance(uint32_t us);
+uint32_t eeEmuCheckPresets(const UIWaveType *waveTypes, const uint32_t *freqRegs);
+
+// Implementation
+/*
+ * Function eeEmuNextRandom
+ * Desc     xorshift generator, so sequences are the same on every host
+ * Output   next pseudo random value
+ */
+uint32_t eeEmuNextRandom(void) {
+	_eeEmuRandom ^= _eeEmuRandom << 13;
+	_eeEmuRandom ^= _eeEmuRandom >> 17;
+	_eeEmuRandom ^= _eeEmuRandom << 5;
+	return _eeEmuRandom;
+}
+
+uint16_t eeEmuGetAddress(const void *pointer) {
+	return (const uint8_t *)pointer - __start_eeprom_emu;
+}
+
+void eeprom_read_block(void *dst, const void *src, size_t n) {
+	memcpy(dst, src, n);
+	_eeEmuStats.bytesRead += n;
+}
+
+void eeprom_write_block(const void *src, void *dst, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		eeprom_busy_wait();
+		EEAR = eeEmuGetAddress((const uint8_t *)dst + i);
+		EEDR = ((const uint8_t *)src)[i];
+		EECR |= _BV(EEWE);
+	}
+}
+
+/*
+ * Function eeEmuProgram
+ * Desc     programs EEDR register value to the cell of EEAR address (write started with EEWE bit),
+ *          in case of power failure byte gets random value and following writes are lost
+ */
+void eeEmuProgram(void) {
+	if (_eeEmuPowerFailed == true || EEAR > E2END) {
+		return;
+	}
+	uint8_t data = EEDR;
+	if (_eeEmuPowerFailArmed == true) {
+		if (_eeEmuPowerFailBytes == 0) {
+			// byte is partially erased or programmed
+			data = eeEmuNextRandom();
+			_eeEmuPowerFailed = true;
+		} else {
+			_eeEmuPowerFailBytes--;
+		}
+	}
+	__start_eeprom_emu[EEAR] = data;
+	if (_eeEmuWear[EEAR] == 0) {
+		_eeEmuStats.cellsWritten++;
+	}
+	_eeEmuWear[EEAR]++;
+	if (_eeEmuWear[EEAR] > _eeEmuStats.wearMax) {
+		_eeEmuStats.wearMax = _eeEmuWear[EEAR];
+	}
+	_eeEmuStats.bytesWritten++;
+	_eeEmuStats.writeTimeUs += EE_EMU_WRITE_US;
+}
+
+/*
+ * Function eeEmuAdvance
+ * Desc     advances the write in progress (started when EEWE bit is found set), EEWE bit is cleared
+ *          once the write is completed
+ * Input    us: time in microseconds
+ * Output   time consumed by the write
+ */
+uint32_t eeEmuAdvance(uint32_t us) {
+	if ((EECR & _BV(EEWE)) == 0) {
+		return 0;
+	}
+	if (_eeEmuWriteUs == 0) {
+		eeEmuProgram();
+		_eeEmuWriteUs = EE_EMU_WRITE_US;
+	}
+	uint32_t result = (us < _eeEmuWriteUs) ? us : _eeEmuWriteUs;
+	_eeEmuWriteUs -= result;
+	if (_eeEmuWriteUs == 0) {
+		EECR &= ~_BV(EEWE);
+	}
+	return result;
+}
+
+void eeEmuBusyWait(void) {
+	_eeEmuStats.waitTimeUs += eeEmuAdvance(EE_EMU_WRITE_US);
+}
+
+void eeEmuRun(uint32_t us) {
+	uint32_t time = 0;
+	while (us == 0 || time < us) {
+		if ((EECR & _BV(EEWE)) == 0) {
+			if ((EECR & _BV(EERIE)) == 0) {
+				break;
+			}
+#ifdef KMSG_EEPROM_JOURNAL
+			EE_RDY_vect();
+#endif
+			if ((EECR & _BV(EEWE)) == 0) {
+				break;
+			}
+		}
+		time += eeEmuAdvance((us == 0) ? EE_EMU_WRITE_US : us - time);
+	}
+}
+
+void eeEmuErase(void) {
+	memset(__start_eeprom_emu, 0xFF, __stop_eeprom_emu - __start_eeprom_emu);
+	memset(_eeEmuWear, 0, sizeof(_eeEmuWear));
+	memset(&_eeEmuStats, 0, sizeof(_eeEmuStats));
+	_eeEmuPowerFailArmed = false;
+	_eeEmuPowerFailed = false;
+	_eeEmuWriteUs = 0;
+	EECR = 0;
+}
+
+uint32_t eeEmuGetWear(uint16_t address) {
+	return (address <= E2END) ? _eeEmuWear[address] : 0;
+}
+
+EeEmuStats eeEmuGetStats(void) {
+	return _eeEmuStats;
+}
+
+void eeEmuPowerFail(uint32_t bytes) {
+	_eeEmuPowerFailArmed = true;
+	_eeEmuPowerFailed = false;
+	_eeEmuPowerFailBytes = bytes;
+}
+
+bool eeEmuPowerRestore(void) {
+	bool result = _eeEmuPowerFailed;
+	_eeEmuPowerFailArmed = false;
+	_eeEmuPowerFailed = false;
+	_eeEmuWriteUs = 0;
+	EECR = 0;
+	return result;
+}
+
+/*
+ * Function eeEmuCheckPresets
+ * Desc     compares presets returned by settingsGetPreset with expected ones
+ * Input    waveTypes: expected wave types
+ *          freqRegs: expected frequency registers
+ * Output   number of violations
+ */
+uint32_t eeEmuCheckPresets(const UIWaveType *waveTypes, const uint32_t *freqRegs) {
+	uint32_t result = 0;
+	for (uint8_t i = 0; i < KMSG_MAX_PRESETS; i++) {
+		UIWaveType waveType;
+		uint32_t freqReg;
+		settingsGetPreset(i, &waveType, &freqReg);
+		if (waveType != waveTypes[i] || freqReg != freqRegs[i]) {
+			result++;
+		}
+	}
+	return result;
+}
+
+uint32_t eeEmuSettingsCheck(uint32_t seed, uint32_t saves) {
+	UIWaveType waveTypes[KMSG_MAX_PRESETS];
+	uint32_t freqRegs[KMSG_MAX_PRESETS];
+	uint32_t result = 0;
+	_eeEmuRandom = (seed != 0) ? seed : 1;
+	eeEmuErase();
+	settingsInit();
+	for (uint8_t i = 0; i < KMSG_MAX_PRESETS; i++) {
+		settingsGetPreset(i, &waveTypes[i], &freqRegs[i]);
+	}
+	for (uint32_t i = 0; i < saves; i++) {
+		uint32_t random = eeEmuNextRandom();
+		uint8_t preset = random % KMSG_MAX_PRESETS;
+		UIWaveType waveType = (UIWaveType)(UI_SIG_SQUARE + (random >> 8) % UI_SIG_NONE);
+		uint32_t freqReg = eeEmuNextRandom() & SG_FREQ_REG_MASK;
+		bool powerFail = (((random >> 16) & EE_EMU_POWER_FAIL_MASK) == 0);
+		if (powerFail == true) {
+			// queued writes of previous saves are completed, so only this save can be interrupted
+			eeEmuRun(0);
+			eeEmuPowerFail(eeEmuNextRandom() % EE_EMU_POWER_FAIL_BYTES);
+		}
+		settingsSavePreset(preset, waveType, freqReg);
+		UIWaveType savedWaveType;
+		uint32_t savedFreqReg;
+		settingsGetPreset(preset, &savedWaveType, &savedFreqReg);
+		if (savedWaveType != waveType || savedFreqReg != freqReg) {
+			result++;
+		}
+		if (powerFail == true) {
+			eeEmuRun(0);
+			powerFail = eeEmuPowerRestore();
+		}
+		if (powerFail == true) {
+			settingsInit();
+			UIWaveType restoredWaveType;
+			uint32_t restoredFreqReg;
+			settingsGetPreset(preset, &restoredWaveType, &restoredFreqReg);
+			// interrupted save leaves either the old or the new value
+			if (restoredWaveType == waveType && restoredFreqReg == freqReg) {
+				waveTypes[preset] = waveType;
+				freqRegs[preset] = freqReg;
+			}
+			result += eeEmuCheckPresets(waveTypes, freqRegs);
+		} else {
+			waveTypes[preset] = waveType;
+			freqRegs[preset] = freqReg;
+			eeEmuRun(eeEmuNextRandom() % EE_EMU_SAVE_INTERVAL_US + 1);
+			if (((random >> 24) & EE_EMU_RESTART_MASK) == 0) {
+				while (settingsIsWriteDone() == false) {
+					eeEmuRun(EE_EMU_WRITE_US);
+				}
+				settingsInit();
+				result += eeEmuCheckPresets(waveTypes, freqRegs);
+			}
+		}
+	}
+	eeEmuRun(0);
+	settingsInit();
+	return result + eeEmuCheckPresets(waveTypes, freqRegs);
+}
+
+#endif
@@ -0,0 +1,184 @@
+/** @file
+ * @brief Host-side EEPROM with wear counters and power failure injection for Settings.c.
+ * EEPROMEmulator.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Available only in test environment (_TESTS_ENV defined). In such case Settings.c uses
+ *  EEMEM, eeprom_* routines and EEPROM registers defined here instead of avr-libc ones.
+ *  Variables declared with EEMEM are placed in the eeprom_emu section, which is the content
+ *  of the modeled EEPROM (erased to 0xFF by eeEmuErase). Write started with EEWE bit is done
+ *  by eeEmuRun, which also calls EE_RDY_vect() while EERIE is set and EEPROM is ready.
+ *  Every written byte is counted per cell (wear) and takes EE_EMU_WRITE_US of modeled time,
+ *  writes may be cut after given number of bytes (power failure).
+ *  Example of the host build (driver calling eeEmu* and settings* functions,
+ *  e.g. kmSigGenTests/TestSettings.c run by "make test"):
+ *  gcc -D_TESTS_ENV -DF_CPU=8000000UL Settings.c EEPROMEmulator.c StringTools.c driver.c
+ *
+ *  References:
+ * -# https://www.microchip.com/webdoc/AVRLibcReferenceManual/group__avr__eeprom.html
+ * -# https://ww1.microchip.com/downloads/en/DeviceDoc/Microchip%208bit%20mcu%20AVR%20ATmega8A%20data%20sheet%2040001974A.pdf
+ */
+
+#ifndef EEPROMEMULATOR_H_
+#define EEPROMEMULATOR_H_
+
+#ifdef _TESTS_ENV
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// host replacements of avr-libc definitions used by Settings.c
+#define EEMEM __attribute__((section("eeprom_emu")))
+// last EEPROM address of ATmega8
+#define E2END 0x1FF
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+// interrupts are never nested on the host, so atomic blocks are plain blocks
+// (TWIMasterEmulator.h defines the same)
+#ifndef ATOMIC_BLOCK
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_BLOCK(type) for (uint8_t _eeEmuAtomic = 1; _eeEmuAtomic != 0; _eeEmuAtomic = 0)
+#define ISR(vector) void vector(void)
+#endif
+#define EERIE 3
+#define EEMWE 2
+#define EEWE 1
+#define eeprom_is_ready() ((EECR & _BV(EEWE)) == 0)
+#define eeprom_busy_wait() eeEmuBusyWait()
+
+extern volatile uint8_t EECR;
+extern volatile uint8_t EEDR;
+extern volatile uint16_t EEAR;
+
+/**
+EEPROM ready interrupt, defined in Settings.c (with KMSG_EEPROM_JOURNAL).
+*/
+void EE_RDY_vect(void);
+
+/**
+Reads block of the modeled EEPROM.
+@param dst destination in RAM
+@param src source, address of EEMEM variable
+@param n number of bytes
+*/
+void eeprom_read_block(void *dst, const void *src, size_t n);
+
+/**
+Writes block of the modeled EEPROM byte by byte, waits for the previous write before each byte
+(last byte is still being written on return).
+@param src source in RAM
+@param dst destination, address of EEMEM variable
+@param n number of bytes
+*/
+void eeprom_write_block(const void *src, void *dst, size_t n);
+
+/**
+Waits for the write in progress, modeled time of the write is counted as time CPU was blocked.
+*/
+void eeEmuBusyWait(void);
+
+/**
+Converts address of EEMEM variable to EEPROM address (value for EEAR register).
+@param pointer address of EEMEM variable
+@result EEPROM address
+*/
+uint16_t eeEmuGetAddress(const void *pointer);
+
+// modeled erase and write time of single byte (ATmega8 datasheet, typical)
+#define EE_EMU_WRITE_US 8500UL
+// write cycles guaranteed by the datasheet for single cell
+#define EE_EMU_ENDURANCE 100000UL
+
+/**
+Access statistics collected since last eeEmuErase call.
+*/
+typedef struct {
+	/// bytes read
+	uint32_t bytesRead;
+	/// bytes written (each byte is a write cycle of a cell)
+	uint32_t bytesWritten;
+	/// the highest number of write cycles of single cell
+	uint32_t wearMax;
+	/// number of cells written at least once
+	uint16_t cellsWritten;
+	/// modeled time of writes in microseconds
+	uint64_t writeTimeUs;
+	/// modeled time CPU waited for writes in microseconds (eeprom_busy_wait)
+	uint64_t waitTimeUs;
+} EeEmuStats;
+
+/**
+Erases whole modeled EEPROM to 0xFF, clears wear counters and statistics and disables power failure.
+*/
+void eeEmuErase(void);
+
+/**
+Runs modeled EEPROM for given time, completes writes and calls EE_RDY_vect() whenever EEPROM
+is ready and EERIE bit is set.
+@param us time in microseconds, 0 runs until EEPROM is ready and EERIE bit is cleared
+*/
+void eeEmuRun(uint32_t us);
+
+/**
+Returns number of write cycles of the cell.
+@param address address of the cell (0 to E2END)
+@result number of write cycles since eeEmuErase
+*/
+uint32_t eeEmuGetWear(uint16_t address);
+
+/**
+Returns statistics collected since eeEmuErase.
+@result access statistics
+*/
+EeEmuStats eeEmuGetStats(void);
+
+/**
+Cuts power after given number of bytes is written, byte in progress gets random value and all
+following writes are lost until eeEmuPowerRestore is called (power failure in the middle of the write).
+@param bytes number of bytes written correctly
+*/
+void eeEmuPowerFail(uint32_t bytes);
+
+/**
+Restores writes disabled by eeEmuPowerFail (device rebooted, EEPROM registers are cleared).
+@result true in case power failure has happened since eeEmuPowerFail
+*/
+bool eeEmuPowerRestore(void);
+
+/**
+Saves random presets with settingsSavePreset (random power failures included) running modeled EEPROM
+for random time between the saves, checks that settingsGetPreset returns saved value right away.
+After settingsIsWriteDone or power failure restarts settings with settingsInit and checks that every
+preset has its last saved value (value of the save interrupted by power failure may be either the old
+or the new one). eeEmuErase is called first, wear of the cells and time CPU was blocked by writes can
+be checked afterwards with eeEmuGetStats.
+@param seed seed of the pseudo random sequence, same seed gives the same sequence
+@param saves number of saved presets
+@result number of detected violations (0 in case of success)
+*/
+uint32_t eeEmuSettingsCheck(uint32_t seed, uint32_t saves);
+
+#endif
+
+#endif /* EEPROMEMULATOR_H_ */
@@ -28,21 +28,168 @@
 #include "StringTools.h"
 #include "UserInterface.h"
 #include "SignalGeneratorAD9833.h"
-#include "UserInterface.h"
+#include "Settings.h"
 #include "TWISlave.h"
+#include "Usart.h"
+#include "ScpiParser.h"
+#include "version.h"
 
 #define EXT_BIN_COMMAND_POS_L1 29
+// command 0x06 (status) is extended with the second level command on bits 24 - 28
+#define EXT_BIN_COMMAND_POS_L2 24
+#define EXT_BIN_COMMAND_MASK_L2 0x1F
+#define EXT_STATUS_TWI_RX 0x00
+#define EXT_STATUS_COALESCING 0x01
+#define EXT_STATUS_USART_RX 0x02
+#define EXT_STATUS_SCPI 0x03
+#define EXT_STATUS_TWI_RESET 0x04
+// bits 0 - 6 new TWI/I2C address, bits 8 - 15 its complement (guard against accidental change),
+// address is changed and stored in EEPROM after the transaction, response is read from the new address
+#define EXT_STATUS_TWI_ADDRESS 0x05
+#define EXT_TWI_ADDRESS(X) ((X) & 0x7F)
+#define EXT_TWI_ADDRESS_KEY(X) (((X) >> 8) & 0xFF)
+// command 0x04 (frequency hopping) uses second level command on the same bits
+// upload: bits 8 - 15 first index, bits 0 - 7 number of entries, followed in the same
+// transaction by 2 words per entry - frequency register and dwell time in microseconds
+#define EXT_HOP_UPLOAD 0x00
+// start (single playback) and loop: bits 0 - 7 number of entries to be played back
+#define EXT_HOP_START 0x01
+#define EXT_HOP_LOOP 0x02
+#define EXT_HOP_STOP 0x03
+#define EXT_HOP_INDEX(X) (((X) >> 8) & 0xFF)
+#define EXT_HOP_LENGTH(X) ((X) & 0xFF)
+// command 0x04 also passes raw 16bit words to AD9833 in single FSYNC frame (available without KMSG_HOP)
+// single word: bits 0 - 15 the word
+#define EXT_RAW_WORD 0x10
+// multiple words: bits 0 - 7 number of words, followed in the same transaction by words
+// with two AD9833 words each (MSB first, odd number of words leaves bits 0 - 15 of the last one unused)
+#define EXT_RAW_WORDS 0x11
+#define EXT_RAW_MAX_WORDS 16
+#define EXT_RAW_LENGTH(X) ((X) & 0xFF)
 #define EXT_SEND_BUFFER_SELECTOR_BIT 25
+// command 0x03 (bulk string): bit 25 selects the buffer as in 0x07, bits 0 - 7 number of characters,
+// followed in the same transaction by words with 4 characters each (MSB first)
+#define EXT_STRING_LENGTH(X) ((X) & 0xFF)
+#define EXT_STRING_WORDS(X) ((EXT_STRING_LENGTH(X) + 3) >> 2)
 
-static char _extStrBuffer1[STR_INTERNAL_BUFFERS_SIZE_OF] = "";
-static char _extStrBuffer2[STR_INTERNAL_BUFFERS_SIZE_OF] = "";
+static char _extStrBuffer1[STR_EXTERNAL_BUFFERS_SIZE_OF] = "";
+static char _extStrBuffer2[STR_EXTERNAL_BUFFERS_SIZE_OF] = "";
 
 static volatile bool _extStrBuffer1Changed = false;
 static volatile bool _extStrBuffer2Changed = false;
 
+// signal generator writes and wave type / frequency commands skipped as superseded by later ones
+static uint16_t _extGeneratorWrites = 0;
+static uint16_t _extCommandsCoalesced = 0;
+
+#ifdef KMSG_USART
+// USART frame: sync byte, payload length in bytes, payload (commands MSB first),
+// CRC-8 (polynomial 0x07) of length and payload; reply frame has the same format
+// with payload made of status byte optionally followed by the response word
+#define EXT_USART_SYNC 0xA5
+#define EXT_USART_WORDS (USART_FRAME_LENGTH / 4)
+#if (USART_FRAME_LENGTH & 0x03) != 0 || USART_FRAME_LENGTH > 252
+#error "USART_FRAME_LENGTH has to be multiple of 4 up to 252"
+#endif
+#define EXT_USART_STATUS_OK 0x00
+#define EXT_USART_STATUS_REJECTED 0x01
+
+typedef enum {
+	EXT_USART_SYNC_WAIT,
+	EXT_USART_LENGTH_WAIT,
+	EXT_USART_PAYLOAD_WAIT,
+	EXT_USART_CRC_WAIT,
+	// payload and CRC of the frame with wrong length are skipped
+	EXT_USART_SKIP
+} ExtUsartState;
+
+static ExtUsartState _extUsartState = EXT_USART_SYNC_WAIT;
+static uint32_t _extUsartWords[EXT_USART_WORDS];
+static uint8_t _extUsartLength = 0;
+static uint8_t _extUsartIndex = 0;
+static uint8_t _extUsartCrc = 0;
+// frames executed and frames lost (wrong length or CRC, buffer overflow)
+static uint16_t _extUsartFrames = 0;
+static uint16_t _extUsartFrameErrors = 0;
+#endif
+
+#ifdef KMSG_SCPI
+#ifndef KMSG_USART
+#error "KMSG_SCPI requires KMSG_USART"
+#endif
+static const char _extStrIdn[] PROGMEM = APP_AUTHOR "," APP_NAME ",0," APP_VERSION;
+// SCPI commands with errors and the longest parsing of single command in Timer1 ticks
+static uint16_t _extScpiErrors = 0;
+static uint16_t _extScpiTicks = 0;
+static uint16_t _extScpiTicksMax = 0;
+// ticks (F_CPU / 8) converted to microseconds, exact for F_CPU in whole MHz
+#define EXT_TICKS_TO_US(X) ((uint32_t)(X) * 8 / (F_CPU / 1000000UL))
+#ifdef KMSG_HOP
+// entries uploaded to the frequency hopping table, played back by SWE:STAR
+static uint8_t _extHopLength = 0;
+#endif
+#endif
+
+#ifndef KMSG_NO_TWI
+#if defined(TWI_REGISTER_MAP) && EXT_REG_TWI_WRITES + 2 > TWI_REGISTERS_LENGTH
+#error "TWI_REGISTERS_LENGTH too small for the register map"
+#endif
+static uint32_t _extResponse = 0;
+static uint8_t _extRegisters[TWI_REGISTERS_LENGTH];
+static bool _extRegistersChanged = true;
+#endif
+
+/**
+Signal generator parameters collected from all transactions (TWI/I2C writes) executed in single extLoop call.
+*/
+typedef struct {
+	uint32_t freqReg;
+	UIWaveType waveType;
+	bool freqRegSet;
+	bool waveTypeSet;
+	uint8_t commandsCoalesced;
+	// start, loop or stop of frequency hopping (0 in case there is no such command)
+	uint32_t hopCommand;
+	// frequency to be staged in the inactive register
+	uint32_t stagedFreqReg;
+	bool stagedFreqRegSet;
+	// new TWI/I2C address (0 in case it's not changed)
+	uint8_t twiAddress;
+} ExtBatch;
+
 // Private functions
-void extCommand(uint32_t binaryCommand, uint32_t *binaryResponse, bool *responseAvailable);
+uint16_t extGetCommandLength(uint32_t binaryCommand);
+bool extIsValidCommand(uint32_t binaryCommand);
+uint32_t extResponse(uint32_t binaryCommand, const ExtBatch *batch);
+bool extCommand(const uint32_t *words, ExtBatch *batch, uint32_t *responseCommand);
+#ifdef KMSG_HOP
+bool extIsValidHopCommand(uint32_t binaryCommand);
+void extHopCommand(uint32_t binaryCommand);
+#endif
+void extBatchInit(ExtBatch *batch);
+#ifdef TWI_GENERAL_CALL_COMMIT
+void extGeneralCall(uint8_t data);
+#endif
+bool extTransaction(const uint32_t *words, uint8_t length, ExtBatch *batch, uint32_t *responseCommand);
+void extApplyParameters(const ExtBatch *batch);
+void extApplyBatch(const ExtBatch *batch);
+#ifdef KMSG_RAW_WORDS
+bool extRawCommand(const uint32_t *words, ExtBatch *batch);
+#endif
+#ifdef KMSG_USART
+bool extUsartReceive(uint8_t data);
+void extUsartReply(uint8_t status, uint32_t response, bool isResponse);
+void extUsartLoop(void);
+#endif
+#ifdef KMSG_SCPI
+void extUsartPutStr_P(const char *str);
+void extUsartPutStr(const char *str);
+bool extScpiReceive(uint8_t data);
+#endif
+void extPutRegister(uint8_t address, uint32_t value, uint8_t length);
+void extUpdateRegisters(void);
 UIWaveType decodeWaveType(uint8_t data);
+uint8_t encodeWaveType(UIWaveType waveType);
 
 bool extIsSplashStringChanged(void) {
 	bool result = _extStrBuffer1Changed;
@@ -65,15 +212,36 @@ const char *extGetWifiAddress(void) {
 }
 
 void extLoop(void) {
+#ifdef KMSG_USART
+	extUsartLoop();
+#endif
 #ifndef KMSG_NO_TWI
+#ifdef TWI_GENERAL_CALL_COMMIT
+	// commit is executed before queued writes, which may stage the next frequency
+	uint8_t generalCall;
+	if (twiGetGeneralCall(&generalCall) == true) {
+		extGeneralCall(generalCall);
+	}
+#endif
 	if (twiIsDataInBuffer() == true) {
-		bool responseAvailable = false;
-		uint32_t response = 0;
-		extCommand(twiGetDataFromBuffer(), &response, &responseAvailable);
-		if (responseAvailable == true) {
-			twiPutDataResponse(response);
-		}
+		ExtBatch batch;
+		extBatchInit(&batch);
+		uint32_t words[TWI_TRANSACTION_WORDS];
+		uint8_t wordsExecuted = 0;
+		// drain queued transactions within the budget, so only the last frequency
+		// and wave type of a burst reach signal generator and display
+		do {
+			uint8_t length = twiGetTransaction(words);
+			uint32_t responseCommand = 0;
+			extTransaction(words, length, &batch, &responseCommand);
+			if (responseCommand != 0) {
+				_extResponse = extResponse(responseCommand, &batch);
+			}
+			wordsExecuted += length;
+		} while (wordsExecuted < KMSG_EXT_WORDS_BUDGET && twiIsDataInBuffer() == true);
+		extApplyBatch(&batch);
 	}
+	extUpdateRegisters();
 #endif
 }
 
@@ -99,60 +267,510 @@ UIWaveType decodeWaveType(uint8_t data) {
 	return UI_SIG_NONE;
 }
 
-uint32_t encodeWaveTypeAndFrequency(void) {
-
-	uint32_t result = sgCalcFreqReg(usrGetCurrentFrequency());
-
-	UIWaveType currentWaveType = usrGetWaveType();
-	switch (currentWaveType) {
+uint8_t encodeWaveType(UIWaveType waveType) {
+	switch (waveType) {
 		case UI_SIG_SQUARE : {
 			// wave type square 0b01
-			currentWaveType |= (0x01L << EXT_BIN_COMMAND_POS_L1);
-			break;
-		}			
+			return 0x01;
+		}
 		case UI_SIG_SINE : {
 			// wave type sine 0b10
-			currentWaveType |= (0x02L << EXT_BIN_COMMAND_POS_L1);
-			break;
+			return 0x02;
 		}
 		case UI_SIG_TRIANGLE : {
 			// wave type triangle 0b11
-			currentWaveType |= (0x03L << EXT_BIN_COMMAND_POS_L1);
-			break;
+			return 0x03;
 		}
 		default : {
 			// wave type none 0b00
+			return 0x00;
 		}
 	}
+}
+
+uint32_t encodeWaveTypeAndFrequency(uint32_t freqReg, UIWaveType waveType) {
+	return freqReg | ((uint32_t)encodeWaveType(waveType) << EXT_BIN_COMMAND_POS_L1);
+}
+
+#ifndef KMSG_NO_TWI
+/**
+Stores value in the register map, big endian (MSB first) as the commands.
+@param address address of the register
+@param value value of the register
+@param length length of the register in bytes
+*/
+void extPutRegister(uint8_t address, uint32_t value, uint8_t length) {
+	while (length > 0) {
+		length--;
+		uint8_t data = value >> (length * 8);
+		if (_extRegisters[address] != data) {
+			_extRegisters[address] = data;
+			_extRegistersChanged = true;
+		}
+		address++;
+	}
+}
+
+/**
+Refreshes the register map (only the response without TWI_REGISTER_MAP) and passes it
+to TWI/I2C routines only in case any register has changed.
+*/
+void extUpdateRegisters(void) {
+	extPutRegister(EXT_REG_RESPONSE, _extResponse, 4);
+#ifdef TWI_REGISTER_MAP
+	extPutRegister(EXT_REG_FREQ_REG, usrGetCurrentFreqReg(), 4);
+	extPutRegister(EXT_REG_WAVE_TYPE, encodeWaveType(usrGetWaveType()), 1);
+	// phase registers are programmed only with raw writes (0x04 command)
+	uint8_t select = (sgGetFSelect() == true) ? 0x01 : 0x00;
+	if (sgGetPSelect() == true) {
+		select |= 0x02;
+	}
+	if (sgIsStaged() == true) {
+		select |= 0x04;
+	}
+#ifndef KMSG_NO_EEPROM
+	if (settingsIsWriteDone() == false) {
+		select |= 0x08;
+	}
+#endif
+	extPutRegister(EXT_REG_SELECT, select, 1);
+	extPutRegister(EXT_REG_PHASE_REG, sgGetPhaseReg(), 2);
+	extPutRegister(EXT_REG_VERSION, (KMSG_VERSION_MAJOR << 8) | KMSG_VERSION_MINOR, 2);
+	extPutRegister(EXT_REG_QUEUE_TRANSACTIONS, twiGetTransactionsInBuffer(), 1);
+	extPutRegister(EXT_REG_QUEUE_WORDS, twiGetWordsInBuffer(), 1);
+	extPutRegister(EXT_REG_TWI_OVERFLOWS, twiGetStat(TWI_STAT_OVERFLOWS), 2);
+	extPutRegister(EXT_REG_TWI_DROPS, twiGetStat(TWI_STAT_LENGTH_ERRORS), 2);
+	extPutRegister(EXT_REG_GENERATOR_WRITES, _extGeneratorWrites, 2);
+	extPutRegister(EXT_REG_COMMANDS_COALESCED, _extCommandsCoalesced, 2);
+#ifdef KMSG_HOP
+	uint8_t hopState = (sgHopIsRunning() == true) ? 0x01 : 0x00;
+	if (sgHopIsLoop() == true) {
+		hopState |= 0x02;
+	}
+	extPutRegister(EXT_REG_HOP_STATE, hopState, 1);
+	extPutRegister(EXT_REG_HOP_INDEX, sgHopGetIndex(), 1);
+	extPutRegister(EXT_REG_HOP_LATENCY_MAX, sgHopGetLatencyMax(), 2);
+	extPutRegister(EXT_REG_HOP_JITTER, sgHopGetJitter(), 2);
+#endif
+#ifdef TWI_ISR_TIMING
+	extPutRegister(EXT_REG_TWI_ISR_MAX, twiGetIsrTimeMax(), 2);
+#endif
+	extPutRegister(EXT_REG_TWI_BUS_ERRORS, twiGetStat(TWI_STAT_BUS_ERRORS), 2);
+	extPutRegister(EXT_REG_TWI_NACKS, twiGetStat(TWI_STAT_NACKS), 2);
+	extPutRegister(EXT_REG_TWI_GENERAL_CALLS, twiGetStat(TWI_STAT_GENERAL_CALLS), 2);
+	extPutRegister(EXT_REG_TWI_READS, twiGetStat(TWI_STAT_READS), 2);
+	extPutRegister(EXT_REG_TWI_WRITES, twiGetStat(TWI_STAT_WRITES), 2);
+#endif
+	if (_extRegistersChanged == true) {
+		_extRegistersChanged = false;
+		twiPutRegisters(_extRegisters);
+	}
+}
+#endif
+
+/**
+Returns number of words used by the command, including data words following it in the transaction.
+@param binaryCommand first word of the command
+@result number of words
+*/
+uint16_t extGetCommandLength(uint32_t binaryCommand) {
+	uint8_t binCommandL1 = (binaryCommand >> EXT_BIN_COMMAND_POS_L1);
+	uint8_t binCommandL2 = (binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2;
+	if (binCommandL1 == 0x04 && binCommandL2 == EXT_HOP_UPLOAD) {
+		return 1 + 2 * EXT_HOP_LENGTH(binaryCommand);
+	}
+	if (binCommandL1 == 0x04 && binCommandL2 == EXT_RAW_WORDS) {
+		return 1 + ((EXT_RAW_LENGTH(binaryCommand) + 1) >> 1);
+	}
+	if (binCommandL1 == 0x03) {
+		return 1 + EXT_STRING_WORDS(binaryCommand);
+	}
+	return 1;
+}
 
+#ifdef KMSG_HOP
+bool extIsValidHopCommand(uint32_t binaryCommand) {
+	uint8_t length = EXT_HOP_LENGTH(binaryCommand);
+	switch ((binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2) {
+		case EXT_HOP_UPLOAD : {
+			return (length > 0 && EXT_HOP_INDEX(binaryCommand) + length <= KMSG_HOP_TABLE_LENGTH);
+		}
+		case EXT_HOP_START :
+		case EXT_HOP_LOOP : {
+			return (length > 0 && length <= KMSG_HOP_TABLE_LENGTH);
+		}
+		case EXT_HOP_STOP : {
+			return true;
+		}
+		default : {
+			return false;
+		}
+	}
+}
+
+/**
+Starts or stops frequency hopping, stopped generator returns to parameters set in User Interface.
+@param binaryCommand hopping command (start, loop or stop)
+*/
+void extHopCommand(uint32_t binaryCommand) {
+	switch ((binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2) {
+		case EXT_HOP_START : {
+			sgHopStart(EXT_HOP_LENGTH(binaryCommand), false);
+			break;
+		}
+		case EXT_HOP_LOOP : {
+			sgHopStart(EXT_HOP_LENGTH(binaryCommand), true);
+			break;
+		}
+		case EXT_HOP_STOP : {
+			// also stops the playback
+			setGeneratorParameters(usrGetCurrentFreqReg(), ui2sgWaveType(usrGetWaveType()));
+			break;
+		}
+	}
+}
+#endif
+
+#ifdef TWI_GENERAL_CALL_COMMIT
+/**
+Handles data byte of TWI/I2C general call, TWI_GENERAL_CALL_COMMIT selects frequency
+staged with command 0x02. User Interface follows the frequency committed to the generator.
+@param data received byte
+*/
+void extGeneralCall(uint8_t data) {
+	if (data == TWI_GENERAL_CALL_COMMIT && sgCommitStaged() == true) {
+		usrSyncParameters(sgGetFreqReg(), usrGetWaveType());
+	}
+}
+#endif
+
+bool extIsValidCommand(uint32_t binaryCommand) {
+	uint8_t binCommandL1 = (binaryCommand >> EXT_BIN_COMMAND_POS_L1);
+	if (binCommandL1 == 0x02) {
+#ifdef TWI_GENERAL_CALL_COMMIT
+		return true;
+#else
+		return false;
+#endif
+	}
+	if (binCommandL1 == 0x03) {
+#ifdef KMSG_BULK_STRINGS
+		return (EXT_STRING_LENGTH(binaryCommand) < STR_EXTERNAL_BUFFERS_SIZE_OF);
+#else
+		return false;
+#endif
+	}
+	if (binCommandL1 == 0x04) {
+#ifdef KMSG_RAW_WORDS
+		uint8_t binCommandL2 = (binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2;
+		if (binCommandL2 == EXT_RAW_WORD) {
+			return true;
+		}
+		if (binCommandL2 == EXT_RAW_WORDS) {
+			return (EXT_RAW_LENGTH(binaryCommand) > 0 && EXT_RAW_LENGTH(binaryCommand) <= EXT_RAW_MAX_WORDS);
+		}
+#endif
+#ifdef KMSG_HOP
+		return extIsValidHopCommand(binaryCommand);
+#else
+		return false;
+#endif
+	}
+	if (binCommandL1 == 0x06) {
+		uint8_t binCommandL2 = (binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2;
+#ifndef KMSG_NO_TWI
+		if (binCommandL2 == EXT_STATUS_TWI_ADDRESS) {
+			uint8_t address = EXT_TWI_ADDRESS(binaryCommand);
+			return (EXT_TWI_ADDRESS_KEY(binaryCommand) == (uint8_t)~address
+					&& address >= TWI_ADDRESS_MIN && address <= TWI_ADDRESS_MAX);
+		}
+#endif
+		return (binCommandL2 == EXT_STATUS_TWI_RX || binCommandL2 == EXT_STATUS_COALESCING
+				|| binCommandL2 == EXT_STATUS_USART_RX || binCommandL2 == EXT_STATUS_SCPI
+				|| binCommandL2 == EXT_STATUS_TWI_RESET);
+	}
+	return (binCommandL1 == 0x00 || binCommandL1 == 0x01 || binCommandL1 == 0x05 || binCommandL1 == 0x07);
+}
+
+/**
+Prepares response to the last command of the transaction requesting it.
+@param binaryCommand command requesting response (0x05 or 0x06)
+@param batch parameters including all transactions executed so far
+@result response to be sent back to the external module
+*/
+uint32_t extResponse(uint32_t binaryCommand, const ExtBatch *batch) {
+	if ((binaryCommand >> EXT_BIN_COMMAND_POS_L1) == 0x05) {
+		return encodeWaveTypeAndFrequency(batch->freqReg, batch->waveType);
+	}
+	uint32_t result = 0;
+	switch ((binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2) {
+		case EXT_STATUS_TWI_RX :
+		case EXT_STATUS_TWI_RESET : {
+#ifndef KMSG_NO_TWI
+			// writes dropped with NACK on bits 16 - 31, writes with wrong length on bits 0 - 15
+			result = ((uint32_t)twiGetStat(TWI_STAT_OVERFLOWS) << 16) | twiGetStat(TWI_STAT_LENGTH_ERRORS);
+			if (((binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2) == EXT_STATUS_TWI_RESET) {
+				// counters are returned once more before they are cleared
+				twiResetStats();
+			}
+#endif
+			break;
+		}
+		case EXT_STATUS_COALESCING : {
+			// signal generator writes on bits 16 - 31, skipped (superseded) commands on bits 0 - 15
+			result = ((uint32_t)_extGeneratorWrites << 16) | _extCommandsCoalesced;
+			break;
+		}
+		case EXT_STATUS_USART_RX : {
+#ifdef KMSG_USART
+			// executed frames on bits 16 - 31, lost frames on bits 0 - 15
+			result = ((uint32_t)_extUsartFrames << 16) | _extUsartFrameErrors;
+#endif
+			break;
+		}
+		case EXT_STATUS_SCPI : {
+#ifdef KMSG_SCPI
+			// commands with errors on bits 16 - 31, the longest parsing of single command
+			// in microseconds on bits 0 - 15
+			uint32_t parseUs = EXT_TICKS_TO_US(_extScpiTicksMax);
+			result = ((uint32_t)_extScpiErrors << 16) | ((parseUs > UINT16_MAX) ? UINT16_MAX : parseUs);
+#endif
+			break;
+		}
+		case EXT_STATUS_TWI_ADDRESS : {
+			// address the device responds to once the batch is applied
+			result = batch->twiAddress;
+			break;
+		}
+	}
 	return result;
 }
 
+/**
+Starts collecting signal generator parameters from current state of the User Interface.
+@result batch signal generator parameters to be collected from transactions
+*/
+void extBatchInit(ExtBatch *batch) {
+	batch->freqReg = usrGetCurrentFreqReg();
+	batch->waveType = usrGetWaveType();
+	batch->freqRegSet = false;
+	batch->waveTypeSet = false;
+	batch->commandsCoalesced = 0;
+	batch->hopCommand = 0;
+	batch->stagedFreqRegSet = false;
+	batch->twiAddress = 0;
+}
+
+/**
+Executes all words of single transaction from external module. Transaction containing
+any unknown command is rejected as a whole. Wave type and frequency changes are only
+collected in the batch, response (see extResponse) should reflect the state after the transaction.
+@param words commands of the transaction
+@param length number of words in the transaction
+@result batch signal generator parameters collected in the current extLoop call
+@result responseCommand last command of the transaction requesting response (not changed if there is no such command)
+@result true in case transaction has been executed, false if it has been rejected
+(or raw words of any command have been rejected by signal generator)
+*/
+bool extTransaction(const uint32_t *words, uint8_t length, ExtBatch *batch, uint32_t *responseCommand) {
+	uint8_t i = 0;
+	while (i < length) {
+		uint16_t commandLength = extGetCommandLength(words[i]);
+		if (extIsValidCommand(words[i]) == false || commandLength > length - i) {
+			return false;
+		}
+		i += commandLength;
+	}
+	bool result = true;
+	for (i = 0; i < length; i += extGetCommandLength(words[i])) {
+		if (extCommand(&words[i], batch, responseCommand) == false) {
+			result = false;
+		}
+	}
+	return result;
+}
+
+/**
+Writes wave type and frequency collected from all transactions of the batch to signal
+generator at once, directly from the received register value. User Interface only
+follows the change, so its main screen is refreshed once in the background.
+@param batch signal generator parameters collected in the current extLoop call
+*/
+void extApplyParameters(const ExtBatch *batch) {
+	if (batch->freqRegSet == true || batch->waveTypeSet == true) {
+		setGeneratorParameters(batch->freqReg, ui2sgWaveType(batch->waveType));
+		usrSyncParameters(batch->freqReg, batch->waveType);
+		if (_extGeneratorWrites < UINT16_MAX) {
+			_extGeneratorWrites++;
+		}
+		if (_extCommandsCoalesced < UINT16_MAX - batch->commandsCoalesced) {
+			_extCommandsCoalesced += batch->commandsCoalesced;
+		} else {
+			_extCommandsCoalesced = UINT16_MAX;
+		}
+	}
+}
+
+/**
+Applies the batch: wave type and frequency (see extApplyParameters) followed by staged
+frequency, frequency hopping and TWI/I2C address.
+@param batch signal generator parameters collected in the current extLoop call
+*/
+void extApplyBatch(const ExtBatch *batch) {
+	extApplyParameters(batch);
+#ifdef TWI_GENERAL_CALL_COMMIT
+	if (batch->stagedFreqRegSet == true) {
+		sgStageFreqReg(batch->stagedFreqReg);
+	}
+#endif
+#ifdef KMSG_HOP
+	if (batch->hopCommand != 0) {
+		extHopCommand(batch->hopCommand);
+	}
+#endif
+#ifndef KMSG_NO_TWI
+	if (batch->twiAddress != 0) {
+#ifndef KMSG_NO_EEPROM
+		settingsSaveTwiAddress(batch->twiAddress);
+#endif
+		twiSetAddress(batch->twiAddress);
+	}
+#endif
+}
+
+#ifdef KMSG_RAW_WORDS
+/**
+Writes raw words to the generator. Wave type and frequency of the batch collected so far
+are applied before, so the words are written in the order of the commands, and the batch
+continues from the state programmed by the words. Staged frequency and hopping collected
+before are overridden by the words, TWI/I2C address is still applied with the batch.
+User Interface follows the programmed frequency and wave type.
+@param words raw command followed by its data words
+@result batch signal generator parameters collected in the current extLoop call
+@result true in case the words have been written, false if they have been rejected by signal generator
+*/
+bool extRawCommand(const uint32_t *words, ExtBatch *batch) {
+	uint16_t rawWords[EXT_RAW_MAX_WORDS];
+	uint8_t count = 1;
+	if (((words[0] >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2) == EXT_RAW_WORD) {
+		rawWords[0] = words[0] & 0xFFFF;
+	} else {
+		count = EXT_RAW_LENGTH(words[0]);
+		for (uint8_t i = 0; i < count; i++) {
+			rawWords[i] = words[1 + (i >> 1)] >> (((i & 0x01) == 0) ? 16 : 0);
+		}
+	}
+	extApplyParameters(batch);
+	batch->freqRegSet = false;
+	batch->waveTypeSet = false;
+	batch->commandsCoalesced = 0;
+	if (sgWriteRaw(rawWords, count) == false) {
+		return false;
+	}
+	usrSyncParameters(sgGetFreqReg(), sg2uiWaveType(sgGetWaveType()));
+	if (_extGeneratorWrites < UINT16_MAX) {
+		_extGeneratorWrites++;
+	}
+	batch->freqReg = usrGetCurrentFreqReg();
+	batch->waveType = usrGetWaveType();
+	batch->hopCommand = 0;
+	batch->stagedFreqRegSet = false;
+	return true;
+}
+#endif
+
 /**
 Execute command from external module. The implementation takes care about delivering
 external commands to right application modules or making it available via above functions.
-@param binaryCommand to be executed (internal implementation takes care about the particular bits interpretation)
-@result binaryResponse binary response of the command that is send back to the external module in case vresponseAvailable is true
-@result responseAvailable in case it's true, then binaryResponse value should be sent back to the external module
+@param words command to be executed followed by its data words (internal implementation takes care about the particular bits interpretation)
+@result batch signal generator parameters collected in the current extLoop call
+@result responseCommand command requesting response (0 in case there is no such command)
+@result false in case raw words have been rejected by signal generator, true otherwise
 */
-void extCommand(uint32_t binaryCommand, uint32_t *binaryResponse, bool *responseAvailable) {
+bool extCommand(const uint32_t *words, ExtBatch *batch, uint32_t *responseCommand) {
+	uint32_t binaryCommand = words[0];
 	uint8_t binCommandL1 = (binaryCommand >> EXT_BIN_COMMAND_POS_L1);
 	switch (binCommandL1) {
 		case 0x00 : {
 			// move bit 5 to bit 1 and bit 1 to bit 0 to get value in range from 0 to 3
 			uint8_t waveData = ((binaryCommand >> 4) | (binaryCommand >> 1)) & 0x03;
-			UIWaveType waveType = decodeWaveType(waveData);
-			usrSetWaveType(waveType);
+			if (batch->waveTypeSet == true) {
+				batch->commandsCoalesced++;
+			}
+			batch->waveType = decodeWaveType(waveData);
+			batch->waveTypeSet = true;
+			// retune stops hopping and discards staged frequency set before
+			batch->hopCommand = 0;
+			batch->stagedFreqRegSet = false;
 			break;
 		}
 		case 0x01 : {
-			uint32_t freqReg0 = binaryCommand & 0x1FFFFFFF;
-			usrSetFrequency(sgCalcFreq(freqReg0));
+			// register value is used directly, without conversion to frequency
+			if (batch->freqRegSet == true) {
+				batch->commandsCoalesced++;
+			}
+			batch->freqReg = binaryCommand & SG_FREQ_REG_MASK;
+			batch->freqRegSet = true;
+			batch->hopCommand = 0;
+			batch->stagedFreqRegSet = false;
+			break;
+		}
+		case 0x02 : {
+			// loaded into inactive register, selected by general call on all devices at once
+			batch->stagedFreqReg = binaryCommand & SG_FREQ_REG_MASK;
+			batch->stagedFreqRegSet = true;
+			batch->hopCommand = 0;
+			break;
+		}
+#ifdef KMSG_BULK_STRINGS
+		case 0x03 : {
+			// whole string is replaced at once, so it's redrawn only once
+			if (((binaryCommand >> EXT_SEND_BUFFER_SELECTOR_BIT) & 0x01) == 0x00) {
+				strUnpackBulk(&words[1], EXT_STRING_LENGTH(binaryCommand), _extStrBuffer1);
+				_extStrBuffer1Changed = true;
+			} else {
+				strUnpackBulk(&words[1], EXT_STRING_LENGTH(binaryCommand), _extStrBuffer2);
+				_extStrBuffer2Changed = true;
+			}
 			break;
 		}
-		case 0x05 : {
-			*binaryResponse = encodeWaveTypeAndFrequency();
-			*responseAvailable = true;
+#endif
+		case 0x04 : {
+#if defined(KMSG_RAW_WORDS) || defined(KMSG_HOP)
+			uint8_t binCommandL2 = (binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2;
+#endif
+#ifdef KMSG_RAW_WORDS
+			if (binCommandL2 == EXT_RAW_WORD || binCommandL2 == EXT_RAW_WORDS) {
+				return extRawCommand(words, batch);
+			}
+#endif
+#ifdef KMSG_HOP
+			if (binCommandL2 == EXT_HOP_UPLOAD) {
+				uint8_t index = EXT_HOP_INDEX(binaryCommand);
+				for (uint8_t i = 0; i < EXT_HOP_LENGTH(binaryCommand); i++) {
+					sgHopPutEntry(index + i, words[1 + 2 * i], words[2 + 2 * i]);
+				}
+#ifdef KMSG_SCPI
+				if (index + EXT_HOP_LENGTH(binaryCommand) > _extHopLength) {
+					_extHopLength = index + EXT_HOP_LENGTH(binaryCommand);
+				}
+#endif
+			} else {
+				// executed after wave type and frequency of the batch
+				batch->hopCommand = binaryCommand;
+				batch->stagedFreqRegSet = false;
+			}
+#endif
+			break;
+		}
+		case 0x05 :
+		case 0x06 : {
+			if (binCommandL1 == 0x06
+					&& ((binaryCommand >> EXT_BIN_COMMAND_POS_L2) & EXT_BIN_COMMAND_MASK_L2) == EXT_STATUS_TWI_ADDRESS) {
+				batch->twiAddress = EXT_TWI_ADDRESS(binaryCommand);
+			}
+			// response is prepared once the whole transaction is executed
+			*responseCommand = binaryCommand;
 			break;
 		}
 		case 0x07 : {
@@ -166,4 +784,206 @@ void extCommand(uint32_t binaryCommand, uint32_t *binaryResponse, bool *response
 			break;
 		}
 	}
+	return true;
+}
+
+#ifdef KMSG_USART
+/**
+Passes received byte to the USART frame decoder, words of the payload are assembled
+directly into the frame buffer. Decoder waits for the next sync byte after any error.
+@param data received byte
+@result true in case complete frame with correct CRC is available in the frame buffer
+*/
+bool extUsartReceive(uint8_t data) {
+	switch (_extUsartState) {
+		case EXT_USART_SYNC_WAIT : {
+			if (data == EXT_USART_SYNC) {
+				_extUsartState = EXT_USART_LENGTH_WAIT;
+			}
+			break;
+		}
+		case EXT_USART_LENGTH_WAIT : {
+			if (data == 0 || data > USART_FRAME_LENGTH || (data & 0x03) != 0) {
+				if (_extUsartFrameErrors < UINT16_MAX) {
+					_extUsartFrameErrors++;
+				}
+				// bytes of the declared length are binary, they can't reach SCPI parser
+				// or be taken for the sync byte
+				_extUsartLength = data;
+				_extUsartIndex = 0;
+				_extUsartState = EXT_USART_SKIP;
+				break;
+			}
+			_extUsartLength = data;
+			_extUsartIndex = 0;
+			_extUsartCrc = strCrc8(0, data);
+			_extUsartState = EXT_USART_PAYLOAD_WAIT;
+			break;
+		}
+		case EXT_USART_PAYLOAD_WAIT : {
+			uint32_t *word = &_extUsartWords[_extUsartIndex >> 2];
+			*word = (*word << 8) | data;
+			_extUsartCrc = strCrc8(_extUsartCrc, data);
+			if (++_extUsartIndex == _extUsartLength) {
+				_extUsartState = EXT_USART_CRC_WAIT;
+			}
+			break;
+		}
+		case EXT_USART_CRC_WAIT : {
+			_extUsartState = EXT_USART_SYNC_WAIT;
+			if (data == _extUsartCrc) {
+				return true;
+			}
+			if (_extUsartFrameErrors < UINT16_MAX) {
+				_extUsartFrameErrors++;
+			}
+			break;
+		}
+		case EXT_USART_SKIP : {
+			// payload and CRC
+			if (_extUsartIndex++ == _extUsartLength) {
+				_extUsartState = EXT_USART_SYNC_WAIT;
+			}
+			break;
+		}
+	}
+	return false;
+}
+
+/**
+Sends reply frame for the executed frame.
+@param status EXT_USART_STATUS_OK or EXT_USART_STATUS_REJECTED
+@param response response to the command requesting it
+@param isResponse true in case response is included in the reply
+*/
+void extUsartReply(uint8_t status, uint32_t response, bool isResponse) {
+	uint8_t length = (isResponse == true) ? 5 : 1;
+	uint8_t crc = strCrc8(0, length);
+	usartPutByte(EXT_USART_SYNC);
+	usartPutByte(length);
+	usartPutByte(status);
+	crc = strCrc8(crc, status);
+	if (isResponse == true) {
+		for (int8_t i = 24; i >= 0; i -= 8) {
+			uint8_t data = response >> i;
+			usartPutByte(data);
+			crc = strCrc8(crc, data);
+		}
+	}
+	usartPutByte(crc);
+}
+
+/**
+Decodes bytes received by USART and executes at most one complete frame per call,
+all commands of the frame are executed as a single transaction.
+*/
+void extUsartLoop(void) {
+	while (usartIsDataInBuffer() == true) {
+		uint8_t data = usartGetByte();
+#ifdef KMSG_SCPI
+		// text commands never contain the sync byte, so they are passed to SCPI parser between frames
+		if (_extUsartState == EXT_USART_SYNC_WAIT && data != EXT_USART_SYNC) {
+			if (extScpiReceive(data) == true) {
+				break;
+			}
+			continue;
+		}
+#endif
+		if (extUsartReceive(data) == true) {
+			ExtBatch batch;
+			extBatchInit(&batch);
+			uint32_t responseCommand = 0;
+			uint8_t length = _extUsartLength >> 2;
+			bool executed = extTransaction(_extUsartWords, length, &batch, &responseCommand);
+			extApplyBatch(&batch);
+			if (_extUsartFrames < UINT16_MAX) {
+				_extUsartFrames++;
+			}
+			uint32_t response = (responseCommand != 0) ? extResponse(responseCommand, &batch) : 0;
+			extUsartReply((executed == true) ? EXT_USART_STATUS_OK : EXT_USART_STATUS_REJECTED,
+					response, responseCommand != 0);
+			break;
+		}
+	}
 }
+
+#ifdef KMSG_SCPI
+void extUsartPutStr_P(const char *str) {
+	char c;
+	while ((c = pgm_read_byte(str++)) != '\0') {
+		usartPutByte(c);
+	}
+}
+
+void extUsartPutStr(const char *str) {
+	while (*str != '\0') {
+		usartPutByte(*str++);
+	}
+}
+
+/**
+Passes received byte to SCPI parser and executes completed command. Commands setting
+frequency or wave type go through the same batch as TWI/I2C and USART frames.
+@param data received byte
+@result true in case command has been completed
+*/
+bool extScpiReceive(uint8_t data) {
+	uint16_t start = TCNT1;
+	ScpiCommand command = scpiParse(data);
+	_extScpiTicks += TCNT1 - start;
+	if (command == SCPI_NONE) {
+		return false;
+	}
+	if (_extScpiTicks > _extScpiTicksMax) {
+		_extScpiTicksMax = _extScpiTicks;
+	}
+	_extScpiTicks = 0;
+	ExtBatch batch;
+	extBatchInit(&batch);
+	switch (command) {
+		case SCPI_FREQ : {
+			batch.freqReg = scpiGetFreqReg();
+			batch.freqRegSet = true;
+			break;
+		}
+		case SCPI_FUNC : {
+			batch.waveType = scpiGetWaveType();
+			batch.waveTypeSet = true;
+			break;
+		}
+		case SCPI_FREQ_QUERY : {
+			char buffer[SCPI_FREQ_STR_LENGTH];
+			scpiFreqRegToStr(buffer, usrGetCurrentFreqReg());
+			extUsartPutStr(buffer);
+			usartPutByte('\n');
+			break;
+		}
+		case SCPI_SWEEP_START : {
+#ifdef KMSG_HOP
+			if (_extHopLength > 0) {
+				batch.hopCommand = (0x04UL << EXT_BIN_COMMAND_POS_L1)
+						| ((uint32_t)EXT_HOP_LOOP << EXT_BIN_COMMAND_POS_L2) | _extHopLength;
+				break;
+			}
+#endif
+			command = SCPI_ERROR;
+			break;
+		}
+		case SCPI_IDN_QUERY : {
+			extUsartPutStr_P(_extStrIdn);
+			usartPutByte('\n');
+			break;
+		}
+		default : {
+			break;
+		}
+	}
+	if (command == SCPI_ERROR && _extScpiErrors < UINT16_MAX) {
+		_extScpiErrors++;
+	}
+	extApplyBatch(&batch);
+	return true;
+}
+#endif
+
+#endif
@@ -30,6 +30,47 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+// TWI/I2C register map, multi-byte registers are big endian (MSB first)
+// single byte write sets register pointer, following read auto-increments from it
+// (only EXT_REG_RESPONSE is available without TWI_REGISTER_MAP)
+// response to the last 0x05/0x06 command
+#define EXT_REG_RESPONSE 0x00
+// 28bit value of the frequency register
+#define EXT_REG_FREQ_REG 0x04
+// wave type 0 - none, 1 - square, 2 - sine, 3 - triangle
+#define EXT_REG_WAVE_TYPE 0x08
+// active registers, bit 0 - FSELECT, bit 1 - PSELECT, bit 2 - frequency staged for general call commit,
+// bit 3 - saved settings still being written to EEPROM (power shouldn't be switched off)
+#define EXT_REG_SELECT 0x09
+// 12bit value of the active phase register
+#define EXT_REG_PHASE_REG 0x0A
+// firmware version major, minor
+#define EXT_REG_VERSION 0x0C
+// transactions and words waiting for execution
+#define EXT_REG_QUEUE_TRANSACTIONS 0x0E
+#define EXT_REG_QUEUE_WORDS 0x0F
+// TWI/I2C writes dropped with NACK or by bus error and writes with wrong length
+#define EXT_REG_TWI_OVERFLOWS 0x10
+#define EXT_REG_TWI_DROPS 0x12
+// signal generator writes and commands skipped as superseded by later ones
+#define EXT_REG_GENERATOR_WRITES 0x14
+#define EXT_REG_COMMANDS_COALESCED 0x16
+// frequency hopping, bit 0 - playback running, bit 1 - playback in loop
+#define EXT_REG_HOP_STATE 0x18
+// index of the hopping table entry currently generated
+#define EXT_REG_HOP_INDEX 0x19
+// highest delay of switching to the next entry and its jitter in microseconds
+#define EXT_REG_HOP_LATENCY_MAX 0x1A
+#define EXT_REG_HOP_JITTER 0x1C
+// longest execution of TWI/I2C interrupt in microseconds
+#define EXT_REG_TWI_ISR_MAX 0x1E
+// TWI/I2C bus errors, NACKed bytes, general calls, completed reads and writes (see TwiStat)
+#define EXT_REG_TWI_BUS_ERRORS 0x20
+#define EXT_REG_TWI_NACKS 0x22
+#define EXT_REG_TWI_GENERAL_CALLS 0x24
+#define EXT_REG_TWI_READS 0x26
+#define EXT_REG_TWI_WRITES 0x28
+
 /**
 Returns true in case splash string has been changed from external module.
 @result true in case splash string has been changed and needs to be updated
@@ -28,6 +28,8 @@
 #ifndef _TESTS_ENV
 #include <avr/io.h>
 #include <util/delay.h>
+#else
+#include "LiquidCrystalEmulator.h"
 #endif
 
 #include "config.h"
@@ -143,9 +145,11 @@ void lcdInit(uint8_t lcdCols, uint8_t lcdRows, uint8_t charSize) {
 }
 
 void lcdBegin(void) {
+#ifndef _TESTS_ENV
 	// Use all pins of port (from config.h) and reset them to 0
 	LCD_DDR = 0xFF;
 	LCD_PORT = 0x00;
+#endif
 	_displayFunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
 
 	if (_rows > 1) {
@@ -197,12 +201,6 @@ void lcdClear() {
 	lcdCommand(LCD_CLEARDISPLAY);// clear display, set cursor position to zero
 	_spaceToEndOfTheLine = _cols;
 	_delay_ms(2);  // this command takes a long time!
-
-#ifdef _TESTS_ENV
-	for (int i = 0; i < LCD_COLS * LCD_ROWS; i++) {
-		_lcdTestBuff[i] = 0;
-	}
-#endif
 }
 
 void lcdHome() {
@@ -294,9 +292,6 @@ void lcdSetCursor(uint8_t col, uint8_t row) {
 	}
 	lcdCommand(LCD_SETDDRAMADDR | (col + row_offsets[row]));
 	_spaceToEndOfTheLine = _cols - col;
-#ifdef _TESTS_ENV
-	_lcdCurrentPos = col + row * _cols; 
-#endif
 }
 
 void lcdBlinkOn() {
@@ -333,20 +328,24 @@ void lcdPrint(const char *str) {
 	}
 }
 
+void lcdPrintP(const char *str) {
+	uint8_t c;
+	while ((c = pgm_read_byte(str++)) != '\0') {
+		lcdWrite(c);
+	}
+}
+
 // mid level commands, for sending data/cmds
 void lcdCommand(uint8_t value) {
-#ifndef _TESTS_ENV
 	lcdSend(value, 0);
-#endif
 }
 
 void lcdWrite(uint8_t value) {
-#ifndef _TESTS_ENV
 	lcdSend(value, Rs);
-	_spaceToEndOfTheLine--;
-#else
-	_lcdTestBuff[_lcdCurrentPos++] = value;
-#endif
+	// strings longer than the visible line are written into invisible part of DDRAM
+	if (_spaceToEndOfTheLine > 0) {
+		_spaceToEndOfTheLine--;
+	}
 }
 
 // low level data pushing commands
@@ -371,12 +370,20 @@ void lcdPortWriteAndEnable(uint8_t data) {
 
 #ifndef KMSG_ATB
 void lcdPortWrite(uint8_t data) {
+#ifndef _TESTS_ENV
 	LCD_PORT = data | _backlightVal;
+#else
+	lcdEmuPortWrite(data | _backlightVal);
+#endif
 }
 #else
 void lcdPortWrite(uint8_t data) {
         uint8_t newData = (data & 0xF0) >> 1;
         newData |= data &0x0F;
+#ifndef _TESTS_ENV
         LCD_PORT = newData | _backlightVal;
+#else
+        lcdEmuPortWrite(newData | _backlightVal);
+#endif
 }
 #endif
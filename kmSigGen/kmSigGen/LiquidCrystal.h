@@ -46,7 +46,15 @@
 
 #include <stdbool.h>
 #include <stdint.h>
-
+#ifndef _TESTS_ENV
+#include <avr/pgmspace.h>
+#else
+// flash is addressed as regular memory on the host
+#include <string.h>
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define memcpy_P memcpy
+#endif
 
 #ifndef LIQUIDCRYSTAL_H_
 #define LIQUIDCRYSTAL_H_
@@ -219,4 +227,10 @@ Print string from the character array
 */
 void lcdPrint(const char *str);
 
+/**
+Print string stored in the program memory (declared with PROGMEM)
+@param str - string to be printed
+*/
+void lcdPrintP(const char *str);
+
 #endif /* LIQUIDCRYSTAL_H_ */
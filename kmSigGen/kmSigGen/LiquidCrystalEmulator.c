@@ -0,0 +1,306 @@
+/*
+ * LiquidCrystalEmulator.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifdef _TESTS_ENV
+
+#include "config.h"
+#include "LiquidCrystalEmulator.h"
+
+// port bits as wired in LiquidCrystal.c (see lcdPortWrite)
+#define LCD_EMU_RS 0x01
+#define LCD_EMU_RW 0x02
+#define LCD_EMU_EN 0x04
+#ifndef KMSG_ATB
+#define LCD_EMU_BACKLIGHT 0x08
+#define LCD_EMU_DATA(X) (((X) >> 4) & 0x0F)
+#else
+#define LCD_EMU_BACKLIGHT 0x80
+#define LCD_EMU_DATA(X) (((X) >> 3) & 0x0F)
+#endif
+
+// execution times of the instructions (fosc = 270kHz)
+#define LCD_EMU_EXEC_US 37
+#define LCD_EMU_EXEC_LONG_US 1520
+
+#define LCD_EMU_LINE_LENGTH 40
+#define LCD_EMU_LINE2_ADDR 0x40
+
+static uint8_t _emuDdram[LCD_EMU_DDRAM_SIZE_OF];
+static uint8_t _emuCgram[LCD_EMU_CGRAM_SIZE_OF];
+static uint8_t _emuAddressCounter = 0;
+static bool _emuCgramMode = false;
+static uint8_t _emuShift = 0;
+static uint8_t _emuEntryMode = 0;
+static uint8_t _emuDisplayControl = 0;
+static bool _emuInterface8Bit = true;
+static bool _emuTwoLines = false;
+static bool _emuHighNibble = true;
+static uint8_t _emuByte = 0;
+static uint8_t _emuPort = 0;
+static uint32_t _emuTimeUs = 0;
+static uint32_t _emuBusyUntilUs = 0;
+static LcdEmuStats _emuStats;
+
+// Private functions
+uint8_t lcdEmuDdramIndex(uint8_t address);
+void lcdEmuMoveAddressCounter(bool increment);
+void lcdEmuShiftDisplay(bool left);
+void lcdEmuInstruction(uint8_t value);
+void lcdEmuData(uint8_t value);
+void lcdEmuStrobe(uint8_t data);
+
+// Implementation
+uint8_t lcdEmuDdramIndex(uint8_t address) {
+	if (_emuTwoLines == true) {
+		uint8_t line = (address >= LCD_EMU_LINE2_ADDR) ? 1 : 0;
+		return line * LCD_EMU_LINE_LENGTH + (address & 0x3F) % LCD_EMU_LINE_LENGTH;
+	}
+	return address % LCD_EMU_DDRAM_SIZE_OF;
+}
+
+void lcdEmuMoveAddressCounter(bool increment) {
+	if (_emuCgramMode == true) {
+		_emuAddressCounter = (_emuAddressCounter + (increment ? 1 : -1)) & 0x3F;
+		return;
+	}
+	if (_emuTwoLines == true) {
+		// 0x00 - 0x27 and 0x40 - 0x67, wrapping from the end of one line to the other
+		if (increment == true) {
+			if (_emuAddressCounter == LCD_EMU_LINE_LENGTH - 1) {
+				_emuAddressCounter = LCD_EMU_LINE2_ADDR;
+			} else if (_emuAddressCounter == LCD_EMU_LINE2_ADDR + LCD_EMU_LINE_LENGTH - 1) {
+				_emuAddressCounter = 0x00;
+			} else {
+				_emuAddressCounter++;
+			}
+		} else {
+			if (_emuAddressCounter == 0x00) {
+				_emuAddressCounter = LCD_EMU_LINE2_ADDR + LCD_EMU_LINE_LENGTH - 1;
+			} else if (_emuAddressCounter == LCD_EMU_LINE2_ADDR) {
+				_emuAddressCounter = LCD_EMU_LINE_LENGTH - 1;
+			} else {
+				_emuAddressCounter--;
+			}
+		}
+	} else {
+		_emuAddressCounter = (_emuAddressCounter + (increment ? 1 : LCD_EMU_DDRAM_SIZE_OF - 1)) % LCD_EMU_DDRAM_SIZE_OF;
+	}
+}
+
+void lcdEmuShiftDisplay(bool left) {
+	// display window moves over the 40 character lines of both rows at once
+	if (left == true) {
+		_emuShift = (_emuShift + 1) % LCD_EMU_LINE_LENGTH;
+	} else {
+		_emuShift = (_emuShift + LCD_EMU_LINE_LENGTH - 1) % LCD_EMU_LINE_LENGTH;
+	}
+}
+
+void lcdEmuInstruction(uint8_t value) {
+	uint32_t execUs = LCD_EMU_EXEC_US;
+	_emuStats.commands++;
+	if (value & 0x80) {
+		// set DDRAM address
+		_emuCgramMode = false;
+		_emuAddressCounter = value & 0x7F;
+	} else if (value & 0x40) {
+		// set CGRAM address
+		_emuCgramMode = true;
+		_emuAddressCounter = value & 0x3F;
+	} else if (value & 0x20) {
+		// function set
+		_emuInterface8Bit = ((value & 0x10) != 0);
+		_emuTwoLines = ((value & 0x08) != 0);
+		_emuHighNibble = true;
+	} else if (value & 0x10) {
+		// cursor or display shift
+		if (value & 0x08) {
+			lcdEmuShiftDisplay((value & 0x04) == 0);
+		} else {
+			lcdEmuMoveAddressCounter((value & 0x04) != 0);
+		}
+	} else if (value & 0x08) {
+		// display on/off control
+		_emuDisplayControl = value & 0x07;
+	} else if (value & 0x04) {
+		// entry mode set
+		_emuEntryMode = value & 0x03;
+	} else if (value & 0x02) {
+		// return home
+		_emuCgramMode = false;
+		_emuAddressCounter = 0;
+		_emuShift = 0;
+		execUs = LCD_EMU_EXEC_LONG_US;
+	} else if (value & 0x01) {
+		// clear display
+		for (uint8_t i = 0; i < LCD_EMU_DDRAM_SIZE_OF; i++) {
+			_emuDdram[i] = ' ';
+		}
+		_emuCgramMode = false;
+		_emuAddressCounter = 0;
+		_emuShift = 0;
+		_emuEntryMode |= 0x02;
+		execUs = LCD_EMU_EXEC_LONG_US;
+	}
+	_emuBusyUntilUs = _emuTimeUs + execUs;
+}
+
+void lcdEmuData(uint8_t value) {
+	_emuStats.dataWrites++;
+	bool increment = ((_emuEntryMode & 0x02) != 0);
+	if (_emuCgramMode == true) {
+		_emuCgram[_emuAddressCounter] = value & 0x1F;
+	} else {
+		_emuDdram[lcdEmuDdramIndex(_emuAddressCounter)] = value;
+		if ((_emuEntryMode & 0x01) != 0) {
+			// accompanies display shift, so cursor stays in place on the screen
+			lcdEmuShiftDisplay(increment);
+		}
+	}
+	lcdEmuMoveAddressCounter(increment);
+	_emuBusyUntilUs = _emuTimeUs + LCD_EMU_EXEC_US;
+}
+
+void lcdEmuStrobe(uint8_t data) {
+	_emuStats.nibbles++;
+	if ((data & LCD_EMU_RW) != 0) {
+		// read operations are not used by the driver
+		return;
+	}
+	if (_emuTimeUs < _emuBusyUntilUs) {
+		_emuStats.busyViolations++;
+	}
+	uint8_t nibble = LCD_EMU_DATA(data);
+	if (_emuInterface8Bit == true) {
+		// D0 - D3 are connected to GND
+		_emuByte = nibble << 4;
+	} else if (_emuHighNibble == true) {
+		_emuByte = nibble << 4;
+		_emuHighNibble = false;
+		return;
+	} else {
+		_emuByte |= nibble;
+		_emuHighNibble = true;
+	}
+	if ((data & LCD_EMU_RS) != 0) {
+		lcdEmuData(_emuByte);
+	} else {
+		lcdEmuInstruction(_emuByte);
+	}
+}
+
+void lcdEmuReset(void) {
+	for (uint8_t i = 0; i < LCD_EMU_DDRAM_SIZE_OF; i++) {
+		_emuDdram[i] = ' ';
+	}
+	for (uint8_t i = 0; i < LCD_EMU_CGRAM_SIZE_OF; i++) {
+		_emuCgram[i] = 0;
+	}
+	_emuAddressCounter = 0;
+	_emuCgramMode = false;
+	_emuShift = 0;
+	_emuEntryMode = 0x02;
+	_emuDisplayControl = 0;
+	_emuInterface8Bit = true;
+	_emuTwoLines = false;
+	_emuHighNibble = true;
+	_emuByte = 0;
+	_emuPort = 0;
+	_emuTimeUs = 0;
+	_emuBusyUntilUs = 0;
+	lcdEmuResetStats();
+}
+
+void lcdEmuPortWrite(uint8_t data) {
+	_emuStats.portWrites++;
+	// data is latched on the falling edge of EN
+	if ((_emuPort & LCD_EMU_EN) != 0 && (data & LCD_EMU_EN) == 0) {
+		lcdEmuStrobe(_emuPort);
+	}
+	_emuPort = data;
+}
+
+void lcdEmuDelayUs(uint32_t us) {
+	_emuTimeUs += us;
+	_emuStats.busTimeUs += us;
+}
+
+void lcdEmuResetStats(void) {
+	_emuStats.commands = 0;
+	_emuStats.dataWrites = 0;
+	_emuStats.nibbles = 0;
+	_emuStats.portWrites = 0;
+	_emuStats.busyViolations = 0;
+	_emuStats.busTimeUs = 0;
+}
+
+LcdEmuStats lcdEmuGetStats(void) {
+	return _emuStats;
+}
+
+uint8_t lcdEmuGetChar(uint8_t col, uint8_t row) {
+	uint8_t address = (col + _emuShift) % LCD_EMU_LINE_LENGTH;
+	if (row > 0) {
+		address += LCD_EMU_LINE2_ADDR;
+	}
+	return _emuDdram[lcdEmuDdramIndex(address)];
+}
+
+void lcdEmuGetLine(uint8_t row, char *buffer) {
+	for (uint8_t i = 0; i < LCD_COLS; i++) {
+		buffer[i] = lcdEmuGetChar(i, row);
+	}
+	buffer[LCD_COLS] = '\0';
+}
+
+uint8_t lcdEmuGetDdram(uint8_t address) {
+	return _emuDdram[lcdEmuDdramIndex(address)];
+}
+
+uint8_t lcdEmuGetCgram(uint8_t address) {
+	return _emuCgram[address & 0x3F];
+}
+
+uint8_t lcdEmuGetAddressCounter(void) {
+	return _emuAddressCounter;
+}
+
+uint8_t lcdEmuGetDisplayShift(void) {
+	return _emuShift;
+}
+
+uint8_t lcdEmuGetDisplayControl(void) {
+	return _emuDisplayControl;
+}
+
+uint8_t lcdEmuGetEntryMode(void) {
+	return _emuEntryMode;
+}
+
+bool lcdEmuIsBacklight(void) {
+	return ((_emuPort & LCD_EMU_BACKLIGHT) != 0);
+}
+
+#endif
@@ -0,0 +1,170 @@
+/** @file
+ * @brief Host-side HD44780 model fed from LiquidCrystal.c port writes.
+ * LiquidCrystalEmulator.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Available only in test environment (_TESTS_ENV defined). In such case
+ *  lcdPortWrite() passes every port value to lcdEmuPortWrite() instead of LCD_PORT,
+ *  so the complete nibble stream generated by LiquidCrystal.c is decoded by the model.
+ *  Delays used by the driver are accumulated as modeled bus time.
+ *  Example of the host build (with own driver calling lcd* and lcdEmu* functions):
+ *  gcc -D_TESTS_ENV LiquidCrystal.c LiquidCrystalEmulator.c driver.c
+ *
+ *  References:
+ * -# https://www.sparkfun.com/datasheets/LCD/HD44780.pdf
+ */
+
+#ifndef LIQUIDCRYSTALEMULATOR_H_
+#define LIQUIDCRYSTALEMULATOR_H_
+
+#ifdef _TESTS_ENV
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// host replacements of avr-libc definitions used by LiquidCrystal.c
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+#ifndef PIN0
+#define PIN0 0
+#define PIN1 1
+#define PIN2 2
+#define PIN3 3
+#define PIN7 7
+#endif
+#define _delay_us(us) lcdEmuDelayUs(us)
+#define _delay_ms(ms) lcdEmuDelayUs((ms) * 1000UL)
+
+// size of the display data RAM (2 lines of 40 characters)
+#define LCD_EMU_DDRAM_SIZE_OF 80
+// size of the character generator RAM (8 characters of 8 rows)
+#define LCD_EMU_CGRAM_SIZE_OF 64
+
+/**
+Display traffic statistics collected since last lcdEmuResetStats call.
+*/
+typedef struct {
+	/// instructions (RS = 0) received by the controller
+	uint32_t commands;
+	/// data bytes (RS = 1) received by the controller
+	uint32_t dataWrites;
+	/// 4 bit transfers (falling edges of EN line)
+	uint32_t nibbles;
+	/// writes to the LCD port
+	uint32_t portWrites;
+	/// instructions received while controller was still busy with previous one
+	uint32_t busyViolations;
+	/// bus time in microseconds, modeled as sum of delays issued by the driver
+	uint32_t busTimeUs;
+} LcdEmuStats;
+
+/**
+Resets the model to the power-on state (8 bit interface, empty DDRAM) and clears statistics.
+*/
+void lcdEmuReset(void);
+
+/**
+Consumes single value written to the LCD port by lcdPortWrite.
+@param data value of the port (D7-D4, backlight, EN, RW, RS)
+*/
+void lcdEmuPortWrite(uint8_t data);
+
+/**
+Advances modeled time, used as replacement of _delay_us and _delay_ms.
+@param us time in microseconds
+*/
+void lcdEmuDelayUs(uint32_t us);
+
+/**
+Clears statistics, to be called before UI operation which traffic is to be measured.
+*/
+void lcdEmuResetStats(void);
+
+/**
+Returns statistics collected since last lcdEmuResetStats call.
+@result display traffic statistics
+*/
+LcdEmuStats lcdEmuGetStats(void);
+
+/**
+Returns character visible at the given position of the display (display shift included).
+@param col column (X) position
+@param row row (Y) position
+@result character code
+*/
+uint8_t lcdEmuGetChar(uint8_t col, uint8_t row);
+
+/**
+Copies visible content of the row into buffer and terminates it with '\0'.
+@param row row (Y) position
+@result buffer at least LCD_COLS + 1 bytes long
+*/
+void lcdEmuGetLine(uint8_t row, char *buffer);
+
+/**
+Returns value of DDRAM at provided address (0x00 - 0x27 and 0x40 - 0x67 in 2 line mode).
+@param address DDRAM address
+@result character code
+*/
+uint8_t lcdEmuGetDdram(uint8_t address);
+
+/**
+Returns value of CGRAM at provided address (0x00 - 0x3F).
+@param address CGRAM address
+@result row of custom character
+*/
+uint8_t lcdEmuGetCgram(uint8_t address);
+
+/**
+Returns current value of the address counter (cursor position).
+@result address counter
+*/
+uint8_t lcdEmuGetAddressCounter(void);
+
+/**
+Returns number of positions the display window is shifted to the left (0 - 39).
+@result display shift
+*/
+uint8_t lcdEmuGetDisplayShift(void);
+
+/**
+Returns last display on/off control flags (D, C, B bits of the instruction).
+@result display control flags
+*/
+uint8_t lcdEmuGetDisplayControl(void);
+
+/**
+Returns last entry mode flags (I/D, S bits of the instruction).
+@result entry mode flags
+*/
+uint8_t lcdEmuGetEntryMode(void);
+
+/**
+Returns true in case back light of the display is enabled.
+@result back light state
+*/
+bool lcdEmuIsBacklight(void);
+
+#endif
+
+#endif /* LIQUIDCRYSTALEMULATOR_H_ */
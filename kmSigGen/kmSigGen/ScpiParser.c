@@ -0,0 +1,470 @@
+/*
+ * ScpiParser.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+// parser itself doesn't use hardware, so it's available also in test environment
+#if defined(KMSG_SCPI) || defined(_TESTS_ENV)
+#include <stdint.h>
+#include <stdbool.h>
+#ifndef _TESTS_ENV
+#include <avr/pgmspace.h>
+#elif !defined(PROGMEM)
+// flash is addressed as regular memory on the host (the same as in LiquidCrystal.h)
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+#include "ScpiParser.h"
+#include "SignalGeneratorAD9833.h"
+
+// frequency is parsed in 0.01Hz units, so it fits into 32 bits up to SG_MAX_FREQ
+#define SCPI_FREQ_SCALE 100UL
+#define SCPI_FREQ_SCALE_DIGITS 2
+#define SCPI_FREQ_COEF SG_DEC_COEF(SG_MCLK * SCPI_FREQ_SCALE, SG_FREQ_REG_BITS)
+#define SCPI_FREQ_MAX ((uint32_t)(SG_MAX_FREQ) * SCPI_FREQ_SCALE)
+// mantissa digits are accumulated while next one fits into 32 bits
+#define SCPI_MANTISSA_MAX 429496728UL
+#define SCPI_EXPONENT_MAX 99
+
+typedef enum {
+	SCPI_STATE_HEADER,
+	SCPI_STATE_ARGUMENT_WAIT,
+	SCPI_STATE_NUMBER,
+	SCPI_STATE_EXPONENT,
+	SCPI_STATE_UNIT,
+	SCPI_STATE_WORD,
+	SCPI_STATE_SKIP
+} ScpiState;
+
+// keywords, upper case part is the short form
+static const char _scpiStrFreq[] PROGMEM = "FREQuency";
+static const char _scpiStrFunc[] PROGMEM = "FUNCtion";
+static const char _scpiStrSweepStart[] PROGMEM = "SWEep:STARt";
+static const char _scpiStrIdn[] PROGMEM = "*IDN";
+static const char _scpiStrSine[] PROGMEM = "SINusoid";
+static const char _scpiStrSquare[] PROGMEM = "SQUare";
+static const char _scpiStrTriangle[] PROGMEM = "TRIangle";
+static const char _scpiStrHz[] PROGMEM = "HZ";
+static const char _scpiStrKHz[] PROGMEM = "KHZ";
+static const char _scpiStrMHz[] PROGMEM = "MHZ";
+static const char _scpiStrMaHz[] PROGMEM = "MAHZ";
+
+static ScpiState _scpiState = SCPI_STATE_HEADER;
+static ScpiCommand _scpiCommand = SCPI_NONE;
+static char _scpiWindow[SCPI_WINDOW_LENGTH];
+static uint8_t _scpiWindowLength = 0;
+static uint32_t _scpiMantissa = 0;
+static int8_t _scpiExponent = 0;
+static int8_t _scpiExponentPart = 0;
+static bool _scpiExponentNegative = false;
+static bool _scpiDot = false;
+static bool _scpiDigits = false;
+// argument is complete, only spaces may follow
+static bool _scpiTrailing = false;
+
+static uint32_t _scpiFreqReg = 0;
+static UIWaveType _scpiWaveType = UI_SIG_NONE;
+
+// private functions
+bool scpiIsLetter(char data);
+bool scpiIsDigit(char data);
+bool scpiIsSpace(char data);
+bool scpiPutWindow(char data);
+bool scpiMatch(const char *keyword);
+ScpiCommand scpiHeaderCommand(void);
+void scpiNumberStart(void);
+bool scpiNumber(char data);
+bool scpiUnitExponent(int8_t *exponent);
+ScpiCommand scpiComplete(void);
+
+// Implementation
+bool scpiIsLetter(char data) {
+	return (data >= 'A' && data <= 'Z') || (data >= 'a' && data <= 'z');
+}
+
+bool scpiIsDigit(char data) {
+	return (data >= '0' && data <= '9');
+}
+
+bool scpiIsSpace(char data) {
+	return (data == ' ' || data == '\t');
+}
+
+/*
+ * stores upper case character in the window
+ * @result false in case window is full
+ */
+bool scpiPutWindow(char data) {
+	if (_scpiWindowLength >= SCPI_WINDOW_LENGTH) {
+		return false;
+	}
+	if (data >= 'a' && data <= 'z') {
+		data -= 'a' - 'A';
+	}
+	_scpiWindow[_scpiWindowLength++] = data;
+	return true;
+}
+
+/*
+ * compares the window with keyword from program memory, every node of the keyword
+ * (separated by ':') matches in short form (upper case part only) or in long form
+ */
+bool scpiMatch(const char *keyword) {
+	uint8_t i = 0;
+	char c = pgm_read_byte(keyword);
+	while (true) {
+		bool shortForm = true;
+		// compare single node
+		while (c != '\0' && c != ':') {
+			bool upper = (c >= 'A' && c <= 'Z') || c == '*';
+			if (i < _scpiWindowLength && _scpiWindow[i] != ':') {
+				char expected = upper ? c : c - ('a' - 'A');
+				if (_scpiWindow[i] != expected) {
+					return false;
+				}
+				i++;
+				if (upper == false) {
+					shortForm = false;
+				}
+			} else if (upper == false && shortForm == true) {
+				// node of the window ends together with the short form
+				do {
+					c = pgm_read_byte(++keyword);
+				} while (c >= 'a' && c <= 'z');
+				break;
+			} else {
+				return false;
+			}
+			c = pgm_read_byte(++keyword);
+		}
+		if (i < _scpiWindowLength && _scpiWindow[i] != ':') {
+			// window node is longer than the keyword node
+			return false;
+		}
+		if (c == '\0') {
+			return (i == _scpiWindowLength);
+		}
+		if (i >= _scpiWindowLength) {
+			return false;
+		}
+		// skip ':' in both
+		i++;
+		c = pgm_read_byte(++keyword);
+	}
+}
+
+ScpiCommand scpiHeaderCommand(void) {
+	bool query = false;
+	if (_scpiWindowLength > 0 && _scpiWindow[_scpiWindowLength - 1] == '?') {
+		query = true;
+		_scpiWindowLength--;
+	}
+	if (scpiMatch(_scpiStrFreq) == true) {
+		return (query == true) ? SCPI_FREQ_QUERY : SCPI_FREQ;
+	}
+	if (query == true) {
+		return (scpiMatch(_scpiStrIdn) == true) ? SCPI_IDN_QUERY : SCPI_ERROR;
+	}
+	if (scpiMatch(_scpiStrFunc) == true) {
+		return SCPI_FUNC;
+	}
+	if (scpiMatch(_scpiStrSweepStart) == true) {
+		return SCPI_SWEEP_START;
+	}
+	return SCPI_ERROR;
+}
+
+void scpiNumberStart(void) {
+	_scpiMantissa = 0;
+	_scpiExponent = 0;
+	_scpiExponentPart = 0;
+	_scpiExponentNegative = false;
+	_scpiDot = false;
+	_scpiDigits = false;
+}
+
+/*
+ * accumulates character of the mantissa, digits which don't fit into 32 bits
+ * only move the decimal exponent, which is limited to +/-SCPI_EXPONENT_MAX (values
+ * so small or so large are rounded to 0 or rejected anyway)
+ * @result false in case character is not part of the mantissa
+ */
+bool scpiNumber(char data) {
+	if (scpiIsDigit(data) == true) {
+		_scpiDigits = true;
+		if (_scpiMantissa <= SCPI_MANTISSA_MAX) {
+			_scpiMantissa = _scpiMantissa * 10 + (data - '0');
+			if (_scpiDot == true && _scpiExponent > -SCPI_EXPONENT_MAX) {
+				// leading zeros of the fraction are not limited by the mantissa
+				_scpiExponent--;
+			}
+		} else if (_scpiDot == false && _scpiExponent < SCPI_EXPONENT_MAX) {
+			_scpiExponent++;
+		}
+		return true;
+	}
+	if (data == '.' && _scpiDot == false) {
+		_scpiDot = true;
+		return true;
+	}
+	if (data == '+' && _scpiDigits == false && _scpiDot == false) {
+		return true;
+	}
+	return false;
+}
+
+/*
+ * decimal exponent of the unit stored in the window (no unit means Hz)
+ * @result false in case unit is unknown
+ */
+bool scpiUnitExponent(int8_t *exponent) {
+	if (_scpiWindowLength == 0 || scpiMatch(_scpiStrHz) == true) {
+		*exponent = 0;
+	} else if (scpiMatch(_scpiStrKHz) == true) {
+		*exponent = 3;
+	} else if (scpiMatch(_scpiStrMHz) == true || scpiMatch(_scpiStrMaHz) == true) {
+		// MHZ is megahertz for frequency (SCPI-99 7.6.3)
+		*exponent = 6;
+	} else {
+		return false;
+	}
+	return true;
+}
+
+/*
+ * completes the command at the end of line
+ */
+ScpiCommand scpiComplete(void) {
+	ScpiCommand command = _scpiCommand;
+	switch (_scpiState) {
+		case SCPI_STATE_HEADER : {
+			if (_scpiWindowLength == 0) {
+				// empty line
+				return SCPI_NONE;
+			}
+			command = scpiHeaderCommand();
+			// only these commands have no argument
+			if (command == SCPI_FREQ || command == SCPI_FUNC) {
+				command = SCPI_ERROR;
+			}
+			break;
+		}
+		case SCPI_STATE_ARGUMENT_WAIT : {
+			if (command == SCPI_FREQ || command == SCPI_FUNC) {
+				command = SCPI_ERROR;
+			}
+			break;
+		}
+		case SCPI_STATE_NUMBER :
+		case SCPI_STATE_EXPONENT :
+		case SCPI_STATE_UNIT : {
+			int8_t exponent;
+			if (_scpiDigits == false || scpiUnitExponent(&exponent) == false) {
+				command = SCPI_ERROR;
+				break;
+			}
+			int16_t total = _scpiExponent + exponent + SCPI_FREQ_SCALE_DIGITS
+					+ ((_scpiExponentNegative == true) ? -_scpiExponentPart : _scpiExponentPart);
+			uint32_t value = _scpiMantissa;
+			for (; total > 0 && value != 0; total--) {
+				if (value > SCPI_FREQ_MAX / 10) {
+					// far above SG_MAX_FREQ
+					value = UINT32_MAX;
+					break;
+				}
+				value *= 10;
+			}
+			for (; total < -1 && value != 0; total++) {
+				value /= 10;
+			}
+			if (total == -1) {
+				value = value / 10 + ((value % 10 >= 5) ? 1 : 0);
+			}
+			if (value > SCPI_FREQ_MAX) {
+				// frequency out of range is rejected, not limited
+				command = SCPI_ERROR;
+				break;
+			}
+			_scpiFreqReg = sgCalcFreqReg(value, SCPI_FREQ_COEF, SG_FREQ_REG_BITS);
+			break;
+		}
+		case SCPI_STATE_WORD : {
+			if (scpiMatch(_scpiStrSine) == true) {
+				_scpiWaveType = UI_SIG_SINE;
+			} else if (scpiMatch(_scpiStrSquare) == true) {
+				_scpiWaveType = UI_SIG_SQUARE;
+			} else if (scpiMatch(_scpiStrTriangle) == true) {
+				_scpiWaveType = UI_SIG_TRIANGLE;
+			} else {
+				command = SCPI_ERROR;
+			}
+			break;
+		}
+		case SCPI_STATE_SKIP : {
+			command = SCPI_ERROR;
+			break;
+		}
+	}
+	return command;
+}
+
+void scpiInit(void) {
+	_scpiState = SCPI_STATE_HEADER;
+	_scpiCommand = SCPI_NONE;
+	_scpiWindowLength = 0;
+	_scpiTrailing = false;
+}
+
+ScpiCommand scpiParse(char data) {
+	if (data == '\r') {
+		return SCPI_NONE;
+	}
+	if (data == '\n' || data == ';') {
+		ScpiCommand command = scpiComplete();
+		scpiInit();
+		return command;
+	}
+	if (_scpiTrailing == true) {
+		if (scpiIsSpace(data) == false) {
+			_scpiState = SCPI_STATE_SKIP;
+		}
+		return SCPI_NONE;
+	}
+	switch (_scpiState) {
+		case SCPI_STATE_HEADER : {
+			if (scpiIsSpace(data) == true) {
+				if (_scpiWindowLength > 0) {
+					_scpiCommand = scpiHeaderCommand();
+					_scpiWindowLength = 0;
+					_scpiState = (_scpiCommand == SCPI_ERROR) ? SCPI_STATE_SKIP : SCPI_STATE_ARGUMENT_WAIT;
+				}
+			} else if ((scpiIsLetter(data) == false && data != '*' && data != ':' && data != '?')
+					|| scpiPutWindow(data) == false) {
+				_scpiState = SCPI_STATE_SKIP;
+			}
+			break;
+		}
+		case SCPI_STATE_ARGUMENT_WAIT : {
+			if (scpiIsSpace(data) == true) {
+				break;
+			}
+			if (_scpiCommand == SCPI_FREQ) {
+				scpiNumberStart();
+				_scpiState = (scpiNumber(data) == true) ? SCPI_STATE_NUMBER : SCPI_STATE_SKIP;
+			} else if (_scpiCommand == SCPI_FUNC && scpiIsLetter(data) == true) {
+				scpiPutWindow(data);
+				_scpiState = SCPI_STATE_WORD;
+			} else {
+				_scpiState = SCPI_STATE_SKIP;
+			}
+			break;
+		}
+		case SCPI_STATE_NUMBER : {
+			if (scpiNumber(data) == true) {
+				break;
+			}
+			if ((data == 'E' || data == 'e') && _scpiDigits == true) {
+				_scpiState = SCPI_STATE_EXPONENT;
+				_scpiExponentPart = 0;
+				break;
+			}
+			// fall through - character starts the unit
+		}
+		case SCPI_STATE_UNIT : {
+			if (scpiIsSpace(data) == true) {
+				// space allowed also between number and unit
+				if (_scpiWindowLength == 0) {
+					_scpiState = SCPI_STATE_UNIT;
+				} else {
+					_scpiTrailing = true;
+				}
+			} else if (scpiIsLetter(data) == true && scpiPutWindow(data) == true) {
+				_scpiState = SCPI_STATE_UNIT;
+			} else {
+				_scpiState = SCPI_STATE_SKIP;
+			}
+			break;
+		}
+		case SCPI_STATE_EXPONENT : {
+			if (data == '-' && _scpiExponentPart == 0 && _scpiExponentNegative == false) {
+				_scpiExponentNegative = true;
+			} else if (data == '+' && _scpiExponentPart == 0) {
+				// sign only
+			} else if (scpiIsDigit(data) == true && _scpiExponentPart * 10 + (data - '0') <= SCPI_EXPONENT_MAX) {
+				_scpiExponentPart = _scpiExponentPart * 10 + (data - '0');
+			} else if (scpiIsLetter(data) == true || scpiIsSpace(data) == true) {
+				_scpiState = SCPI_STATE_UNIT;
+				if (scpiIsLetter(data) == true) {
+					scpiPutWindow(data);
+				}
+			} else {
+				_scpiState = SCPI_STATE_SKIP;
+			}
+			break;
+		}
+		case SCPI_STATE_WORD : {
+			if (scpiIsSpace(data) == true) {
+				_scpiTrailing = true;
+			} else if (scpiIsLetter(data) == false || scpiPutWindow(data) == false) {
+				_scpiState = SCPI_STATE_SKIP;
+			}
+			break;
+		}
+		case SCPI_STATE_SKIP : {
+			// rest of the command is ignored, error is reported at its end
+			break;
+		}
+	}
+	return SCPI_NONE;
+}
+
+uint32_t scpiGetFreqReg(void) {
+	return _scpiFreqReg;
+}
+
+UIWaveType scpiGetWaveType(void) {
+	return _scpiWaveType;
+}
+
+void scpiFreqRegToStr(char *buffer, uint32_t freqReg) {
+	uint32_t value = sgCalcDec(freqReg, SCPI_FREQ_COEF, SG_FREQ_REG_BITS);
+	char digits[SCPI_FREQ_STR_LENGTH];
+	uint8_t length = 0;
+	// at least one digit before the dot
+	do {
+		digits[length++] = '0' + value % 10;
+		value /= 10;
+	} while (value != 0 || length <= SCPI_FREQ_SCALE_DIGITS);
+	while (length > 0) {
+		*buffer++ = digits[--length];
+		if (length == SCPI_FREQ_SCALE_DIGITS) {
+			*buffer++ = '.';
+		}
+	}
+	*buffer = '\0';
+}
+
+#endif
@@ -0,0 +1,101 @@
+/** @file
+ * @brief Streaming parser of SCPI subset for bench control over byte stream.
+ * ScpiParser.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Supported commands (keywords in short or long form, case insensitive, terminated with LF or ';'):
+ *  - FREQuency <number>[HZ|KHZ|MHZ] - e.g. FREQ 1.8432MHZ, FREQ 440, FREQ 2.5E3HZ,
+ *    frequency above SG_MAX_FREQ is an error
+ *  - FREQuency? - frequency in Hz with 2 decimal places
+ *  - FUNCtion SINusoid|SQUare|TRIangle
+ *  - SWEep:STARt - starts playback of the frequency hopping table in loop
+ *  - *IDN? - identification string
+ *  Parser keeps only small fixed window (SCPI_WINDOW_LENGTH) of the current keyword,
+ *  numbers are converted on the fly with integer arithmetic.
+ *
+ *  References:
+ *  -# https://www.ivifoundation.org/downloads/SCPI/scpi-99.pdf
+ */
+
+#ifndef SCPIPARSER_H_
+#define SCPIPARSER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+#include "UserInterface.h"
+
+// longest keyword (with nodes separated by ':') or unit accepted by the parser
+#define SCPI_WINDOW_LENGTH 12
+// frequency returned by scpiFreqRegToStr (e.g. "12500000.00"), including '\0'
+#define SCPI_FREQ_STR_LENGTH 12
+
+// Commands recognized by the parser
+typedef enum {
+	/// Command is not complete yet (or line is empty)
+	SCPI_NONE = 0,
+	/// Unknown command or wrong argument (including frequency above SG_MAX_FREQ)
+	SCPI_ERROR,
+	/// Set frequency, see scpiGetFreqReg
+	SCPI_FREQ,
+	/// Query frequency
+	SCPI_FREQ_QUERY,
+	/// Set wave type, see scpiGetWaveType
+	SCPI_FUNC,
+	/// Start frequency sweep
+	SCPI_SWEEP_START,
+	/// Query identification
+	SCPI_IDN_QUERY
+} ScpiCommand;
+
+/**
+Resets the parser, so it waits for the beginning of the command.
+*/
+void scpiInit(void);
+
+/**
+Passes next byte of the stream to the parser.
+@param data received byte
+@result command completed with this byte (SCPI_NONE in case command is not complete yet)
+*/
+ScpiCommand scpiParse(char data);
+
+/**
+Returns argument of the last SCPI_FREQ command.
+@result 28bit value of the frequency register nearest to the requested frequency
+*/
+uint32_t scpiGetFreqReg(void);
+
+/**
+Returns argument of the last SCPI_FUNC command.
+@result wave type
+*/
+UIWaveType scpiGetWaveType(void);
+
+/**
+Converts frequency register to decimal string in Hz with 2 decimal places (e.g. "1843200.00").
+@param buffer at least SCPI_FREQ_STR_LENGTH bytes long
+@param freqReg 28bit value of frequency register
+*/
+void scpiFreqRegToStr(char *buffer, uint32_t freqReg);
+
+#endif /* SCPIPARSER_H_ */
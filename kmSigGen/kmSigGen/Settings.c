@@ -24,8 +24,14 @@
  */
 
 #ifndef _TESTS_ENV
+#include <avr/io.h>
 #include <avr/eeprom.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#else
+#include "EEPROMEmulator.h"
 #endif
+#include <stddef.h>
 #include <string.h>
 #include <stdbool.h>
 
@@ -34,68 +40,437 @@
 #include "Settings.h"
 #include "UserInterface.h"
 #include "SignalGeneratorAD9833.h"
+#include "StringTools.h"
+#include "TWISlave.h"
 
 #ifndef KMSG_NO_EEPROM
-static uint64_t EEMEM _EEPROMsettingsPresets[KMSG_MAX_PRESETS];
+#ifdef KMSG_EEPROM_JOURNAL
+// identifiers of the journal records, presets 0 to KMSG_MAX_PRESETS - 1 followed by TWI/I2C address
+#define SETTINGS_ID_TWI_ADDRESS KMSG_MAX_PRESETS
+#define SETTINGS_IDS (KMSG_MAX_PRESETS + 1)
+#define SETTINGS_NO_SLOT 0xFF
+#define SETTINGS_NO_ID 0xFF
+#define SETTINGS_RECORD_SIZE 8
+// value not saved for that many records is copied forward, so sequence numbers of all
+// records in the journal stay within half of their range and can be compared
+#define SETTINGS_MAX_AGE 0x4000
+#if KMSG_JOURNAL_RECORDS <= SETTINGS_IDS || KMSG_JOURNAL_RECORDS >= SETTINGS_NO_SLOT
+#error "KMSG_JOURNAL_RECORDS has to be greater than KMSG_MAX_PRESETS + 1 and less than 255"
+#endif
+#if KMSG_JOURNAL_RECORDS * SETTINGS_RECORD_SIZE + KMSG_MAX_PRESETS * 4 + KMSG_MAGIC_LENGTH + 2 > E2END + 1
+#error "KMSG_JOURNAL_RECORDS too big for EEPROM"
+#endif
+// indices of the write queue are free running and masked on access
+#define SETTINGS_QUEUE_MASK (KMSG_EEPROM_QUEUE - 1)
+#if (KMSG_EEPROM_QUEUE & SETTINGS_QUEUE_MASK) != 0 || KMSG_EEPROM_QUEUE > 128
+#error "KMSG_EEPROM_QUEUE has to be power of two (up to 128)"
+#endif
+// bytes written for every record: identifier invalidated, value and sequence number, CRC-8, identifier
+#define SETTINGS_WRITE_STEPS (offsetof(SettingsRecord, id) + 3)
+#ifndef _TESTS_ENV
+#define SETTINGS_EE_ADDRESS(pointer) ((uint16_t)(pointer))
+#else
+#define SETTINGS_EE_ADDRESS(pointer) eeEmuGetAddress(pointer)
+#endif
+
+/**
+Record of the settings journal, CRC-8 covers all bytes before it.
+*/
+typedef struct {
+	uint32_t value;
+	uint16_t sequence;
+	uint8_t id;
+	uint8_t crc;
+} SettingsRecord;
+
+/**
+Record waiting in RAM for write to the slot of the journal.
+*/
+typedef struct {
+	SettingsRecord record;
+	uint8_t slot;
+} SettingsQueueEntry;
+#endif
+
+// presets and TWI/I2C address followed by its complement (erased or damaged cell is detected),
+// with KMSG_EEPROM_JOURNAL read only to fill empty journal
+static uint32_t EEMEM _EEPROMsettingsPresets[KMSG_MAX_PRESETS];
 static char EEMEM _EEPROMsettingsMagic[KMSG_MAGIC_LENGTH];
-static uint64_t _settingsPresets[KMSG_MAX_PRESETS];
+static uint8_t EEMEM _EEPROMsettingsTwiAddress[2];
+#ifdef KMSG_EEPROM_JOURNAL
+// append-only journal written as round robin buffer, slot is reused only when its record
+// is superseded by newer record of the same identifier
+static SettingsRecord EEMEM _EEPROMsettingsJournal[KMSG_JOURNAL_RECORDS];
+#endif
+
+static uint32_t _settingsPresets[KMSG_MAX_PRESETS];
+#ifndef KMSG_NO_TWI
+static uint8_t _settingsTwiAddress = 0;
+#endif
+#ifdef KMSG_EEPROM_JOURNAL
+// slot and sequence number of the latest record of every identifier
+static uint8_t _settingsSlots[SETTINGS_IDS];
+static uint16_t _settingsSequences[SETTINGS_IDS];
+// slot and sequence number of the next record
+static uint8_t _settingsHead = 0;
+static uint16_t _settingsSequence = 0;
+// records written from EE_RDY interrupt, values are already in RAM so reads don't wait for them
+static SettingsQueueEntry _settingsQueue[KMSG_EEPROM_QUEUE];
+static volatile uint8_t _settingsQueueHead = 0;
+static volatile uint8_t _settingsQueueTail = 0;
+static volatile uint8_t _settingsQueueStep = 0;
+#endif
 
 // Private functions
-uint64_t combineWaveTypeAndFrequency(SgWaveType waveType, uint64_t frequency);
-void splitWaveTypeAndFrequency(uint64_t presetValue, UIWaveType *waveType, uint64_t *frequency);
+uint32_t combineWaveTypeAndFreqReg(UIWaveType waveType, uint32_t freqReg);
+void splitWaveTypeAndFreqReg(uint32_t presetValue, UIWaveType *waveType, uint32_t *freqReg);
+void settingsSetDefaults(void);
+#ifdef KMSG_EEPROM_JOURNAL
+uint8_t settingsRecordCrc(const SettingsRecord *record);
+void settingsSetValue(uint8_t id, uint32_t value);
+uint32_t settingsGetValue(uint8_t id);
+bool settingsIsLiveSlot(uint8_t slot);
+void settingsWriteNext(void);
+void settingsQueueRecord(uint8_t slot, const SettingsRecord *record);
+void settingsAppend(uint8_t id, uint32_t value);
+void settingsSave(uint8_t id, uint32_t value);
+void settingsImport(void);
+#endif
 
 // Implementation
-uint64_t combineWaveTypeAndFrequency(SgWaveType waveType, uint64_t frequency) {
-	uint64_t result = (uint64_t)waveType;
-	// wave type stored in MSB 8 bits out of 64bit value
-	result <<= 56;
-	result |= frequency;
-	return result;
+uint32_t combineWaveTypeAndFreqReg(UIWaveType waveType, uint32_t freqReg) {
+	// wave type stored in MSB 4 bits above 28bit frequency register
+	return ((uint32_t)waveType << SG_FREQ_REG_BITS) | (freqReg & SG_FREQ_REG_MASK);
+}
+
+void splitWaveTypeAndFreqReg(uint32_t presetValue, UIWaveType *waveType, uint32_t *freqReg) {
+	// wave type stored in MSB 4 bits above 28bit frequency register
+	*waveType = (UIWaveType)(presetValue >> SG_FREQ_REG_BITS);
+	*freqReg = presetValue & SG_FREQ_REG_MASK;
+}
+
+/*
+ * Function settingsSetDefaults
+ * Desc     sets default presets in RAM, TWI/I2C address isn't set
+ * Input    none
+ * Output   none
+ */
+void settingsSetDefaults(void) {
+	_settingsPresets[0] = combineWaveTypeAndFreqReg(DEFAULT_WAVE_TYPE, SG_FREQ_REG(DEFAULT_FREQUENCY));
+	_settingsPresets[1] = combineWaveTypeAndFreqReg(DEFAULT_WAVE_TYPE_PRESET1, SG_FREQ_REG(DEFAULT_FREQUENCY_PRESET1));
+	_settingsPresets[2] = combineWaveTypeAndFreqReg(DEFAULT_WAVE_TYPE_PRESET2, SG_FREQ_REG(DEFAULT_FREQUENCY_PRESET2));
+	_settingsPresets[3] = combineWaveTypeAndFreqReg(DEFAULT_WAVE_TYPE_PRESET3, SG_FREQ_REG(DEFAULT_FREQUENCY_PRESET3));
+	_settingsPresets[4] = combineWaveTypeAndFreqReg(DEFAULT_WAVE_TYPE_PRESET4, SG_FREQ_REG(DEFAULT_FREQUENCY_PRESET4));
+#ifndef KMSG_NO_TWI
+	_settingsTwiAddress = 0;
+#endif
+}
+
+#ifdef KMSG_EEPROM_JOURNAL
+/*
+ * Function settingsRecordCrc
+ * Desc     calculates CRC-8 of the record (value, sequence number and identifier)
+ * Input    record: record of the journal
+ * Output   CRC-8 of the record
+ */
+uint8_t settingsRecordCrc(const SettingsRecord *record) {
+	uint8_t crc = 0;
+	for (uint8_t i = 0; i < offsetof(SettingsRecord, crc); i++) {
+		crc = strCrc8(crc, ((const uint8_t *)record)[i]);
+	}
+	return crc;
+}
+
+/*
+ * Function settingsSetValue
+ * Desc     stores value of the record in RAM
+ * Input    id: identifier of the record
+ *          value: value of the record
+ * Output   none
+ */
+void settingsSetValue(uint8_t id, uint32_t value) {
+	if (id < KMSG_MAX_PRESETS) {
+		_settingsPresets[id] = value;
+	}
+#ifndef KMSG_NO_TWI
+	if (id == SETTINGS_ID_TWI_ADDRESS && value >= TWI_ADDRESS_MIN && value <= TWI_ADDRESS_MAX) {
+		_settingsTwiAddress = value;
+	}
+#endif
+}
+
+/*
+ * Function settingsGetValue
+ * Desc     returns value of the record kept in RAM
+ * Input    id: identifier of the record
+ * Output   value of the record
+ */
+uint32_t settingsGetValue(uint8_t id) {
+	if (id < KMSG_MAX_PRESETS) {
+		return _settingsPresets[id];
+	}
+#ifndef KMSG_NO_TWI
+	return _settingsTwiAddress;
+#else
+	return 0;
+#endif
+}
+
+/*
+ * Function settingsIsLiveSlot
+ * Desc     checks if slot holds the latest record of any identifier
+ * Input    slot: slot of the journal
+ * Output   true in case slot can't be overwritten
+ */
+bool settingsIsLiveSlot(uint8_t slot) {
+	for (uint8_t id = 0; id < SETTINGS_IDS; id++) {
+		if (_settingsSlots[id] == slot) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ * Function settingsWriteNext
+ * Desc     starts write of the next byte of the oldest queued record, identifier is invalidated first
+ *          and written last, so interrupted write leaves invalid record instead of new bytes mixed
+ *          with the old ones (CRC-8 alone could accept such record)
+ *          has to be called with interrupts disabled, EEPROM ready and the queue not empty
+ * Input    none
+ * Output   none
+ */
+void settingsWriteNext(void) {
+	SettingsQueueEntry *entry = &_settingsQueue[_settingsQueueTail & SETTINGS_QUEUE_MASK];
+	uint8_t step = _settingsQueueStep;
+	uint8_t offset = step - 1;
+	if (step == 0 || step == SETTINGS_WRITE_STEPS - 1) {
+		offset = offsetof(SettingsRecord, id);
+	} else if (step == SETTINGS_WRITE_STEPS - 2) {
+		offset = offsetof(SettingsRecord, crc);
+	}
+	EEAR = SETTINGS_EE_ADDRESS(&_EEPROMsettingsJournal[entry->slot]) + offset;
+	EEDR = (step == 0) ? SETTINGS_NO_ID : ((const uint8_t *)&entry->record)[offset];
+	EECR |= _BV(EEMWE);
+	EECR |= _BV(EEWE);
+	if (++step == SETTINGS_WRITE_STEPS) {
+		step = 0;
+		_settingsQueueTail++;
+		if (_settingsQueueTail == _settingsQueueHead) {
+			EECR &= ~_BV(EERIE);
+		}
+	}
+	_settingsQueueStep = step;
+}
+
+/*
+ * Function settingsQueueRecord
+ * Desc     queues record for write to the slot of the journal, in case the queue is full waits
+ *          for the oldest record (writes it also with interrupts disabled, e.g. before sei() in main)
+ * Input    slot: slot of the journal
+ *          record: record to be written
+ * Output   none
+ */
+void settingsQueueRecord(uint8_t slot, const SettingsRecord *record) {
+	while ((uint8_t)(_settingsQueueHead - _settingsQueueTail) >= KMSG_EEPROM_QUEUE) {
+		eeprom_busy_wait();
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			if ((uint8_t)(_settingsQueueHead - _settingsQueueTail) >= KMSG_EEPROM_QUEUE && eeprom_is_ready()) {
+				settingsWriteNext();
+			}
+		}
+	}
+	SettingsQueueEntry *entry = &_settingsQueue[_settingsQueueHead & SETTINGS_QUEUE_MASK];
+	entry->record = *record;
+	entry->slot = slot;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_settingsQueueHead++;
+		EECR |= _BV(EERIE);
+	}
+}
+
+/*
+ * Function settingsAppend
+ * Desc     writes record to the next slot not holding the latest record of any identifier,
+ *          so the only copy of a value is never overwritten
+ * Input    id: identifier of the record
+ *          value: value of the record
+ * Output   none
+ */
+void settingsAppend(uint8_t id, uint32_t value) {
+	while (settingsIsLiveSlot(_settingsHead) == true) {
+		_settingsHead = (_settingsHead + 1) % KMSG_JOURNAL_RECORDS;
+	}
+	SettingsRecord record;
+	record.value = value;
+	record.sequence = _settingsSequence;
+	record.id = id;
+	record.crc = settingsRecordCrc(&record);
+	settingsQueueRecord(_settingsHead, &record);
+	_settingsSlots[id] = _settingsHead;
+	_settingsSequences[id] = _settingsSequence;
+	_settingsHead = (_settingsHead + 1) % KMSG_JOURNAL_RECORDS;
+	_settingsSequence++;
+}
+
+/*
+ * Function settingsSave
+ * Desc     appends record to the journal and copies forward records not saved for long
+ * Input    id: identifier of the record
+ *          value: value of the record
+ * Output   none
+ */
+void settingsSave(uint8_t id, uint32_t value) {
+	settingsSetValue(id, value);
+	settingsAppend(id, value);
+	for (uint8_t i = 0; i < SETTINGS_IDS; i++) {
+		if (_settingsSlots[i] != SETTINGS_NO_SLOT
+				&& (uint16_t)(_settingsSequence - _settingsSequences[i]) > SETTINGS_MAX_AGE) {
+			settingsAppend(i, settingsGetValue(i));
+		}
+	}
+}
+
+/*
+ * Function settingsImport
+ * Desc     fills empty journal with presets of the previous version (in case magic matches)
+ *          and TWI/I2C address stored with its complement
+ * Input    none
+ * Output   none
+ */
+void settingsImport(void) {
+	char settingsMagic[KMSG_MAGIC_LENGTH];
+	eeprom_read_block(&settingsMagic, &_EEPROMsettingsMagic, KMSG_MAGIC_LENGTH);
+	if (strncmp(settingsMagic, KMSG_MAGIC, KMSG_MAGIC_LENGTH) == 0) {
+		uint32_t presets[KMSG_MAX_PRESETS];
+		eeprom_read_block(&presets, &_EEPROMsettingsPresets, KMSG_MAX_PRESETS * sizeof(uint32_t));
+		for (uint8_t i = 0; i < KMSG_MAX_PRESETS; i++) {
+			settingsSave(i, presets[i]);
+		}
+	}
+	uint8_t twiAddress[2];
+	eeprom_read_block(&twiAddress, &_EEPROMsettingsTwiAddress, sizeof(twiAddress));
+	if ((uint8_t)(twiAddress[0] ^ twiAddress[1]) == 0xFF) {
+		settingsSave(SETTINGS_ID_TWI_ADDRESS, twiAddress[0]);
+	}
+}
+
+void settingsInit(void) {
+	settingsSetDefaults();
+	for (uint8_t id = 0; id < SETTINGS_IDS; id++) {
+		_settingsSlots[id] = SETTINGS_NO_SLOT;
+	}
+	_settingsQueueHead = 0;
+	_settingsQueueTail = 0;
+	_settingsQueueStep = 0;
+	// single pass over the journal, the latest valid record of every identifier is used
+	// (sequence numbers are compared modulo 2^16); erased, damaged or interrupted records are skipped
+	bool empty = true;
+	for (uint8_t slot = 0; slot < KMSG_JOURNAL_RECORDS; slot++) {
+		SettingsRecord record;
+		eeprom_read_block(&record, &_EEPROMsettingsJournal[slot], sizeof(SettingsRecord));
+		if (record.id >= SETTINGS_IDS || record.crc != settingsRecordCrc(&record)) {
+			continue;
+		}
+		if (_settingsSlots[record.id] == SETTINGS_NO_SLOT
+				|| (int16_t)(record.sequence - _settingsSequences[record.id]) > 0) {
+			_settingsSlots[record.id] = slot;
+			_settingsSequences[record.id] = record.sequence;
+			settingsSetValue(record.id, record.value);
+		}
+		// journal continues after the newest record
+		if (empty == true || (int16_t)(record.sequence - _settingsSequence) >= 0) {
+			_settingsHead = slot;
+			_settingsSequence = record.sequence;
+			empty = false;
+		}
+	}
+	if (empty == true) {
+		_settingsHead = 0;
+		_settingsSequence = 0;
+		settingsImport();
+	} else {
+		_settingsHead = (_settingsHead + 1) % KMSG_JOURNAL_RECORDS;
+		_settingsSequence++;
+	}
 }
 
-void splitWaveTypeAndFrequency(uint64_t presetValue, UIWaveType *waveType, uint64_t *frequency) {
-	// wave type stored in MSB 8 bits out of 64bit value
-	*waveType = (SgWaveType)((presetValue >> 56) & 0xFF);
-	*frequency = presetValue & 0x00FFFFFFFFFFFFFF;
+bool settingsIsWriteDone(void) {
+	return (_settingsQueueHead == _settingsQueueTail && eeprom_is_ready());
 }
 
+void settingsSavePreset(uint8_t presetNumber, UIWaveType waveType, uint32_t freqReg) {
+	uint32_t value = combineWaveTypeAndFreqReg(waveType, freqReg);
+	// unchanged value already in the journal isn't written again
+	if (_settingsSlots[presetNumber] == SETTINGS_NO_SLOT || _settingsPresets[presetNumber] != value) {
+		settingsSave(presetNumber, value);
+	}
+}
+#else
 void settingsInit(void) {
+	settingsSetDefaults();
 	char settingsMagic[KMSG_MAGIC_LENGTH];
 	eeprom_read_block(&settingsMagic, &_EEPROMsettingsMagic, KMSG_MAGIC_LENGTH);
 	if (strncmp(settingsMagic, KMSG_MAGIC, KMSG_MAGIC_LENGTH) == 0) {
 		// Settings Valid (have been written before) - read into memory
-		eeprom_read_block((void*)&_settingsPresets,
-				(const void*)&_EEPROMsettingsPresets,
-				KMSG_MAX_PRESETS * sizeof(uint64_t));
+		eeprom_read_block(&_settingsPresets, &_EEPROMsettingsPresets, KMSG_MAX_PRESETS * sizeof(uint32_t));
 	} else {
 		// Write initial settings
-		for (int i = 0; i < KMSG_MAX_PRESETS; i++) {
-			_settingsPresets[i] = 0;
-		}
-		_settingsPresets[0] = combineWaveTypeAndFrequency(DEFAULT_WAVE_TYPE, DEFAULT_FREQUENCY);
-		_settingsPresets[1] = combineWaveTypeAndFrequency(DEFAULT_WAVE_TYPE_PRESET1, DEFAULT_FREQUENCY_PRESET1);
-		_settingsPresets[2] = combineWaveTypeAndFrequency(DEFAULT_WAVE_TYPE_PRESET2, DEFAULT_FREQUENCY_PRESET2);
-		_settingsPresets[3] = combineWaveTypeAndFrequency(DEFAULT_WAVE_TYPE_PRESET3, DEFAULT_FREQUENCY_PRESET3);
-		_settingsPresets[4] = combineWaveTypeAndFrequency(DEFAULT_WAVE_TYPE_PRESET4, DEFAULT_FREQUENCY_PRESET4);
-		eeprom_write_block(KMSG_MAGIC,
-							&_EEPROMsettingsMagic,
-							KMSG_MAGIC_LENGTH);
-		eeprom_write_block(&_settingsPresets,
-							&_EEPROMsettingsPresets,
-							KMSG_MAX_PRESETS * sizeof(uint64_t));
+		eeprom_write_block(KMSG_MAGIC, &_EEPROMsettingsMagic, KMSG_MAGIC_LENGTH);
+		eeprom_write_block(&_settingsPresets, &_EEPROMsettingsPresets, KMSG_MAX_PRESETS * sizeof(uint32_t));
+	}
+#ifndef KMSG_NO_TWI
+	uint8_t twiAddress[2];
+	eeprom_read_block(&twiAddress, &_EEPROMsettingsTwiAddress, sizeof(twiAddress));
+	if ((uint8_t)(twiAddress[0] ^ twiAddress[1]) == 0xFF
+			&& twiAddress[0] >= TWI_ADDRESS_MIN && twiAddress[0] <= TWI_ADDRESS_MAX) {
+		_settingsTwiAddress = twiAddress[0];
 	}
+#endif
+}
+
+bool settingsIsWriteDone(void) {
+	return eeprom_is_ready();
+}
+
+void settingsSavePreset(uint8_t presetNumber, UIWaveType waveType, uint32_t freqReg) {
+	_settingsPresets[presetNumber] = combineWaveTypeAndFreqReg(waveType, freqReg);
+	eeprom_write_block(&_settingsPresets[presetNumber], &_EEPROMsettingsPresets[presetNumber], sizeof(uint32_t));
+}
+#endif
+
+void settingsGetPreset(uint8_t presetNumber, UIWaveType *waveType, uint32_t *freqReg) {
+	splitWaveTypeAndFreqReg(_settingsPresets[presetNumber], waveType, freqReg);
 }
 
-void settingsSavePreset(uint8_t presetNumber, UIWaveType waveType, uint64_t frequency) {
-	_settingsPresets[presetNumber] = combineWaveTypeAndFrequency(waveType, frequency);
-	eeprom_write_block(	&_settingsPresets[presetNumber],
-						&_EEPROMsettingsPresets[presetNumber],
-						sizeof(uint64_t));
+#ifndef KMSG_NO_TWI
+bool settingsIsTwiAddressSet(void) {
+	return (_settingsTwiAddress != 0);
 }
 
-void settingsGetPreset(uint8_t presetNumber, UIWaveType *waveType, uint64_t *frequency) {
-	splitWaveTypeAndFrequency(_settingsPresets[presetNumber], waveType, frequency);
+uint8_t settingsGetTwiAddress(void) {
+	return (_settingsTwiAddress != 0) ? _settingsTwiAddress : TWI_SLAVE_ADDRESS;
 }
+
+void settingsSaveTwiAddress(uint8_t address) {
+	if (address == _settingsTwiAddress) {
+		return;
+	}
+#ifdef KMSG_EEPROM_JOURNAL
+	settingsSave(SETTINGS_ID_TWI_ADDRESS, address);
+#else
+	uint8_t twiAddress[2] = { address, (uint8_t)~address };
+	_settingsTwiAddress = address;
+	eeprom_write_block(&twiAddress, &_EEPROMsettingsTwiAddress, sizeof(twiAddress));
+#endif
+}
+#endif
+
+#ifdef KMSG_EEPROM_JOURNAL
+ISR(EE_RDY_vect) {
+	settingsWriteNext();
+}
+#endif
 #else
 // routines for version without EEPROM access
 
@@ -104,33 +479,43 @@ void settingsInit(void) {
 }
 
 // return default preset
-void settingsGetPreset(uint8_t presetNumber, UIWaveType *waveType, uint64_t *frequency) {
+void settingsGetPreset(uint8_t presetNumber, UIWaveType *waveType, uint32_t *freqReg) {
 	switch(presetNumber) {
 		case 1 : {
 			*waveType = DEFAULT_WAVE_TYPE_PRESET1;
-			*frequency = DEFAULT_FREQUENCY_PRESET1;
+			*freqReg = SG_FREQ_REG(DEFAULT_FREQUENCY_PRESET1);
 			break;
 		}
 		case 2 : {
 			*waveType = DEFAULT_WAVE_TYPE_PRESET2;
-			*frequency = DEFAULT_FREQUENCY_PRESET2;
+			*freqReg = SG_FREQ_REG(DEFAULT_FREQUENCY_PRESET2);
 			break;
 		}
 		case 3 : {
 			*waveType = DEFAULT_WAVE_TYPE_PRESET3;
-			*frequency = DEFAULT_FREQUENCY_PRESET3;
+			*freqReg = SG_FREQ_REG(DEFAULT_FREQUENCY_PRESET3);
 			break;
 		}
 		case 4 : {
 			*waveType = DEFAULT_WAVE_TYPE_PRESET4;
-			*frequency = DEFAULT_FREQUENCY_PRESET4;
+			*freqReg = SG_FREQ_REG(DEFAULT_FREQUENCY_PRESET4);
 			break;
 		}
 		default : {
 			*waveType = DEFAULT_WAVE_TYPE;
-			*frequency = DEFAULT_FREQUENCY;
+			*freqReg = SG_FREQ_REG(DEFAULT_FREQUENCY);
 			break;
 		}
 	}
 }
+
+#ifndef KMSG_NO_TWI
+bool settingsIsTwiAddressSet(void) {
+	return false;
+}
+
+uint8_t settingsGetTwiAddress(void) {
+	return TWI_SLAVE_ADDRESS;
+}
+#endif
 #endif
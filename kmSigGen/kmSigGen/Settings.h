@@ -30,6 +30,7 @@
 #define SETTINGS_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "UserInterface.h"
 
 /**
@@ -42,8 +43,16 @@ Following definitions to be set in config.h file @n
 #define \b DEFAULT_WAVE_TYPE UI_SIG_SQUARE default wave type of the signalr generator after power up of the system (e.g. UI_SIG_SQUARE)@n
 #define \b DEFAULT_FREQUENCY_PRESET1 to DEFAULT_FREQUENCY_PRESET1 default preset 1 to 4 of signal generator frequency (e.g. 985248000)@n
 #define \b DEFAULT_WAVE_TYPE_PRESET1 to DEFAULT_WAVE_TYPE_PRESET1 default wave type of preset 1 to 4 (e.g. UI_SIG_SQUARE)@n
+#define \b KMSG_EEPROM_JOURNAL keep presets and TWI/I2C address in the journal described below (optional)@n
+#define \b KMSG_JOURNAL_RECORDS number of 8 byte records of the EEPROM journal (e.g. 56)@n
+#define \b KMSG_EEPROM_QUEUE number of records waiting in RAM for write from EE_RDY interrupt, power of two (e.g. 4)@n
 NOTE: To preserve EEPROM settings make sure EESAVE fuse bit is correctly defined (EESAVE = 0)@n
-In this version once EEPROM is erased or has different magic value than defined in KMSG_MAGIC then values are overwritten with default presets 1 to 4
+Without KMSG_EEPROM_JOURNAL presets are read from EEPROM when it has magic value defined in KMSG_MAGIC,
+otherwise EEPROM is overwritten with default presets 1 to 4; TWI/I2C address is stored with its complement.@n
+With KMSG_EEPROM_JOURNAL presets and TWI/I2C address are kept in append-only journal of records with sequence number
+and CRC-8, the latest valid record of every preset is taken, so saves interrupted by power loss fall back to the previous value.
+In case journal is empty presets stored without the journal are imported when EEPROM has magic value defined in KMSG_MAGIC,
+otherwise default presets 1 to 4 are used (EEPROM is written only on the first save).
 */
 void settingsInit(void);
 
@@ -51,19 +60,53 @@ void settingsInit(void);
 Returns preset of presetNumber to waveType and frequency result variables.
 @param presetNumber number of preset to be returned (0 to KMSG_MAX_PRESETS)
 @result waveType UI wave type
-@result frequency frequency in Hz multiplied by 1000
+@result freqReg 28bit value of the frequency register
 NOTE: in case KMSG_NO_EEPROM is defined then values are not taken from EEPROM but just from predefined default presets
 */
-void settingsGetPreset(uint8_t presetNumber, UIWaveType *waveType, uint64_t *frequency);
+void settingsGetPreset(uint8_t presetNumber, UIWaveType *waveType, uint32_t *freqReg);
+
+#ifndef KMSG_NO_TWI
+/**
+Returns TWI/I2C address stored in EEPROM, it's independent of KMSG_MAGIC so it survives
+update of the firmware.
+@result stored address or TWI_SLAVE_ADDRESS in case no valid address has been stored
+NOTE: in case KMSG_NO_EEPROM is defined then TWI_SLAVE_ADDRESS is always returned
+*/
+uint8_t settingsGetTwiAddress(void);
+
+/**
+Checks if TWI/I2C address has been stored in EEPROM (e.g. to run address assignment at first boot).
+@result true in case valid address is stored
+*/
+bool settingsIsTwiAddressSet(void);
+#endif
 
 #ifndef KMSG_NO_EEPROM
 /**
-Stores preset of presetNumbre to EEPROM.
+Stores preset of presetNumbre to EEPROM. With KMSG_EEPROM_JOURNAL write is done in background from EE_RDY
+interrupt (once global interrupts are enabled), function waits only when KMSG_EEPROM_QUEUE records are already
+queued, otherwise it waits for the previous write and the last byte is written in background.
+The preset is returned by settingsGetPreset right away.
 @param presetNumber number of preset to be saved (0 to KMSG_MAX_PRESETS)
 @param waveType UI wave type
-@param frequency frequency in Hz multiplied by 1000
+@param freqReg 28bit value of the frequency register
 */
-void settingsSavePreset(uint8_t presetNumber, UIWaveType waveType, uint64_t frequency);
+void settingsSavePreset(uint8_t presetNumber, UIWaveType waveType, uint32_t freqReg);
+
+/**
+Checks if all saved settings are written to EEPROM (e.g. before the power can be switched off).
+@result true in case no write is queued or in progress
+*/
+bool settingsIsWriteDone(void);
+
+#ifndef KMSG_NO_TWI
+/**
+Stores TWI/I2C address to EEPROM (EEPROM is written only if the address is changed), the same
+way as settingsSavePreset it doesn't wait for the write.
+@param address TWI address (TWI_ADDRESS_MIN to TWI_ADDRESS_MAX)
+*/
+void settingsSaveTwiAddress(uint8_t address);
+#endif
 #endif
 
 #endif /* SETTINGS_H_ */
@@ -25,6 +25,8 @@
 
 #ifndef _TESTS_ENV
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
 #include <util/delay.h>
 #endif
 #include "config.h"
@@ -152,26 +154,88 @@
 #define DIV64 	_BV(SPR1)
 #define DIV128	_BV(SPR0) | _BV(SPR1)
 #define DIV64_ALT 	_BV(SPR1) | _BV(SPR0) | _BV(SPR1)
+#define SPI_CTRL	_BV(SPE) | _BV(MSTR) | _BV(CPOL)
 
-static const uint64_t _calcFix = (((uint64_t)SG_MCLK * (uint64_t)SG_FREQ_COEF) >> AD9833_COEF_BIN) >> 1;
+// shadow of the control register settings, FSELECT is switched also by the hopping interrupt
+static volatile bool _sgFSelect = false;
+static bool _sgPSelect = false;
+static SgWaveType _sgWaveType = SG_SIG_NONE;
+// B28 and HLB may be cleared only by raw writes (sgWriteRaw)
+static bool _sgB28 = true;
+#ifdef KMSG_RAW_WORDS
+static bool _sgHlb = false;
+#endif
+// shadow of frequency and phase registers, indexed by FSELECT / PSELECT
+static uint32_t _sgFreqReg[2] = { 0, 0 };
+static uint16_t _sgPhaseReg[2] = { 0, 0 };
+// inactive frequency register holds value waiting for sgCommitStaged
+static volatile bool _sgStaged = false;
+
+#ifdef KMSG_HOP
+// Timer1 runs free with F_CPU / 8 clock (started in main), entries are switched on compare match
+#define SG_HOP_TICKS_PER_US (F_CPU / 8000000UL)
+// dwell times are converted with whole ticks per microsecond
+#if SG_HOP_TICKS_PER_US == 0 || (F_CPU % 8000000UL) != 0
+#error "KMSG_HOP requires F_CPU multiple of 8MHz"
+#endif
+#define SG_HOP_NO_ENTRY 0xFF
+
+/**
+Entry of the frequency hopping table.
+*/
+typedef struct {
+	uint32_t freqReg;
+	// dwell time in Timer1 ticks
+	uint16_t dwell;
+} SgHopEntry;
+
+static SgHopEntry _sgHopTable[KMSG_HOP_TABLE_LENGTH];
+static uint8_t _sgHopLength = 0;
+static volatile uint8_t _sgHopIndex = 0;
+static uint8_t _sgHopNext = SG_HOP_NO_ENTRY;
+static volatile bool _sgHopRunning = false;
+static bool _sgHopLoop = false;
+static volatile uint16_t _sgHopLatencyMin = UINT16_MAX;
+static volatile uint16_t _sgHopLatencyMax = 0;
+// SPI frame of the next compare match prepared in advance: control word selecting the register
+// preloaded with _sgHopNext, both halves of _sgHopAfter entry for the register being deselected
+static uint16_t _sgHopWords[3];
+static uint8_t _sgHopWordCount = 0;
+static uint8_t _sgHopAfter = SG_HOP_NO_ENTRY;
+static uint32_t _sgHopAfterFreqReg = 0;
+#endif
 
 // private functions
 void spiInit(void);
 void spiWriteWord(uint16_t word);
 void sgReset(void);
 uint16_t sgGetCtrlWaveType(SgWaveType waveType);
-void setFrequencyAndWaveType(uint32_t freqReg, SgWaveType waveType, bool fSelect);
+uint16_t sgGetCtrlWord(void);
+void sgWriteFreqReg(uint32_t freqReg, bool fSelect);
+#ifdef KMSG_RAW_WORDS
+void spiWriteWords(const uint16_t *words, uint8_t count);
+bool sgRawCheck(const uint16_t *words, uint8_t count);
+void sgRawControl(uint16_t word);
+void sgRawFreqReg(uint16_t word, bool fSelect, bool msb);
+#endif
+#ifdef KMSG_HOP
+void spiWriteFrame(const uint16_t *words, uint8_t count);
+uint8_t sgHopGetNext(uint8_t index);
+void sgHopPrepare(void);
+#endif
 
 // Implementation
 void spiInit(void) {
+#ifndef _TESTS_ENV
 	// set MOSI, SCK, SS' as out
 	SG_DDR |= _BV(SG_DD_MOSI) | _BV(SG_DD_SCK) | _BV(SG_DD_SS);
 	// enable SPI
 	// SPE	- SPI Enable
 	// MSTR	- Master / Slave Select
 	// DIV/SPRx	- SPI Clock Rate Select
-	SPCR = _BV(SPE) | _BV(MSTR) | _BV(CPOL) | DIV128;
+	SPCR = SPI_CTRL | DIV128;
 	// Set default MOSI port level to Low to avoid signal peaks in the middle of transmission
+#endif
 }
 
 void spiWriteWord(uint16_t word) {
@@ -189,8 +253,50 @@ void spiWriteWord(uint16_t word) {
 #endif
 }
 
+#ifdef KMSG_RAW_WORDS
+/*
+ * writes words in single frame, FSYNC is kept low for multiple of 16 SCLK pulses
+ */
+void spiWriteWords(const uint16_t *words, uint8_t count) {
+#ifndef _TESTS_ENV
+	SG_PORT &= ~_BV(SG_DD_SS);
+	_delay_us(DELAY_US_FSYNC);
+	for (uint8_t i = 0; i < count; i++) {
+		SPDR = (words[i] >> 8) & 0xff;
+		while( ! bit_is_set( SPSR, SPIF ) );
+		SPDR = words[i] & 0xff;
+		while( ! bit_is_set( SPSR, SPIF ) );
+	}
+	SG_PORT |= _BV(SG_DD_SS);
+#endif
+}
+#endif
+
+#ifdef KMSG_HOP
+/*
+ * Function spiWriteFrame
+ * Desc     writes words in single frame without waiting after FSYNC goes low (AD9833 needs
+ *          only 10ns, t7 in the datasheet), used by the hopping interrupt
+ * Input    words: words to be written
+ *          count: number of words
+ */
+void spiWriteFrame(const uint16_t *words, uint8_t count) {
+#ifndef _TESTS_ENV
+	SG_PORT &= ~_BV(SG_DD_SS);
+	for (uint8_t i = 0; i < count; i++) {
+		SPDR = (words[i] >> 8) & 0xff;
+		while( ! bit_is_set( SPSR, SPIF ) );
+		SPDR = words[i] & 0xff;
+		while( ! bit_is_set( SPSR, SPIF ) );
+	}
+	SG_PORT |= _BV(SG_DD_SS);
+#endif
+}
+#endif
+
 void sgReset(void) {
-	spiWriteWord(_BV(CTRL_RESET));
+	// B28 set once, so both halves of frequency register are always written together
+	spiWriteWord(_BV(CTLR_B28) | _BV(CTRL_RESET));
 }
 
 void sgInit(void) {
@@ -222,46 +328,378 @@ uint16_t sgGetCtrlWaveType(SgWaveType waveType) {
 	}
 }
 
-uint32_t sgCalcFreqReg(uint64_t freq) {
-  uint64_t result = freq;
-  result <<= AD9833_COEF_BIN;
-  result /= SG_MCLK;
-  result += _calcFix;
-  result /= SG_FREQ_COEF;
-  return (uint32_t)result;
+uint32_t sgCalcDec(uint32_t freqReg, uint32_t coef, uint8_t shift) {
+	// 64 bit product assembled from 16 bit halves, so only 32 bit multiplications are used
+	uint32_t productLo = (freqReg & 0xFFFF) * (coef & 0xFFFF);
+	uint32_t productHi = (freqReg >> 16) * (coef >> 16);
+	uint32_t productMid = (freqReg >> 16) * (coef & 0xFFFF);
+	uint32_t tmp = (freqReg & 0xFFFF) * (coef >> 16);
+	productMid += tmp;
+	if (productMid < tmp) {
+		productHi += 0x10000UL;
+	}
+	productHi += productMid >> 16;
+	tmp = productLo + (productMid << 16);
+	if (tmp < productLo) {
+		productHi++;
+	}
+	productLo = tmp;
+	if (shift == 0) {
+		return productLo;
+	}
+	// rounding to the nearest integer
+	tmp = productLo + (1UL << (shift - 1));
+	if (tmp < productLo) {
+		productHi++;
+	}
+	productLo = tmp;
+	if (shift >= 32) {
+		return productHi >> (shift - 32);
+	}
+	return (productLo >> shift) | (productHi << (32 - shift));
 }
 
-uint64_t sgCalcFreq(uint32_t freqReg) {
-  static const uint64_t calcCoef = (uint64_t)SG_MCLK * (uint64_t)SG_FREQ_COEF;
-  uint64_t result = calcCoef;
-  result *= (uint64_t)freqReg;
-  result >>= AD9833_COEF_BIN;
-  return (uint64_t)result;
+uint32_t sgCalcFreqReg(uint32_t dec, uint32_t coef, uint8_t shift) {
+	// single 64 bit division, used only when user applies frequency from the editor
+	uint32_t freqReg = (((uint64_t)dec << shift) + (coef >> 1)) / coef;
+	if (freqReg > SG_FREQ_REG_MAX) {
+		freqReg = SG_FREQ_REG_MAX;
+	}
+	return freqReg;
 }
 
-uint64_t sgCalcNearestFreq(uint64_t requestedFreq) {
-  return sgCalcFreq(sgCalcFreqReg(requestedFreq)) + _calcFix;
+/*
+ * control word for the current wave type and selected frequency register
+ */
+uint16_t sgGetCtrlWord(void) {
+	uint16_t word = _BV(CTLR_B28) | sgGetCtrlWaveType(_sgWaveType);
+	if (_sgFSelect == true) {
+		word |= _BV(CTLR_FSELECT);
+	}
+	if (_sgPSelect == true) {
+		word |= _BV(CTLR_PSELECT);
+	}
+	return word;
 }
 
 /*
+ * writes both halves of the frequency register (B28 has to be set in control register)
  * @param fSelect - 0 for FREQ0 register, 1 for FREQ1 register
  */
-void setFrequencyAndWaveType(uint32_t freqReg, SgWaveType waveType, bool fSelect) {
-	uint16_t word = _BV(CTLR_B28);
-	uint16_t regBits = WRITE_FREQ0;
-	if (fSelect == true) {
-		word |= _BV(CTLR_FSELECT); // not sure if it can be set while writing it
-		regBits = WRITE_FREQ1;
+void sgWriteFreqReg(uint32_t freqReg, bool fSelect) {
+	uint16_t regBits = (fSelect == true) ? WRITE_FREQ1 : WRITE_FREQ0;
+	if (_sgB28 == false) {
+		// B28 cleared by raw write is set back with current control settings
+		_sgB28 = true;
+		spiWriteWord(sgGetCtrlWord());
+	}
+	spiWriteWord((FREQ_LSB(freqReg)) | regBits);
+	spiWriteWord((FREQ_MSB(freqReg)) | regBits);
+	_sgFreqReg[fSelect] = freqReg;
+}
+
+#ifdef KMSG_RAW_WORDS
+/*
+ * checks that with B28 set every frequency register write is followed by its second half
+ * (same register, no control or phase word in between), so the register never waits for a half
+ * written later by setGeneratorParameters
+ */
+bool sgRawCheck(const uint16_t *words, uint8_t count) {
+	bool b28 = _sgB28;
+	uint8_t pending = 0; // register bits (WRITE_FREQ0 / WRITE_FREQ1) of the first half
+	for (uint8_t i = 0; i < count; i++) {
+		uint16_t regBits = words[i] & (_BV(REG_D15) | _BV(REG_D14));
+		if (pending != 0) {
+			// phase register bits never match WRITE_FREQ0 / WRITE_FREQ1 of the first half
+			if (pending != regBits >> 8) {
+				return false;
+			}
+			pending = 0;
+		} else if (regBits == 0) {
+			b28 = ((words[i] & _BV(CTLR_B28)) != 0);
+		} else if (regBits != (WRITE_PHASE0) && b28 == true) {
+			pending = regBits >> 8;
+		}
+	}
+	return (pending == 0);
+}
+
+/*
+ * follows control register write in the shadow, wave type decoded from RESET, OPBITEN and MODE bits
+ * (sleep modes are not followed, next control word written by firmware clears them)
+ */
+void sgRawControl(uint16_t word) {
+	_sgB28 = ((word & _BV(CTLR_B28)) != 0);
+	_sgHlb = ((word & _BV(CTLR_HLB)) != 0);
+	_sgFSelect = ((word & _BV(CTLR_FSELECT)) != 0);
+	_sgPSelect = ((word & _BV(CTLR_PSELECT)) != 0);
+	if ((word & _BV(CTRL_RESET)) != 0) {
+		_sgWaveType = SG_SIG_NONE;
+	} else if ((word & _BV(CTRL_OPBITEN)) != 0) {
+		_sgWaveType = SG_SIG_SQUARE;
+	} else if ((word & _BV(CTRL_MODE)) != 0) {
+		_sgWaveType = SG_SIG_TRIANGLE;
+	} else {
+		_sgWaveType = SG_SIG_SINE;
+	}
+}
+
+/*
+ * follows write of 14 bits to frequency register in the shadow
+ * @param msb - true for 14 MSBs, false for 14 LSBs
+ */
+void sgRawFreqReg(uint16_t word, bool fSelect, bool msb) {
+	if (msb == true) {
+		_sgFreqReg[fSelect] = ((uint32_t)FREQ_LSB(word) << 14) | FREQ_LSB(_sgFreqReg[fSelect]);
+	} else {
+		_sgFreqReg[fSelect] = (_sgFreqReg[fSelect] & ~0x3FFFUL) | FREQ_LSB(word);
+	}
+}
+
+bool sgWriteRaw(const uint16_t *words, uint8_t count) {
+	if (sgRawCheck(words, count) == false) {
+		return false;
+	}
+#ifdef KMSG_HOP
+	sgHopStop();
+#endif
+	// registers may be overwritten, so nothing is staged any more
+	_sgStaged = false;
+	spiWriteWords(words, count);
+	bool msbPending = false;
+	for (uint8_t i = 0; i < count; i++) {
+		uint16_t regBits = words[i] & (_BV(REG_D15) | _BV(REG_D14));
+		if (regBits == 0) {
+			sgRawControl(words[i]);
+		} else if (regBits == (WRITE_PHASE0)) {
+			_sgPhaseReg[(words[i] >> REG_D13) & 0x01] = words[i] & 0x0FFF;
+		} else {
+			// with B28 set LSBs are written first, MSBs in the next word
+			bool msb = (_sgB28 == true) ? msbPending : _sgHlb;
+			sgRawFreqReg(words[i], regBits == WRITE_FREQ1, msb);
+			msbPending = (_sgB28 == true && msb == false);
+		}
+	}
+	return true;
+}
+#endif
+
+uint32_t sgGetFreqReg(void) {
+	uint32_t result;
+	// register and its shadow are switched by the hopping interrupt
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result = _sgFreqReg[_sgFSelect];
+	}
+	return result;
+}
+
+SgWaveType sgGetWaveType(void) {
+	return _sgWaveType;
+}
+
+bool sgGetPSelect(void) {
+	return _sgPSelect;
+}
+
+uint16_t sgGetPhaseReg(void) {
+	return _sgPhaseReg[_sgPSelect];
+}
+
+void setGeneratorParameters(uint32_t freqReg, SgWaveType waveType) {
+#ifdef KMSG_HOP
+	// manual or external retune ends frequency hopping
+	sgHopStop();
+#endif
+	// staged value is overwritten
+	_sgStaged = false;
+	// new frequency is loaded into inactive register and selected together with the wave type,
+	// so output never has new wave type with old frequency
+	sgWriteFreqReg(freqReg, !_sgFSelect);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_sgFSelect = !_sgFSelect;
+	}
+	_sgWaveType = waveType;
+	spiWriteWord(sgGetCtrlWord());
+}
+
+bool sgGetFSelect(void) {
+	return _sgFSelect;
+}
+
+#ifdef TWI_GENERAL_CALL_COMMIT
+void sgStageFreqReg(uint32_t freqReg) {
+#ifdef KMSG_HOP
+	sgHopStop();
+#endif
+	_sgStaged = false;
+	sgWriteFreqReg(freqReg, !_sgFSelect);
+	_sgStaged = true;
+}
+
+bool sgCommitStaged(void) {
+	if (_sgStaged == false) {
+		return false;
+	}
+	_sgStaged = false;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_sgFSelect = !_sgFSelect;
+	}
+	spiWriteWord(sgGetCtrlWord());
+	return true;
+}
+#endif
+
+bool sgIsStaged(void) {
+	return _sgStaged;
+}
+
+#ifdef KMSG_HOP
+void sgHopPutEntry(uint8_t index, uint32_t freqReg, uint16_t dwellUs) {
+	if (index >= KMSG_HOP_TABLE_LENGTH) {
+		return;
+	}
+	if (dwellUs < KMSG_HOP_MIN_DWELL_US) {
+		dwellUs = KMSG_HOP_MIN_DWELL_US;
+	}
+	uint32_t dwell = (uint32_t)dwellUs * SG_HOP_TICKS_PER_US;
+	if (dwell > UINT16_MAX) {
+		dwell = UINT16_MAX;
+	}
+	// entry may be read by the interrupt during playback
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_sgHopTable[index].freqReg = freqReg & SG_FREQ_REG_MASK;
+		_sgHopTable[index].dwell = dwell;
+	}
+}
+
+/*
+ * Function sgHopPrepare
+ * Desc     prepares SPI frame written by the next compare match, so the interrupt only sends it
+ */
+void sgHopPrepare(void) {
+	_sgHopWords[0] = sgGetCtrlWord() ^ _BV(CTLR_FSELECT);
+	_sgHopWordCount = 1;
+	_sgHopAfter = SG_HOP_NO_ENTRY;
+	if (_sgHopNext != SG_HOP_NO_ENTRY) {
+		_sgHopAfter = sgHopGetNext(_sgHopNext);
+	}
+	if (_sgHopAfter != SG_HOP_NO_ENTRY) {
+		// currently selected register is deselected by the frame
+		uint16_t regBits = (_sgFSelect == true) ? WRITE_FREQ1 : WRITE_FREQ0;
+		_sgHopAfterFreqReg = _sgHopTable[_sgHopAfter].freqReg;
+		_sgHopWords[1] = FREQ_LSB(_sgHopAfterFreqReg) | regBits;
+		_sgHopWords[2] = FREQ_MSB(_sgHopAfterFreqReg) | regBits;
+		_sgHopWordCount = 3;
 	}
-	word |= sgGetCtrlWaveType(waveType);
-	spiWriteWord(word);
-	word = (FREQ_LSB(freqReg)) | regBits;
-	spiWriteWord(word);
-	word = (FREQ_MSB(freqReg)) | regBits;
-	spiWriteWord(word);
 }
 
-void setGeneratorParameters(uint64_t requestedFreq, SgWaveType waveType) {
-	uint32_t freqReg = sgCalcFreqReg(requestedFreq);
-	setFrequencyAndWaveType(freqReg, waveType, 0);
+uint8_t sgHopGetNext(uint8_t index) {
+	index++;
+	if (index < _sgHopLength) {
+		return index;
+	}
+	return (_sgHopLoop == true) ? 0 : SG_HOP_NO_ENTRY;
+}
+
+void sgHopStart(uint8_t length, bool loop) {
+	sgHopStop();
+	_sgStaged = false;
+	if (length == 0 || length > KMSG_HOP_TABLE_LENGTH) {
+		return;
+	}
+	_sgHopLength = length;
+	_sgHopLoop = loop;
+	_sgHopIndex = 0;
+	_sgHopLatencyMin = UINT16_MAX;
+	_sgHopLatencyMax = 0;
+	// first entry is loaded into inactive register and selected at once
+	sgWriteFreqReg(_sgHopTable[0].freqReg, !_sgFSelect);
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		_sgFSelect = !_sgFSelect;
+	}
+	spiWriteWord(sgGetCtrlWord());
+	// dwell counted from the switch, timer is shared so it's not restarted
+	OCR1A = TCNT1 + _sgHopTable[0].dwell;
+	// next entry preloaded before the interrupt is enabled, dwell is longer than this write
+	_sgHopNext = sgHopGetNext(0);
+	if (_sgHopNext != SG_HOP_NO_ENTRY) {
+		sgWriteFreqReg(_sgHopTable[_sgHopNext].freqReg, !_sgFSelect);
+	}
+	sgHopPrepare();
+#ifndef _TESTS_ENV
+	// nothing else uses SPI during playback, interrupt writes its frame at F_CPU / 4
+	SPCR = SPI_CTRL | DIV4;
+#endif
+	_sgHopRunning = true;
+	TIFR = _BV(OCF1A);
+	TIMSK |= _BV(OCIE1A);
+}
+
+void sgHopStop(void) {
+	TIMSK &= ~_BV(OCIE1A);
+	if (_sgHopRunning == true) {
+		_sgHopRunning = false;
+#ifndef _TESTS_ENV
+		SPCR = SPI_CTRL | DIV128;
+#endif
+	}
+}
+
+bool sgHopIsRunning(void) {
+	return _sgHopRunning;
+}
+
+bool sgHopIsLoop(void) {
+	return _sgHopLoop;
 }
+
+uint8_t sgHopGetIndex(void) {
+	return _sgHopIndex;
+}
+
+uint16_t sgHopGetLatencyMax(void) {
+	uint16_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result = _sgHopLatencyMax / SG_HOP_TICKS_PER_US;
+	}
+	return result;
+}
+
+uint16_t sgHopGetJitter(void) {
+	uint16_t result = 0;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (_sgHopLatencyMax >= _sgHopLatencyMin) {
+			result = (_sgHopLatencyMax - _sgHopLatencyMin) / SG_HOP_TICKS_PER_US;
+		}
+	}
+	return result;
+}
+
+ISR(TIMER1_COMPA_vect) {
+	// ticks since compare match, their spread is the jitter of the dwell
+	uint16_t latency = TCNT1 - OCR1A;
+	if (_sgHopNext == SG_HOP_NO_ENTRY) {
+		// dwell of the last entry finished, its frequency stays
+		sgHopStop();
+		return;
+	}
+	// switch to the register preloaded with current entry and preload the next one
+	// in single prepared frame (48 SCLK cycles at F_CPU / 4)
+	spiWriteFrame(_sgHopWords, _sgHopWordCount);
+	_sgHopIndex = _sgHopNext;
+	// next compare is counted from this one, so dwell doesn't depend on the interrupt latency
+	OCR1A += _sgHopTable[_sgHopIndex].dwell;
+	_sgFSelect = !_sgFSelect;
+	if (_sgHopAfter != SG_HOP_NO_ENTRY) {
+		_sgFreqReg[!_sgFSelect] = _sgHopAfterFreqReg;
+	}
+	_sgHopNext = _sgHopAfter;
+	sgHopPrepare();
+	if (latency < _sgHopLatencyMin) {
+		_sgHopLatencyMin = latency;
+	}
+	if (latency > _sgHopLatencyMax) {
+		_sgHopLatencyMax = latency;
+	}
+}
+#endif
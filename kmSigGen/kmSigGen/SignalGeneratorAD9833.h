@@ -41,6 +41,21 @@
 // AD9833 maximum frequency
 #define SG_MAX_FREQ SG_MCLK / 2
 
+// AD9833 frequency register size, frequency = freqReg * SG_MCLK / 2^SG_FREQ_REG_BITS
+#define SG_FREQ_REG_BITS 28
+#define SG_FREQ_REG_MASK 0x0FFFFFFFUL
+// value of the frequency register for SG_MAX_FREQ
+#define SG_FREQ_REG_MAX (1UL << (SG_FREQ_REG_BITS - 1))
+
+// Frequency register for the frequency known at compile time (in Hz multiplied by SG_FREQ_COEF)
+#define SG_FREQ_REG(freq) ((uint32_t)((((uint64_t)(freq) << SG_FREQ_REG_BITS) \
+		+ (uint64_t)SG_MCLK * SG_FREQ_COEF / 2) / ((uint64_t)SG_MCLK * SG_FREQ_COEF)))
+
+// Coefficient for sgCalcDec and sgCalcFreqReg, scaledClock is SG_MCLK multiplied by the scale of
+// the decimal value (e.g. SG_MCLK * 10000 for 0.0001Hz units) and has to be below 2^(32 + 28 - shift)
+#define SG_DEC_COEF(scaledClock, shift) ((uint32_t)(((uint64_t)(scaledClock) \
+		+ (1ULL << (SG_FREQ_REG_BITS - (shift)) >> 1)) >> (SG_FREQ_REG_BITS - (shift))))
+
 // Definition of wave types for Signal Generator
 typedef enum {
 	/// Square Wave Type 5V p-p
@@ -63,39 +78,160 @@ Following definitions to be set in config.h file @n
 #define \b SG_DD_MISO	optional (e.g PB4) @n
 #define \b SG_DD_SCK 	SCK pin (e.g. PB5) @n
 #define \b SG_MCLK AD9833 master clock in Hz (e.g. 25000000ULL for 25MHz) @n
-#define \b SG_FREQ_COEF multiplier of the frequency provided to calcFreqReg and calcNearestFreq methods (e.g 1000ULL for *1000)
+#define \b SG_FREQ_COEF multiplier of the frequency provided to SG_FREQ_REG macro (e.g 1000ULL for *1000)
 */
 void sgInit(void);
 
 /**
-Calculate FreqReg from requested Frequency.
-@param freq requested frequency multiplied by 1000 (1 Hx = 1000L, 1KHz = 1000000L 1MHz = 1000000000
-@result 28bit value of frequency regulator
+Calculate decimal value of the frequency from FreqReg, without 64 bit arithmetic.
+Result is (freqReg * coef) >> shift rounded to the nearest integer, coefficients for
+the required scale of the result are calculated at compile time with SG_DEC_COEF macro.
+@param freqReg 28bit value of the frequency register
+@param coef coefficient calculated with SG_DEC_COEF(scaledClock, shift)
+@param shift shift used to calculate coef (up to SG_FREQ_REG_BITS)
+@result frequency in units selected by scaledClock (e.g. 1234567 for 123.4567Hz if SG_MCLK * 10000 is used)
 */
-uint32_t sgCalcFreqReg(uint64_t freq);
+uint32_t sgCalcDec(uint32_t freqReg, uint32_t coef, uint8_t shift);
 
 /**
-Calculate Frequency from FreqReg.
-@param freqReg  28bit value of the frequency regulator
-@result frequency calculated using CG_CLOCK
+Calculate FreqReg from decimal value of the frequency (reverse of sgCalcDec).
+Values above SG_MAX_FREQ are limited to the maximum frequency register value.
+@param dec frequency in units selected by scaledClock of the coef
+@param coef coefficient calculated with SG_DEC_COEF(scaledClock, shift)
+@param shift shift used to calculate coef (up to SG_FREQ_REG_BITS)
+@result 28bit value of frequency register nearest to the requested frequency
 */
-uint64_t sgCalcFreq(uint32_t freqReg);
+uint32_t sgCalcFreqReg(uint32_t dec, uint32_t coef, uint8_t shift);
 
 /**
-Calculate real nearest frequency from requested frequency.
-For 25MHz clock the frequency step for AD9833 is 0.093132257 Hz
-@param freq requested frequency (multiplied by 1000)
-@result real frequency calculated from nearest available frequency (multiplied by 1000)
+Sets frequency and Wave Type of the Signal Generator to provided values.
+@param freqReg 28bit value of frequency register (e.g. calculated with SG_FREQ_REG or sgCalcFreqReg)
+@param waveType wave type
 */
-uint64_t sgCalcNearestFreq(uint64_t requestedFreq);
+void setGeneratorParameters(uint32_t freqReg, SgWaveType waveType);
 
 /**
-Sets frequency and Wave Type of the Signal Generator to provided values.
-NOTE: frequency is set to nearest possible frequency available in 
-Signal Generator that is based on AD9833 master clock (as defined in SG_MCLK)
-@param requestedFreq requested frequency to be set in Signal Generator
-@param waveType wave type
+Returns frequency register currently selected for the output.
+@result false for FREQ0, true for FREQ1
+*/
+bool sgGetFSelect(void);
+
+#ifdef KMSG_RAW_WORDS
+/**
+Writes raw 16bit words (control, FREQ0/FREQ1 and PHASE0/PHASE1 writes as described in AD9833
+datasheet) to the generator in single FSYNC frame, without any translation. Frequency hopping is
+stopped and staged frequency discarded. Shadow of the control, frequency and phase registers follows
+the words, so sgGetFreqReg, sgGetWaveType, sgGetFSelect and sgGetPhaseReg report what is programmed.
+With B28 set every frequency register write has to be followed by its second half (LSBs first).
+@param words words to be written (MSB first)
+@param count number of words
+@result true in case words have been written, false if they have been rejected (unpaired half of frequency register)
+*/
+bool sgWriteRaw(const uint16_t *words, uint8_t count);
+#endif
+
+/**
+Returns value of the frequency register currently selected for the output.
+@result 28bit value of frequency register
+*/
+uint32_t sgGetFreqReg(void);
+
+/**
+Returns wave type decoded from the control register.
+@result wave type
+*/
+SgWaveType sgGetWaveType(void);
+
+/**
+Returns phase register currently selected for the output.
+@result false for PHASE0, true for PHASE1
+*/
+bool sgGetPSelect(void);
+
+/**
+Returns value of the phase register currently selected for the output.
+@result 12bit value of phase register
+*/
+uint16_t sgGetPhaseReg(void);
+
+#ifdef TWI_GENERAL_CALL_COMMIT
+/**
+Loads frequency into inactive frequency register, so it can be selected later with sgCommitStaged
+(e.g. on several generators at once). Output is not changed. Any call to setGeneratorParameters
+discards staged value.
+@param freqReg 28bit value of frequency register
+*/
+void sgStageFreqReg(uint32_t freqReg);
+
+/**
+Selects frequency register loaded with sgStageFreqReg.
+@result true in case staged frequency has been selected, false if there was nothing staged
+*/
+bool sgCommitStaged(void);
+#endif
+
+/**
+Returns true in case frequency is staged and waits for sgCommitStaged.
+@result true in case frequency is staged
+*/
+bool sgIsStaged(void);
+
+#ifdef KMSG_HOP
+/**
+Stores entry of the frequency hopping table. Can be called while table is played back.
+@param index position in the table (up to KMSG_HOP_TABLE_LENGTH - 1)
+@param freqReg 28bit value of frequency register
+@param dwellUs time the frequency is generated in microseconds, limited to range
+from KMSG_HOP_MIN_DWELL_US to 65535 * 8000000 / F_CPU
+*/
+void sgHopPutEntry(uint8_t index, uint32_t freqReg, uint16_t dwellUs);
+
+/**
+Starts playback of the frequency hopping table from the first entry. Entries are switched
+by Timer1 compare match interrupt, which selects the inactive frequency register preloaded with the next entry.
+The interrupt writes single frame prepared in advance, SPI runs at F_CPU / 4 during the playback.
+Timer1 has to run free (normal mode) with F_CPU / 8 clock.
+Wave type set with setGeneratorParameters is kept. Any call to setGeneratorParameters stops the playback.
+@param length number of entries to be played back
+@param loop true to start from the first entry after the last one, false to stop on the last entry
+*/
+void sgHopStart(uint8_t length, bool loop);
+
+/**
+Stops playback of the frequency hopping table, generator keeps the current entry.
+*/
+void sgHopStop(void);
+
+/**
+Returns true in case frequency hopping table is played back.
+@result true during playback
+*/
+bool sgHopIsRunning(void);
+
+/**
+Returns true in case frequency hopping table is played back in loop.
+@result true during playback in loop
+*/
+bool sgHopIsLoop(void);
+
+/**
+Returns index of the entry currently generated.
+@result index in the table
+*/
+uint8_t sgHopGetIndex(void);
+
+/**
+Returns highest delay between Timer1 compare match and switching to the next entry since last sgHopStart.
+@result delay in microseconds
+*/
+uint16_t sgHopGetLatencyMax(void);
+
+/**
+Returns difference between the highest and the lowest delay of switching to the next entry
+since last sgHopStart (jitter of the dwell time).
+@result jitter in microseconds
 */
-void setGeneratorParameters(uint64_t requestedFreq, SgWaveType waveType);
+uint16_t sgHopGetJitter(void);
+#endif
 
 #endif /* SIGNALGENERATORAD9833_H_ */
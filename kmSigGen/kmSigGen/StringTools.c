@@ -31,26 +31,52 @@
 
 #define STR_PACK_BYTES 3
 #define STR_PACK_BITS 7
-#define STR_PACK_ADDR_MASK 0x07
+#define STR_PACK_ADDR_MASK 0x0F
 #define STR_PACK_BITS_MASK 0x7F
 #define STR_PACK_WORD_MASK 0x1FFFFF
 #define STR_PACK_COUNT_LSB_BIT 21
 #define STR_PACK_BUFFER_LENGTH 20
 
+// packed BCD arithmetic on 7 digits, 8th digit keeps the carry
+#define STR_BCD_ADD_FIX 0x06666666UL
+#define STR_BCD_CARRY_MASK 0x11111110UL
+#define STR_BCD_DABBLE_FIX 0x33333333UL
+#define STR_BCD_CARRY_MASK_ALL 0x88888888UL
+
 static char _strBuffer[STR_INTERNAL_BUFFERS_SIZE_OF] = "";
 
 void strUnpackBuffer(uint32_t command, char *bufferResult) {
   // extract buffer position
   uint8_t bufferPos = ((command >> STR_PACK_COUNT_LSB_BIT) & STR_PACK_ADDR_MASK) * STR_PACK_BYTES;
+  if (bufferPos >= STR_EXTERNAL_BUFFERS_SIZE_OF - 1) {
+    return;
+  }
+  // characters beyond the buffer are skipped
+  uint8_t endPos = bufferPos + STR_PACK_BYTES;
+  if (endPos > STR_EXTERNAL_BUFFERS_SIZE_OF - 1) {
+    endPos = STR_EXTERNAL_BUFFERS_SIZE_OF - 1;
+  }
   // terminate buffer with 0
-  bufferResult[STR_PACK_BYTES + bufferPos] = '\0';
+  bufferResult[endPos] = '\0';
   //command &= STR_PACK_WORD_MASK; // only character part is needed
   for (int i = 1; i <= STR_PACK_BYTES; i++) {
-    bufferResult[bufferPos + STR_PACK_BYTES - i] = command & STR_PACK_BITS_MASK;
+    uint8_t pos = bufferPos + STR_PACK_BYTES - i;
+    if (pos < endPos) {
+      bufferResult[pos] = command & STR_PACK_BITS_MASK;
+    }
     command >>= STR_PACK_BITS;
   }
 }
 
+#ifdef KMSG_BULK_STRINGS
+void strUnpackBulk(const uint32_t *words, uint8_t length, char *bufferResult) {
+	for (uint8_t i = 0; i < length; i++) {
+		bufferResult[i] = words[i >> 2] >> (24 - 8 * (i & 0x03));
+	}
+	bufferResult[length] = '\0';
+}
+#endif
+
 bool strIsEmpty(const char *buffer) {
 	return (buffer[0] == '\0');
 }
@@ -67,27 +93,90 @@ void strAddToBuffer(char *buffer, const char *str, uint8_t *currentBufferPos) {
 }
 #endif
 
-void strSignalFrequencyToStr(char *buffer, uint16_t freqHi, uint16_t freqLo) {
+uint32_t strBcdAdd(uint32_t bcdA, uint32_t bcdB) {
+	// all digits are increased by 6, so decimal carry becomes binary carry,
+	// then 6 is taken back from digits that didn't produce the carry
+	uint32_t sum = bcdA + STR_BCD_ADD_FIX;
+	uint32_t carries = sum ^ bcdB;
+	sum += bcdB;
+	carries = ~(sum ^ carries) & STR_BCD_CARRY_MASK;
+	return sum - ((carries >> 2) | (carries >> 3));
+}
+
+uint32_t strBcdAddToDigit(uint32_t bcd, uint8_t digit, int8_t delta) {
+	if (digit >= STR_BCD_DIGITS) {
+		// any step of the digit beyond the range reaches one of the limits
+		return (delta > 0) ? STR_BCD_MAX : 0;
+	}
+	uint8_t step = (delta < 0) ? -delta : delta;
+	if (step > 9) {
+		step = 9;
+	}
+	uint32_t bcdStep = (uint32_t)step << (digit * 4);
+	if (delta > 0) {
+		bcd = strBcdAdd(bcd, bcdStep);
+		// carry out of the most significant digit
+		if ((bcd & ~STR_BCD_MASK) != 0) {
+			bcd = STR_BCD_MAX;
+		}
+	} else {
+		// addition of ten's complement, carry out of the most significant digit means no borrow
+		bcd = strBcdAdd(bcd, strBcdAdd(STR_BCD_MAX - bcdStep, 1));
+		if ((bcd & ~STR_BCD_MASK) == 0) {
+			bcd = 0;
+		}
+		bcd &= STR_BCD_MASK;
+	}
+	return bcd;
+}
+
+uint32_t strBinToBcd(uint32_t bin) {
+	// double dabble, digits >= 5 are corrected by 3 before each shift
+	uint32_t bcd = 0;
+	for (uint8_t i = 0; i < 32; i++) {
+		uint32_t correction = ((bcd + STR_BCD_DABBLE_FIX) & STR_BCD_CARRY_MASK_ALL) >> 3;
+		bcd += (correction << 1) | correction;
+		bcd <<= 1;
+		if ((bin & 0x80000000UL) != 0) {
+			bcd |= 1;
+		}
+		bin <<= 1;
+	}
+	return bcd;
+}
+
+uint32_t strBcdToBin(uint32_t bcd) {
+	uint32_t bin = 0;
+	for (uint8_t i = 0; i < 8; i++) {
+		// multiplication by 10 as (x * 8 + x * 2), digits taken from the most significant one
+		bin = (bin << 3) + (bin << 1) + (bcd >> 28);
+		bcd <<= 4;
+	}
+	return bin;
+}
+
+void strSignalFrequencyToStr(char *buffer, uint32_t frequencyBcd) {
 	#ifndef KMSG_NO_STDIO
-	sprintf(buffer, "% 4d.%04d", freqHi, freqLo);
+	// hexadecimal representation of BCD value gives decimal digits
+	sprintf(buffer, "%4lx.%04lx", frequencyBcd >> 16, frequencyBcd & 0xFFFF);
 	#else
 	// function is assuming buffer has space at least (digits * 2 + 2)
 	static const uint8_t digits = 4;
 
-	bool spacesInsteadOfZeros = false;
-	for (uint8_t i = 0; i < digits; i++) {
-		buffer[digits - i - 1] = (
-		spacesInsteadOfZeros == false ? (freqHi % 10) + '0' : ' ');
-		freqHi /= 10;
-		if (freqHi == 0) {
-			spacesInsteadOfZeros = true;
+	bool spacesInsteadOfZeros = true;
+	uint8_t pos = 0;
+	for (uint8_t i = 0; i < digits * 2; i++) {
+		// digits taken from the most significant one, no division needed
+		uint8_t digit = frequencyBcd >> 28;
+		frequencyBcd <<= 4;
+		if (pos == digits) {
+			buffer[pos++] = '.';
 		}
+		if (digit != 0 || pos >= digits - 1) {
+			spacesInsteadOfZeros = false;
+		}
+		buffer[pos++] = (spacesInsteadOfZeros == false ? digit + '0' : ' ');
 	}
-	for (uint8_t i = 0; i < digits; i++) {
-		buffer[digits * 2 - i] = (freqLo % 10) + '0';
-		freqLo /= 10;
-	}
-	buffer[digits] = '.';
 	buffer[digits * 2 + 1] = '\0';
 	#endif
 }
@@ -106,44 +195,43 @@ const char *strSignalMultiplierToStr(FreqMultiplier multpilier) {
 	}
 }
 
-char strWaveTypeToSingleChar(UIWaveType waveType) {
+const char *strWaveTypeToStr(UIWaveType waveType) {
 	switch (waveType) {
 		case UI_SIG_SQUARE : {
-			return LCD_WAVE_SQUARE_NO;
+			return STR_SQUARE;
 		}
 		case UI_SIG_SINE : {
-			return LCD_WAVE_SINE_NO;
+			return STR_SINE;
 		}
 		case UI_SIG_TRIANGLE : {
-			return LCD_WAVE_TRIANGLE_NO;
+			return STR_TRIANGLE;
 		}
 		default : {
-			return LCD_WAVE_NONE_NO;
+			return STR_NONE;
 		}
 	}
 }
 
-void strSignalParametersToStr(char *buffer, UIWaveType waveType, uint16_t freqHi, uint16_t freqLo, FreqMultiplier multpilier) {
-	char *sigTypeStr = STR_NONE;
+char strWaveTypeToSingleChar(UIWaveType waveType) {
 	switch (waveType) {
-		case UI_SIG_SQUARE: {
-			sigTypeStr = STR_SQUARE;
-			break;
+		case UI_SIG_SQUARE : {
+			return LCD_WAVE_SQUARE_NO;
 		}
-		case UI_SIG_SINE: {
-			sigTypeStr = STR_SINE;
-			break;
+		case UI_SIG_SINE : {
+			return LCD_WAVE_SINE_NO;
 		}
-		case UI_SIG_TRIANGLE: {
-			sigTypeStr = STR_TRIANGLE;
-			break;
+		case UI_SIG_TRIANGLE : {
+			return LCD_WAVE_TRIANGLE_NO;
 		}
-		case UI_SIG_NONE: {
-			// Intentionally
-			break;
+		default : {
+			return LCD_WAVE_NONE_NO;
 		}
 	}
-	strSignalFrequencyToStr(_strBuffer, freqHi, freqLo);
+}
+
+void strSignalParametersToStr(char *buffer, UIWaveType waveType, uint32_t frequencyBcd, FreqMultiplier multpilier) {
+	const char *sigTypeStr = strWaveTypeToStr(waveType);
+	strSignalFrequencyToStr(_strBuffer, frequencyBcd);
 	#ifndef KMSG_NO_STDIO
 	sprintf(buffer, "%s%s%s%s", sigTypeStr, STR_FREQUENCY_SHORT, _strBuffer, strSignalMultiplierToStr(multpilier));
 	#else
@@ -153,4 +241,62 @@ void strSignalParametersToStr(char *buffer, UIWaveType waveType, uint16_t freqHi
 	strAddToBuffer(buffer, _strBuffer, &bufferPos);
 	strAddToBuffer(buffer, strSignalMultiplierToStr(multpilier), &bufferPos);
 	#endif
-}
\ No newline at end of file
+}
+
+void strByteToHexStr(char *buffer, uint8_t value) {
+	#ifndef KMSG_NO_STDIO
+	sprintf(buffer, "0x%02x", value);
+	#else
+	buffer[0] = '0';
+	buffer[1] = 'x';
+	for (uint8_t i = 0; i < 2; i++) {
+		uint8_t digit = (i == 0) ? (value >> 4) : (value & 0x0F);
+		buffer[2 + i] = (digit < 10) ? ('0' + digit) : ('a' - 10 + digit);
+	}
+	buffer[4] = '\0';
+	#endif
+}
+
+#if defined(KMSG_USART) || defined(KMSG_EEPROM_JOURNAL)
+uint8_t strCrc8(uint8_t crc, uint8_t data) {
+	crc ^= data;
+	for (uint8_t i = 0; i < 8; i++) {
+		crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : (crc << 1);
+	}
+	return crc;
+}
+#endif
+
+SgWaveType ui2sgWaveType(UIWaveType uiWaveType) {
+	switch (uiWaveType) {
+		case UI_SIG_SINE : {
+			return SG_SIG_SINE;
+		}
+		case UI_SIG_SQUARE : {
+			return SG_SIG_SQUARE;
+		}
+		case UI_SIG_TRIANGLE : {
+			return SG_SIG_TRIANGLE;
+		}
+		default : {
+			return SG_SIG_NONE;
+		}
+	}
+}
+
+UIWaveType sg2uiWaveType(SgWaveType sgWaveType) {
+	switch (sgWaveType) {
+		case SG_SIG_SINE : {
+			return UI_SIG_SINE;
+		}
+		case SG_SIG_SQUARE : {
+			return UI_SIG_SQUARE;
+		}
+		case SG_SIG_TRIANGLE : {
+			return UI_SIG_TRIANGLE;
+		}
+		default : {
+			return UI_SIG_NONE;
+		}
+	}
+}
@@ -34,6 +34,11 @@
 #include "UserInterface.h"
 #include "SignalGeneratorAD9833.h"
 
+// packed BCD values use 7 digits (e.g. 0x09999999 for 999.9999)
+#define STR_BCD_DIGITS 7
+#define STR_BCD_MASK 0x0FFFFFFFUL
+#define STR_BCD_MAX 0x09999999UL
+
 typedef enum {
 	STR_MULT_NONE = 1,
 	STR_MULT_KILO = 2,
@@ -42,11 +47,25 @@ typedef enum {
 
 /**
 Unpacks characters received via TWI command into provided buffer.
+Each command carries 3 characters (7 bit each) in bits 0 - 20 and position of those
+characters (in groups of 3) in bits 21 - 24, so strings up to LCD_DDRAM_COLS are accepted.
+Characters not fitting into STR_EXTERNAL_BUFFERS_SIZE_OF buffer are ignored.
 @param command A command received from TWI interface
 @result bufferResult String buffer to receive complete string
 */
 void strUnpackBuffer(uint32_t command, char *bufferResult);
 
+/**
+Unpacks complete string received via TWI bulk string command into provided buffer.
+Each word carries 4 characters (8 bit each, MSB first), string is terminated with 0.
+@param words data words following the command
+@param length number of characters (up to STR_EXTERNAL_BUFFERS_SIZE_OF - 1)
+@result bufferResult String buffer to receive complete string
+*/
+#ifdef KMSG_BULK_STRINGS
+void strUnpackBulk(const uint32_t *words, uint8_t length, char *bufferResult);
+#endif
+
 /**
 Returns true if provided string is empty.
 @param buffer A string in buffer to be checked
@@ -55,12 +74,50 @@ Returns true if provided string is empty.
 bool strIsEmpty(const char *buffer);
 
 /**
-Changes HI and LO frequency parts used in UserInterface into string that can be displayed.
-@param freqHi frequency value on the left side of dot ('.')
-@param freqLo frequency value on the right side of dot
+Adds two packed BCD values (7 digits) without conversion to binary.
+@param bcdA first value
+@param bcdB second value
+@result sum in packed BCD, carry out of 7th digit is placed in the 8th digit
+*/
+uint32_t strBcdAdd(uint32_t bcdA, uint32_t bcdB);
+
+/**
+Adds signed value to the single digit of packed BCD value with carry (or borrow) to higher digits.
+Used by the frequency editor, so each encoder step costs few additions instead of divisions.
+@param bcd packed BCD value (up to STR_BCD_MAX)
+@param digit number of the digit (0 - least significant)
+@param delta value to be added to the digit (-9 to 9, larger values are limited)
+@result packed BCD value limited to the range from 0 to STR_BCD_MAX
+*/
+uint32_t strBcdAddToDigit(uint32_t bcd, uint8_t digit, int8_t delta);
+
+/**
+Converts binary value to packed BCD with double dabble (shift and add 3) algorithm.
+@param bin binary value (up to 99999999)
+@result packed BCD value
+*/
+uint32_t strBinToBcd(uint32_t bin);
+
+/**
+Converts packed BCD value to binary.
+@param bcd packed BCD value
+@result binary value
+*/
+uint32_t strBcdToBin(uint32_t bcd);
+
+/**
+Changes frequency kept in packed BCD (4 digits after dot) into string that can be displayed.
+@param frequencyBcd frequency in packed BCD (e.g. 0x01234567 for 123.4567)
 @result buffer A result string will be placed there
 */
-void strSignalFrequencyToStr(char *buffer, uint16_t freqHi, uint16_t freqLo);
+void strSignalFrequencyToStr(char *buffer, uint32_t frequencyBcd);
+
+/**
+Changes byte into hexadecimal string with 0x prefix (e.g. "0x56").
+@param value A value to be converted to string
+@result buffer A result string will be placed there (at least 5 characters)
+*/
+void strByteToHexStr(char *buffer, uint8_t value);
 
 /**
 Returns string corresponding to the provided multiplier argument.
@@ -71,12 +128,18 @@ const char *strSignalMultiplierToStr(FreqMultiplier multpilier);
 
 /**
 Returns complete string describing current frequency as used in UserInterface functions.
-@param freqHi frequency value on the left side of dot ('.')
-@param freqLo frequency value on the right side of dot
+@param frequencyBcd frequency in packed BCD (4 digits after dot)
 @param multiplier A value to be converted to string
 @result Complete string describing current frequency as used in UserInterface functions
 */
-void strSignalParametersToStr(char *buffer, UIWaveType waveType, uint16_t freqHi, uint16_t freqLo, FreqMultiplier multpilier);
+void strSignalParametersToStr(char *buffer, UIWaveType waveType, uint32_t frequencyBcd, FreqMultiplier multpilier);
+
+/**
+Returns string corresponding to the provided waveType argument (as shown on the main screen).
+@param waveType A Wave Type as used by UI
+@result string representing wave type
+*/
+const char *strWaveTypeToStr(UIWaveType waveType);
 
 /**
 Returns single character corresponding to the provided waveType argument.
@@ -86,6 +149,15 @@ Returns single character corresponding to the provided waveType argument.
 char strWaveTypeToSingleChar(UIWaveType waveType);
 
 
+/**
+Calculates CRC-8 (polynomial x^8 + x^2 + x + 1, initial value 0x00) bit by bit.
+Used for USART frames and EEPROM settings records (only with KMSG_USART or KMSG_EEPROM_JOURNAL).
+@param crc CRC of the preceding bytes
+@param data next byte
+@result CRC including the byte
+*/
+uint8_t strCrc8(uint8_t crc, uint8_t data);
+
 /**
 Converts provided UIWaveType to SGWaveType value.
 @param uiWaveType input parameter as WaveType defined in UserInterface
@@ -93,4 +165,11 @@ Converts provided UIWaveType to SGWaveType value.
 */
 SgWaveType ui2sgWaveType(UIWaveType uiWaveType);
 
+/**
+Converts provided SgWaveType to UIWaveType value.
+@param sgWaveType input parameter as SgWaveType defined in SignalGeneratorAD9833
+@result the same wave type as UIWaveType
+*/
+UIWaveType sg2uiWaveType(SgWaveType sgWaveType);
+
 #endif /* STRINGTOOLS_H_ */
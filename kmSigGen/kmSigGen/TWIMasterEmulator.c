@@ -0,0 +1,387 @@
+/*
+ * TWIMasterEmulator.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifdef _TESTS_ENV
+
+#include <time.h>
+#include "config.h"
+#include "TWIMasterEmulator.h"
+#include "TWISlave.h"
+#include "ExternalInterface.h"
+#include "SignalGeneratorAD9833.h"
+
+// bus time of single SCL cycle and of a byte with its acknowledge bit
+#define TWI_EMU_CYCLE_US (1000000UL / TWI_EMU_SCL_HZ)
+#define TWI_EMU_BYTE_US (9 * TWI_EMU_CYCLE_US)
+// longest transaction twiGetTransaction may assemble (255 bytes)
+#define TWI_EMU_WORDS_MAX 64
+// fuzzer drains single transaction with probability 1 / 8 after every event
+#define TWI_EMU_FUZZ_DRAIN_MASK 0x07
+#define TWI_EMU_FUZZ_WORD 0x2A5A5A5AUL
+
+volatile uint8_t TWAR = 0;
+volatile uint8_t TWCR = 0;
+volatile uint8_t TWSR = 0;
+volatile uint8_t TWDR = 0;
+volatile uint16_t TCNT1 = 0;
+
+// role of the slave in the current transfer, as seen by TWI hardware of the slave
+typedef enum {
+	TWI_EMU_NOT_ADDRESSED,
+	TWI_EMU_RECEIVER,
+	TWI_EMU_TRANSMITTER
+} TwiEmuSlaveState;
+
+static TwiEmuSlaveState _emuSlaveState = TWI_EMU_NOT_ADDRESSED;
+// bus kept by the master after transfer without stop
+static bool _emuBusKept = false;
+static uint32_t _emuRandom = 1;
+static TwiEmuStats _emuStats;
+
+static const uint8_t _emuFuzzStatuses[] = {
+	TW_SR_SLA_ACK, TW_SR_ARB_LOST_SLA_ACK, TW_SR_GCALL_ACK, TW_SR_ARB_LOST_GCALL_ACK,
+	TW_SR_DATA_ACK, TW_SR_DATA_NACK, TW_SR_GCALL_DATA_ACK, TW_SR_GCALL_DATA_NACK,
+	TW_SR_STOP, TW_ST_SLA_ACK, TW_ST_ARB_LOST_SLA_ACK, TW_ST_DATA_ACK,
+	TW_ST_DATA_NACK, TW_ST_LAST_DATA, TW_NO_INFO, TW_BUS_ERROR
+};
+
+// Private functions
+void twiEmuBusTime(uint32_t us);
+void twiEmuCondition(void);
+bool twiEmuAddress(uint8_t address, bool read);
+bool twiEmuIsAck(void);
+uint32_t twiEmuNextRandom(void);
+uint32_t twiEmuCheckBuffers(void);
+uint32_t twiEmuDrain(uint32_t *words);
+uint32_t twiEmuCheckBusError(uint32_t *words);
+void twiEmuPackWord(uint8_t *data, uint32_t word);
+
+// Implementation
+void twiEmuBusTime(uint32_t us) {
+	_emuStats.busTimeUs += us;
+	// Timer1 runs with F_CPU / 8 clock
+	TCNT1 += us * (F_CPU / 1000000UL) / 8;
+}
+
+void twiEmuStatus(uint8_t status, uint8_t data) {
+	_emuStats.events++;
+	TWSR = status;
+	TWDR = data;
+	// TWINT is cleared by writing one to it, so it's set only in case interrupt writes it
+	TWCR &= ~_BV(TWINT);
+	TWI_vect();
+	if (status != TW_NO_INFO && ((TWCR & _BV(TWINT)) == 0
+			|| (TWCR & _BV(TWEN)) == 0 || (TWCR & _BV(TWIE)) == 0)) {
+		_emuStats.stalls++;
+	}
+	// stop condition is not generated in slave mode, hardware only releases the lines
+	TWCR &= ~_BV(TWSTO);
+}
+
+/*
+ * Function twiEmuIsAck
+ * Desc     checks if the slave acknowledges next byte
+ * Output   true in case TWEA is set by the last interrupt
+ */
+bool twiEmuIsAck(void) {
+	return ((TWCR & _BV(TWEA)) != 0 && (TWCR & _BV(TWEN)) != 0);
+}
+
+/*
+ * Function twiEmuCondition
+ * Desc     generates start, repeated start or stop condition, write in progress
+ *          is completed by the slave with the same status for all of them
+ */
+void twiEmuCondition(void) {
+	if (_emuSlaveState == TWI_EMU_RECEIVER) {
+		twiEmuStatus(TW_SR_STOP, TWDR);
+	}
+	_emuSlaveState = TWI_EMU_NOT_ADDRESSED;
+	twiEmuBusTime(TWI_EMU_CYCLE_US);
+}
+
+/*
+ * Function twiEmuAddress
+ * Desc     sends address byte with direction bit after start condition
+ * Input    address: 7bit address (0x00 for general call)
+ *          read: true for SLA+R, false for SLA+W
+ * Output   true in case address has been acknowledged
+ */
+bool twiEmuAddress(uint8_t address, bool read) {
+	twiEmuBusTime(TWI_EMU_BYTE_US);
+	bool generalCall = (address == 0x00 && read == false && (TWAR & _BV(TWGCE)) != 0);
+	if (twiEmuIsAck() == false || (address != (TWAR >> 1) && generalCall == false)) {
+		_emuStats.bytesNacked++;
+		return false;
+	}
+	_emuStats.bytesAcked++;
+	if (read == true) {
+		_emuSlaveState = TWI_EMU_TRANSMITTER;
+		twiEmuStatus(TW_ST_SLA_ACK, 0x00);
+	} else {
+		_emuSlaveState = TWI_EMU_RECEIVER;
+		twiEmuStatus((generalCall == true) ? TW_SR_GCALL_ACK : TW_SR_SLA_ACK, address << 1);
+	}
+	return true;
+}
+
+uint8_t twiEmuWrite(uint8_t address, const uint8_t *data, uint8_t length, bool stop) {
+	twiEmuCondition();
+	_emuBusKept = true;
+	uint8_t result = 0;
+	if (twiEmuAddress(address, false) == true) {
+		result++;
+		bool generalCall = (TWSR == TW_SR_GCALL_ACK);
+		for (uint8_t i = 0; i < length; i++) {
+			twiEmuBusTime(TWI_EMU_BYTE_US);
+			if (twiEmuIsAck() == false) {
+				// slave switches to not addressed mode and ignores rest of the transfer
+				_emuStats.bytesNacked++;
+				_emuSlaveState = TWI_EMU_NOT_ADDRESSED;
+				twiEmuStatus((generalCall == true) ? TW_SR_GCALL_DATA_NACK : TW_SR_DATA_NACK, data[i]);
+				break;
+			}
+			_emuStats.bytesAcked++;
+			result++;
+			twiEmuStatus((generalCall == true) ? TW_SR_GCALL_DATA_ACK : TW_SR_DATA_ACK, data[i]);
+		}
+	}
+	if (stop == true) {
+		twiEmuStop();
+	}
+	return result;
+}
+
+uint8_t twiEmuRead(uint8_t address, uint8_t *buffer, uint8_t length, bool stop) {
+	twiEmuCondition();
+	_emuBusKept = true;
+	uint8_t result = 0;
+	if (length > 0 && twiEmuAddress(address, true) == true) {
+		for (uint8_t i = 0; i < length; i++) {
+			twiEmuBusTime(TWI_EMU_BYTE_US);
+			if (_emuSlaveState != TWI_EMU_TRANSMITTER) {
+				// lines are released by the slave, so master reads ones
+				buffer[i] = 0xFF;
+				continue;
+			}
+			buffer[i] = TWDR;
+			bool lastByte = (twiEmuIsAck() == false);
+			if (i == length - 1) {
+				// master doesn't acknowledge the last byte
+				_emuSlaveState = TWI_EMU_NOT_ADDRESSED;
+				twiEmuStatus(TW_ST_DATA_NACK, 0x00);
+			} else if (lastByte == true) {
+				_emuSlaveState = TWI_EMU_NOT_ADDRESSED;
+				twiEmuStatus(TW_ST_LAST_DATA, 0x00);
+			} else {
+				twiEmuStatus(TW_ST_DATA_ACK, 0x00);
+			}
+		}
+		result = length;
+	}
+	if (stop == true) {
+		twiEmuStop();
+	}
+	return result;
+}
+
+void twiEmuStop(void) {
+	if (_emuBusKept == true) {
+		twiEmuCondition();
+		_emuBusKept = false;
+	}
+}
+
+void twiEmuBusError(void) {
+	_emuSlaveState = TWI_EMU_NOT_ADDRESSED;
+	_emuBusKept = false;
+	twiEmuStatus(TW_BUS_ERROR, 0x00);
+	twiEmuBusTime(TWI_EMU_CYCLE_US);
+}
+
+void twiEmuReset(void) {
+	_emuSlaveState = TWI_EMU_NOT_ADDRESSED;
+	_emuBusKept = false;
+	twiEmuResetStats();
+}
+
+void twiEmuResetStats(void) {
+	_emuStats.events = 0;
+	_emuStats.bytesAcked = 0;
+	_emuStats.bytesNacked = 0;
+	_emuStats.stalls = 0;
+	_emuStats.busTimeUs = 0;
+}
+
+TwiEmuStats twiEmuGetStats(void) {
+	return _emuStats;
+}
+
+/*
+ * Function twiEmuNextRandom
+ * Desc     xorshift generator, so sequences are the same on every host
+ * Output   next pseudo random value
+ */
+uint32_t twiEmuNextRandom(void) {
+	_emuRandom ^= _emuRandom << 13;
+	_emuRandom ^= _emuRandom >> 17;
+	_emuRandom ^= _emuRandom << 5;
+	return _emuRandom;
+}
+
+/*
+ * Function twiEmuCheckBuffers
+ * Desc     checks if queued transactions and words fit into buffers of TWISlave.c
+ * Output   number of violations
+ */
+uint32_t twiEmuCheckBuffers(void) {
+	uint32_t result = 0;
+	if (twiGetTransactionsInBuffer() > TWI_BUFFER_TRANSACTIONS) {
+		result++;
+	}
+	if (twiGetWordsInBuffer() > TWI_BUFFER_BYTES / 4) {
+		result++;
+	}
+	return result;
+}
+
+/*
+ * Function twiEmuDrain
+ * Desc     takes single transaction from TWISlave.c and checks its length
+ * Input    words: buffer for TWI_EMU_WORDS_MAX words
+ * Output   number of violations
+ */
+uint32_t twiEmuDrain(uint32_t *words) {
+	return (twiGetTransaction(words) > TWI_BUFFER_LENGTH / 4) ? 1 : 0;
+}
+
+/*
+ * Function twiEmuCheckBusError
+ * Desc     interrupts write with bus error, the write can't be committed and has to be
+ *          counted as dropped, buffers have to be empty before
+ * Input    words: buffer for TWI_EMU_WORDS_MAX words
+ * Output   number of violations
+ */
+uint32_t twiEmuCheckBusError(uint32_t *words) {
+	uint32_t result = 0;
+	// counters saturate, so they are cleared before
+	twiResetStats();
+	uint8_t data[8];
+	twiEmuPackWord(&data[0], TWI_EMU_FUZZ_WORD);
+	twiEmuPackWord(&data[4], TWI_EMU_FUZZ_WORD);
+	twiEmuWrite(TWAR >> 1, data, sizeof(data), false);
+	twiEmuBusError();
+	if (twiIsDataInBuffer() == true || twiGetStat(TWI_STAT_OVERFLOWS) != 1) {
+		result++;
+	}
+	while (twiIsDataInBuffer() == true) {
+		twiGetTransaction(words);
+	}
+	return result;
+}
+
+/*
+ * Function twiEmuPackWord
+ * Desc     stores command word MSB first, as sent over the bus
+ * Input    data: 4 bytes of result
+ *          word: command word
+ */
+void twiEmuPackWord(uint8_t *data, uint32_t word) {
+	for (uint8_t i = 0; i < 4; i++) {
+		data[i] = word >> (24 - 8 * i);
+	}
+}
+
+uint32_t twiEmuFuzz(uint32_t seed, uint32_t events) {
+	uint32_t words[TWI_EMU_WORDS_MAX];
+	uint32_t result = 0;
+	uint32_t stalls = _emuStats.stalls;
+	_emuRandom = (seed != 0) ? seed : 1;
+	for (uint32_t i = 0; i < events; i++) {
+		uint32_t random = twiEmuNextRandom();
+		uint8_t status = _emuFuzzStatuses[random % sizeof(_emuFuzzStatuses)];
+		uint8_t transactions = twiGetTransactionsInBuffer();
+		twiEmuStatus(status, random >> 8);
+		result += twiEmuCheckBuffers();
+		// only stop completes the write, bus error or NACK drop it
+		if (status != TW_SR_STOP && twiGetTransactionsInBuffer() > transactions) {
+			result++;
+		}
+		if (((random >> 16) & TWI_EMU_FUZZ_DRAIN_MASK) == 0) {
+			result += twiEmuDrain(words);
+		}
+	}
+	// any write in progress is completed, after that regular write has to pass unchanged
+	twiEmuStatus(TW_SR_STOP, 0x00);
+	_emuSlaveState = TWI_EMU_NOT_ADDRESSED;
+	_emuBusKept = false;
+	while (twiIsDataInBuffer() == true) {
+		result += twiEmuDrain(words);
+	}
+	result += twiEmuCheckBusError(words);
+	uint8_t data[4];
+	twiEmuPackWord(data, TWI_EMU_FUZZ_WORD);
+	if (twiEmuWrite(TWAR >> 1, data, sizeof(data), true) != sizeof(data) + 1
+			|| twiGetTransaction(words) != 1 || words[0] != TWI_EMU_FUZZ_WORD) {
+		result++;
+	}
+	return result + (_emuStats.stalls - stalls);
+}
+
+uint32_t twiEmuBenchmark(uint8_t burst, uint32_t commands) {
+	uint8_t data[TWI_BUFFER_LENGTH];
+	if (burst == 0 || burst > TWI_BUFFER_LENGTH / 4) {
+		burst = TWI_BUFFER_LENGTH / 4;
+	}
+	clock_t start = clock();
+	uint32_t sent = 0;
+	while (sent < commands) {
+		uint8_t count = (commands - sent < burst) ? commands - sent : burst;
+		// execute queued commands first in case write would be dropped
+		if (twiGetTransactionsInBuffer() >= TWI_BUFFER_TRANSACTIONS
+				|| twiGetWordsInBuffer() + count > TWI_BUFFER_BYTES / 4) {
+			extLoop();
+		}
+		for (uint8_t i = 0; i < count; i++) {
+			// frequency register commands, each one different from the previous one
+			twiEmuPackWord(&data[i * 4], (0x01UL << 29) | ((sent + i) & SG_FREQ_REG_MASK));
+		}
+		if (twiEmuWrite(TWAR >> 1, data, count * 4, true) == count * 4 + 1) {
+			sent += count;
+		} else {
+			extLoop();
+		}
+	}
+	while (twiIsDataInBuffer() == true) {
+		extLoop();
+	}
+	clock_t elapsed = clock() - start;
+	if (elapsed == 0) {
+		elapsed = 1;
+	}
+	return (uint64_t)commands * CLOCKS_PER_SEC / elapsed;
+}
+
+#endif
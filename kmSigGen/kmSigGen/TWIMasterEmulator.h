@@ -0,0 +1,198 @@
+/** @file
+ * @brief Host-side TWI/I2C master driving TWISlave.c interrupt with synthetic status sequences.
+ * TWIMasterEmulator.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Available only in test environment (_TESTS_ENV defined). In such case TWISlave.c
+ *  uses TWI registers defined here instead of avr-libc ones, and the master model
+ *  calls TWI_vect() with the status codes the hardware would report for every byte
+ *  on the bus (address match, data, stop, repeated start, reads, bus errors).
+ *  Bus time is modeled with TWI_EMU_SCL_HZ clock and advances TCNT1 (F_CPU/8 clock, as Timer1 of TWISlave.c).
+ *  Example of the host build (driver providing usr* functions used by ExternalInterface.c,
+ *  e.g. kmSigGenTests/TestTwi.c run by "make test"):
+ *  gcc -D_TESTS_ENV -DF_CPU=8000000UL TWISlave.c TWIMasterEmulator.c ExternalInterface.c
+ *  SignalGeneratorAD9833.c StringTools.c driver.c
+ *
+ *  References:
+ * -# https://ww1.microchip.com/downloads/en/DeviceDoc/Microchip%208bit%20mcu%20AVR%20ATmega8A%20data%20sheet%2040001974A.pdf
+ */
+
+#ifndef TWIMASTEREMULATOR_H_
+#define TWIMASTEREMULATOR_H_
+
+#ifdef _TESTS_ENV
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// host replacements of avr-libc definitions used by TWISlave.c
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+#define TWINT 7
+#define TWEA 6
+#define TWSTA 5
+#define TWSTO 4
+#define TWWC 3
+#define TWEN 2
+#define TWIE 0
+#define TWGCE 0
+#define PC4 4
+#define PC5 5
+
+// slave receiver and transmitter status codes (TWSR with prescaler bits masked out)
+#define TW_SR_SLA_ACK 0x60
+#define TW_SR_ARB_LOST_SLA_ACK 0x68
+#define TW_SR_GCALL_ACK 0x70
+#define TW_SR_ARB_LOST_GCALL_ACK 0x78
+#define TW_SR_DATA_ACK 0x80
+#define TW_SR_DATA_NACK 0x88
+#define TW_SR_GCALL_DATA_ACK 0x90
+#define TW_SR_GCALL_DATA_NACK 0x98
+#define TW_SR_STOP 0xA0
+#define TW_ST_SLA_ACK 0xA8
+#define TW_ST_ARB_LOST_SLA_ACK 0xB0
+#define TW_ST_DATA_ACK 0xB8
+#define TW_ST_DATA_NACK 0xC0
+#define TW_ST_LAST_DATA 0xC8
+#define TW_NO_INFO 0xF8
+#define TW_BUS_ERROR 0x00
+
+// interrupts are never nested on the host, so atomic blocks are plain blocks
+// (EEPROMEmulator.h defines the same)
+#ifndef ATOMIC_BLOCK
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_BLOCK(type) for (uint8_t _twiEmuAtomic = 1; _twiEmuAtomic != 0; _twiEmuAtomic = 0)
+#define ISR(vector) void vector(void)
+#endif
+
+extern volatile uint8_t TWAR;
+extern volatile uint8_t TWCR;
+extern volatile uint8_t TWSR;
+extern volatile uint8_t TWDR;
+extern volatile uint16_t TCNT1;
+
+/**
+TWI interrupt of TWISlave.c, called by the master model for every status change.
+*/
+void TWI_vect(void);
+
+// SCL clock of the modeled bus (standard mode)
+#define TWI_EMU_SCL_HZ 100000UL
+
+/**
+Bus traffic statistics collected since last twiEmuResetStats call.
+*/
+typedef struct {
+	/// status codes passed to TWI interrupt
+	uint32_t events;
+	/// bytes (address included) acknowledged by the slave
+	uint32_t bytesAcked;
+	/// bytes (address included) not acknowledged by the slave
+	uint32_t bytesNacked;
+	/// interrupts which have not cleared TWINT or have left TWI disabled (bus stalled)
+	uint32_t stalls;
+	/// bus time in microseconds, 9 SCL cycles per byte and 1 per start and stop condition
+	uint32_t busTimeUs;
+} TwiEmuStats;
+
+/**
+Resets the master model to the idle bus and clears statistics. TWISlave.c state is kept,
+so twiInit has to be called separately.
+*/
+void twiEmuReset(void);
+
+/**
+Passes single status to TWI interrupt, regardless of the bus state.
+Used to inject malformed sequences.
+@param status value of TWSR
+@param data value of TWDR
+*/
+void twiEmuStatus(uint8_t status, uint8_t data);
+
+/**
+Writes bytes to the slave. Transfer stops on the first byte not acknowledged.
+Without stop the bus is kept, so next twiEmuWrite or twiEmuRead starts with repeated start.
+@param address 7bit address (0x00 for general call)
+@param data bytes to be written
+@param length number of bytes
+@param stop true to generate stop condition at the end
+@result number of acknowledged bytes, address included (0 in case address has not been acknowledged)
+*/
+uint8_t twiEmuWrite(uint8_t address, const uint8_t *data, uint8_t length, bool stop);
+
+/**
+Reads bytes from the slave, the last byte is not acknowledged by the master.
+@param address 7bit address
+@param buffer result
+@param length number of bytes to be read
+@param stop true to generate stop condition at the end
+@result number of bytes read (0 in case address has not been acknowledged)
+*/
+uint8_t twiEmuRead(uint8_t address, uint8_t *buffer, uint8_t length, bool stop);
+
+/**
+Generates stop condition in case bus is kept after twiEmuWrite or twiEmuRead.
+*/
+void twiEmuStop(void);
+
+/**
+Generates illegal start or stop condition in the middle of the transfer.
+*/
+void twiEmuBusError(void);
+
+/**
+Clears statistics, to be called before transfers which traffic is to be measured.
+*/
+void twiEmuResetStats(void);
+
+/**
+Returns statistics collected since last twiEmuResetStats call.
+@result bus traffic statistics
+*/
+TwiEmuStats twiEmuGetStats(void);
+
+/**
+Passes random status sequences (valid status codes in any order, random data) to TWI interrupt
+and checks buffers of TWISlave.c after every event: number of queued transactions and words,
+length of assembled transactions, release of the bus and that only stop commits the write.
+At the end the bus is recovered with stop, write interrupted by bus error has to be dropped
+and counted as overflow, and regular write has to be received intact. twiInit has to be called before.
+@param seed seed of the pseudo random sequence, same seed gives the same sequence
+@param events number of statuses passed to the interrupt
+@result number of detected violations (0 in case of success)
+*/
+uint32_t twiEmuFuzz(uint32_t seed, uint32_t events);
+
+/**
+Writes frequency register commands in transactions of burst commands each and executes
+them with extLoop whenever buffers of TWISlave.c are full. twiInit has to be called before.
+Bus rate for the same traffic can be calculated from twiEmuGetStats().busTimeUs.
+@param burst commands in single write (up to TWI_BUFFER_LENGTH / 4)
+@param commands total number of commands
+@result commands executed per second of the host time
+*/
+uint32_t twiEmuBenchmark(uint8_t burst, uint32_t commands);
+
+#endif
+
+#endif /* TWIMASTEREMULATOR_H_ */
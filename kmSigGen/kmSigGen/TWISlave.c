@@ -28,9 +28,14 @@
 #ifndef KMSG_NO_TWI
 #include <stdint.h>
 #include <stdbool.h>
+#ifndef _TESTS_ENV
 #include <avr/io.h>
 #include <util/twi.h>
 #include <avr/interrupt.h>
+#include <util/atomic.h>
+#else
+#include "TWIMasterEmulator.h"
+#endif
 
 #include "config.h"
 #include "TWISlave.h"
@@ -38,87 +43,278 @@
 #define TWI_SDA_PIN PC4
 #define TWI_SCL_PIN PC5
 
-static uint32_t _twiRxBufferWords[TWI_BUFFER_LENGTH]; // round robin buffer
-static volatile uint32_t _twiTxResponse = 0;
-static volatile uint8_t _twiRxBufferWordsGetIndex = 0;
-static volatile uint8_t _twiRxBufferWordsPutIndex = 0;
-static volatile uint8_t _twiRxBufferWordsLength = 0;
+#ifdef KMSG_TWI_AUTO_ADDRESS
+#ifdef KMSG_NO_EEPROM
+#error "KMSG_TWI_AUTO_ADDRESS requires EEPROM to store the address"
+#endif
+#include <util/delay.h>
+// bit rate register for 100 kHz SCL clock with prescaler 1 (TWBR >= 10 required in master mode)
+#define TWI_MASTER_TWBR ((F_CPU / 100000UL - 16) / 2)
+// ADC conversions collected by twiRandom (about 100us each)
+#define TWI_RANDOM_SAMPLES 64
+#endif
 
-static uint8_t _twiTxBuffer[TWI_BUFFER_LENGTH];
+// indices of round robin buffers are free running and masked on access,
+// so buffer sizes have to be power of two (up to 128)
+#define TWI_BYTES_MASK (TWI_BUFFER_BYTES - 1)
+#define TWI_TRANSACTIONS_MASK (TWI_BUFFER_TRANSACTIONS - 1)
+#if (TWI_BUFFER_BYTES & TWI_BYTES_MASK) != 0 || TWI_BUFFER_BYTES > 128
+#error "TWI_BUFFER_BYTES has to be power of two"
+#endif
+#if (TWI_BUFFER_TRANSACTIONS & TWI_TRANSACTIONS_MASK) != 0 || TWI_BUFFER_TRANSACTIONS > 128
+#error "TWI_BUFFER_TRANSACTIONS has to be power of two"
+#endif
+#if TWI_BUFFER_LENGTH > TWI_BUFFER_BYTES
+#error "TWI_BUFFER_BYTES has to fit at least one write of TWI_BUFFER_LENGTH"
+#endif
+
+// single producer (TWI interrupt), single consumer (main loop) round robin buffers
+// head indices are written only by the interrupt, tail indices only by the main loop;
+// interrupt only stores raw bytes, words are assembled and checked by the main loop
+static uint8_t _twiRxBytes[TWI_BUFFER_BYTES];
+static uint8_t _twiRxBytesHead = 0; // includes bytes of the write in progress
+static volatile uint8_t _twiRxBytesCommitted = 0; // first byte of the write in progress
+static volatile uint8_t _twiRxBytesTail = 0;
+
+// number of bytes of each transaction stored in _twiRxBytes
+static uint8_t _twiRxTransactions[TWI_BUFFER_TRANSACTIONS];
+static volatile uint8_t _twiRxTransactionsHead = 0;
+static volatile uint8_t _twiRxTransactionsTail = 0;
+
+// write in progress
+static uint8_t _twiRxFirstByte = 0;
+static uint8_t _twiRxLength = 0;
+static bool _twiRxOverflow = false;
+static bool _twiRxGeneralCall = false;
+#ifdef TWI_GENERAL_CALL_COMMIT
+// last data byte of general call, executed by the main loop
+static volatile uint8_t _twiGeneralCallData = 0;
+static volatile bool _twiGeneralCallReceived = false;
+#endif
+
+// bus health counters indexed by TwiStat, TWI_STAT_LENGTH_ERRORS is counted by the main loop
+// when transaction is assembled, all others by the interrupt
+static volatile uint16_t _twiStats[TWI_STAT_COUNT];
+
+#ifdef TWI_ISR_TIMING
+// Timer1 ticks (F_CPU / 8)
+static volatile uint16_t _twiIsrTimeMax = 0;
+// ticks converted to microseconds, multiplied first so F_CPU below 8MHz and not
+// a multiple of 8MHz are handled (exact for F_CPU in whole MHz)
+#define TWI_TICKS_TO_US(X) ((uint32_t)(X) * 8 / (F_CPU / 1000000UL))
+#endif
+
+static uint8_t _twiRegisters[TWI_REGISTERS_LENGTH];
+static uint8_t _twiRegisterPointer = 0;
+
+static uint8_t _twiTxBuffer[TWI_REGISTERS_LENGTH];
 static volatile uint8_t _twiTxBufferIndex = 0;
 static volatile uint8_t _twiTxBufferLength = 0;
 
-static uint8_t _twiRxBuffer[TWI_BUFFER_LENGTH];
-static volatile uint8_t _twiRxBufferIndex = 0;
-
 // private functions
 void twiTransmit(const uint8_t *data, uint8_t length);
-void twiOnSlaveReceive(uint8_t *data, uint8_t length);
+bool twiRxIsRoomForByte(void);
+void twiOnSlaveReceiveStart(void);
+bool twiOnSlaveReceive(uint8_t data);
+void twiOnSlaveReceiveEnd(void);
 void twiOnSlaveTransmit(void);
 void twiReleaseBus(void);
 void twiTransmit(const uint8_t *data, uint8_t length);
 void twiReply(bool ack);
+void twiStatIncrement(TwiStat stat);
+#ifdef KMSG_TWI_AUTO_ADDRESS
+uint16_t twiRandom(void);
+uint8_t twiMasterWait(void);
+bool twiMasterProbe(uint8_t address);
+#endif
 
 // Implementation
 bool twiIsDataInBuffer(void) {
-	return (_twiRxBufferWordsLength > 0);
+	return (_twiRxTransactionsHead != _twiRxTransactionsTail);
+}
+
+#ifdef TWI_GENERAL_CALL_COMMIT
+bool twiGetGeneralCall(uint8_t *data) {
+	bool result = false;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		if (_twiGeneralCallReceived == true) {
+			_twiGeneralCallReceived = false;
+			*data = _twiGeneralCallData;
+			result = true;
+		}
+	}
+	return result;
 }
+#endif
 
-uint32_t twiGetDataFromBuffer(void) {
-	uint32_t result = 0;
-	if (_twiRxBufferWordsLength > 0) {
-		result = _twiRxBufferWords[_twiRxBufferWordsGetIndex++];
-		if (_twiRxBufferWordsGetIndex >= TWI_BUFFER_LENGTH) {
-			_twiRxBufferWordsGetIndex = 0;
+uint8_t twiGetTransaction(uint32_t *words) {
+	uint8_t transactionsTail = _twiRxTransactionsTail;
+	if (_twiRxTransactionsHead == transactionsTail) {
+		return 0;
+	}
+	uint8_t length = _twiRxTransactions[transactionsTail & TWI_TRANSACTIONS_MASK];
+	uint8_t bytesTail = _twiRxBytesTail;
+	uint8_t result = 0;
+	if ((length & 0x03) == 0) {
+		// words are sent MSB first
+		result = length >> 2;
+		for (uint8_t i = 0; i < result; i++) {
+			uint32_t word = 0;
+			for (uint8_t j = 0; j < 4; j++) {
+				word = (word << 8) | _twiRxBytes[bytesTail++ & TWI_BYTES_MASK];
+			}
+			words[i] = word;
+		}
+	} else {
+		// write not made of 4 byte words is dropped as a whole
+		bytesTail += length;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+			twiStatIncrement(TWI_STAT_LENGTH_ERRORS);
 		}
-		_twiRxBufferWordsLength--;
 	}
+	// bytes are released before the transaction slot, so interrupt never sees
+	// a free transaction slot with its bytes still in use
+	_twiRxBytesTail = bytesTail;
+	_twiRxTransactionsTail = transactionsTail + 1;
 	return result;
 }
 
-void twiPutDataResponse(uint32_t response) {
-	_twiTxResponse = response;
+uint16_t twiGetStat(TwiStat stat) {
+	uint16_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result = _twiStats[stat];
+	}
+	return result;
 }
 
-void twiOnSlaveReceive(uint8_t *data, uint8_t length) {
-	if (length % 4 == 0) { // accept only values 4 byte length
-		uint8_t wordsReceived = length / 4;
-		uint8_t bufferPos = 0;
-		uint32_t word;
-		for (int i = 0; i < wordsReceived; i++) {
-			// MSB first
-			word = data[bufferPos++];
-			word <<= 8;
-			word |= data[bufferPos++];
-			word <<= 8;
-			word |= data[bufferPos++];
-			word <<= 8;
-			// LSB last
-			word |= data[bufferPos++];
-			_twiRxBufferWords[_twiRxBufferWordsPutIndex++] = word;
-			if (_twiRxBufferWordsPutIndex >= TWI_BUFFER_LENGTH) {
-				_twiRxBufferWordsPutIndex = 0; // start from the beginning of round robin buffer
-			}
-			_twiRxBufferWordsLength++;
+void twiResetStats(void) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		for (uint8_t i = 0; i < TWI_STAT_COUNT; i++) {
+			_twiStats[i] = 0;
 		}
+#ifdef TWI_ISR_TIMING
+		_twiIsrTimeMax = 0;
+#endif
+	}
+}
+
+/*
+ * Function twiStatIncrement
+ * Desc     increments counter saturated at UINT16_MAX, called from interrupt
+ *          (or with interrupts disabled)
+ * Input    stat: counter to be incremented
+ */
+void twiStatIncrement(TwiStat stat) {
+	if (_twiStats[stat] < UINT16_MAX) {
+		_twiStats[stat]++;
+	}
+}
+
+uint8_t twiGetTransactionsInBuffer(void) {
+	return _twiRxTransactionsHead - _twiRxTransactionsTail;
+}
+
+uint8_t twiGetWordsInBuffer(void) {
+	// bytes of the write in progress are not counted
+	return (uint8_t)(_twiRxBytesCommitted - _twiRxBytesTail) >> 2;
+}
+
+#ifdef TWI_ISR_TIMING
+uint16_t twiGetIsrTimeMax(void) {
+	uint16_t ticks;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		ticks = _twiIsrTimeMax;
+	}
+	uint32_t result = TWI_TICKS_TO_US(ticks);
+	return (result > UINT16_MAX) ? UINT16_MAX : result;
+}
+#endif
+
+void twiPutRegisters(const uint8_t *registers) {
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		for (uint8_t i = 0; i < TWI_REGISTERS_LENGTH; i++) {
+			_twiRegisters[i] = registers[i];
+		}
+	}
+}
+
+/*
+ * Function twiRxIsRoomForByte
+ * Desc     checks if next byte of the write in progress can be stored,
+ *          its place in the buffer is reserved before it's acknowledged
+ * Output   true in case byte fits into the write and into the buffers
+ */
+bool twiRxIsRoomForByte(void) {
+	return ((uint8_t)(_twiRxBytesHead - _twiRxBytesCommitted) < TWI_BUFFER_LENGTH
+			&& (uint8_t)(_twiRxBytesHead - _twiRxBytesTail) < TWI_BUFFER_BYTES
+			&& (uint8_t)(_twiRxTransactionsHead - _twiRxTransactionsTail) < TWI_BUFFER_TRANSACTIONS);
+}
+
+void twiOnSlaveReceiveStart(void) {
+	// bytes of the write never completed with stop are discarded
+	_twiRxBytesHead = _twiRxBytesCommitted;
+	_twiRxLength = 0;
+	_twiRxOverflow = false;
+	_twiRxGeneralCall = false;
+}
+
+/*
+ * Function twiOnSlaveReceive
+ * Desc     stores received byte, the first one is always acknowledged
+ *          as it may be the register pointer
+ * Input    data: received byte
+ * Output   true in case next byte can be acknowledged
+ */
+bool twiOnSlaveReceive(uint8_t data) {
+	if (_twiRxLength == 0) {
+		_twiRxFirstByte = data;
+	}
+	_twiRxLength++;
+	bool room = twiRxIsRoomForByte();
+	if (room == true) {
+		_twiRxBytes[_twiRxBytesHead++ & TWI_BYTES_MASK] = data;
+		room = twiRxIsRoomForByte();
+	}
+	return room;
+}
+
+/*
+ * Function twiOnSlaveReceiveEnd
+ * Desc     publishes complete write as a transaction for the main loop, writes
+ *          which have not fit into the buffers are dropped as a whole and counted
+ */
+void twiOnSlaveReceiveEnd(void) {
+	if (_twiRxGeneralCall == true) {
+		// general call is handled when its byte is received and never reaches the buffer
+	} else if (_twiRxOverflow == true) {
+		twiStatIncrement(TWI_STAT_OVERFLOWS);
+		_twiRxBytesHead = _twiRxBytesCommitted;
+	} else if (_twiRxLength == 1) {
+		// single byte sets the register pointer for following reads
+		_twiRegisterPointer = _twiRxFirstByte;
+		_twiRxBytesHead = _twiRxBytesCommitted;
+		twiStatIncrement(TWI_STAT_WRITES);
+	} else if (_twiRxLength > 0) {
+		_twiRxTransactions[_twiRxTransactionsHead & TWI_TRANSACTIONS_MASK] = _twiRxLength;
+		_twiRxBytesCommitted = _twiRxBytesHead;
+		// transaction becomes visible for the main loop once all its bytes are stored
+		_twiRxTransactionsHead++;
+		_twiRegisterPointer = 0;
+		twiStatIncrement(TWI_STAT_WRITES);
 	}
+	twiOnSlaveReceiveStart();
 }
 
 void twiOnSlaveTransmit(void) {
-	uint8_t data[4];
-	for (int i = 0; i < 4; i++) {
-		data[i] = _twiTxResponse & 0xff;
-		_twiTxResponse >>= 8;
+	// registers from the pointer to the end of the map, reads outside the map return 0x00
+	if (_twiRegisterPointer < TWI_REGISTERS_LENGTH) {
+		twiTransmit(&_twiRegisters[_twiRegisterPointer], TWI_REGISTERS_LENGTH - _twiRegisterPointer);
 	}
-	twiTransmit(data, 4);
 }
 
 void twiInit(uint8_t address) {
-	// load address into TWI address register; ignore global
 	// TWI/I2C Slave Setup
-	// set slave address to provided address, ignore general call
-	// TWAR - TWI (Slave) Address Register
-	TWAR = (address << 1) | 0x00;
+	twiSetAddress(address);
 
 	// set the TWCR to enable address matching and enable TWI, clear TWINT, enable TWI interrupt
 	// TWI-ENable , TWI Interrupt Enable
@@ -129,21 +325,118 @@ void twiInit(uint8_t address) {
 	// TWIE - TWI Interrupt Enable
 	TWCR = _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWEN);
 
-	_twiRxBufferWordsPutIndex = 0;
-	_twiRxBufferWordsGetIndex = 0;
-	_twiRxBufferWordsLength = 0;
+	_twiRxBytesHead = 0;
+	_twiRxBytesCommitted = 0;
+	_twiRxBytesTail = 0;
+	_twiRxTransactionsHead = 0;
+	_twiRxTransactionsTail = 0;
+	twiOnSlaveReceiveStart();
+	twiResetStats();
+}
+
+void twiSetAddress(uint8_t address) {
+	// load address into TWI address register
+	// set slave address to provided address, ignore general call
+	// TWAR - TWI (Slave) Address Register
+#ifdef TWI_GENERAL_CALL_COMMIT
+	// TWGCE - recognize general call (address 0x00)
+	TWAR = (address << 1) | _BV(TWGCE);
+#else
+	TWAR = (address << 1) | 0x00;
+#endif
+}
+
+uint8_t twiGetAddress(void) {
+	return (TWAR >> 1);
+}
+
+#ifdef KMSG_TWI_AUTO_ADDRESS
+uint8_t twiAutoAddress(uint8_t first) {
+	// up to 511 ms of random delay
+	for (uint16_t delay = twiRandom() & 0x01FF; delay > 0; delay--) {
+		_delay_ms(1);
+	}
+	// master mode with standard SCL clock, TWI interrupt stays disabled
+	TWSR = 0;
+	TWBR = TWI_MASTER_TWBR;
+	uint8_t result = first;
+	for (uint8_t address = first; address <= TWI_ADDRESS_MAX; address++) {
+		if (twiMasterProbe(address) == false) {
+			result = address;
+			break;
+		}
+	}
+	TWCR = 0;
+	return result;
 }
 
-void twiStop(void) {
-	// send stop condition
-	TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTO);
+/*
+ * Function twiRandom
+ * Desc     collects random value from the noise of the least significant bit
+ *          of the internal bandgap reference measured by ADC, seeded with the factory
+ *          calibration of the RC oscillator (Timer1 is started at the same time on all
+ *          boards powered together, so it can't be used)
+ * Input    none
+ * Output   random value
+ */
+uint16_t twiRandom(void) {
+	uint16_t result = OSCCAL;
+	// AVCC reference, bandgap (1.30V) input, ADC clock F_CPU / 64
+	ADMUX = _BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+	ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1);
+	// several samples per bit of the result, single one may be the same on similar boards
+	for (uint8_t i = 0; i < TWI_RANDOM_SAMPLES; i++) {
+		ADCSRA |= _BV(ADSC);
+		while (ADCSRA & _BV(ADSC)) {
+			continue;
+		}
+		result = (result << 1) ^ (result >> 15) ^ (ADCL & 0x01);
+		// ADCH has to be read after ADCL to unlock the result register
+		(void)ADCH;
+	}
+	ADCSRA = 0;
+	return result;
+}
 
-	// wait for stop condition to be executed on bus
-	// TWINT is not set after a stop condition!
+/*
+ * Function twiMasterWait
+ * Desc     waits until TWI completes current operation in master mode
+ * Input    none
+ * Output   status code (TWSR with prescaler bits masked out)
+ */
+uint8_t twiMasterWait(void) {
+	while ((TWCR & _BV(TWINT)) == 0) {
+		continue;
+	}
+	return TW_STATUS;
+}
+
+/*
+ * Function twiMasterProbe
+ * Desc     sends start condition and address with write bit, then stop condition
+ * Input    address: 7bit address to be probed
+ * Output   false in case address has not been acknowledged by any device
+ */
+bool twiMasterProbe(uint8_t address) {
+	TWCR = _BV(TWINT) | _BV(TWSTA) | _BV(TWEN);
+	uint8_t status = twiMasterWait();
+	if (status == TW_START) {
+		TWDR = (address << 1) | TW_WRITE;
+		TWCR = _BV(TWINT) | _BV(TWEN);
+		status = twiMasterWait();
+	}
+	if (status == TW_MT_ARB_LOST) {
+		// other master has the bus, just release it
+		TWCR = _BV(TWINT) | _BV(TWEN);
+		return true;
+	}
+	TWCR = _BV(TWINT) | _BV(TWSTO) | _BV(TWEN);
 	while (TWCR & _BV(TWSTO)) {
 		continue;
 	}
+	return (status != TW_MT_SLA_NACK);
 }
+#endif
 
 /*
  * Function twi_releaseBus
@@ -183,14 +476,18 @@ void twiReply(bool ack) {
 	// transmit master read ready signal, with or without ack
 	if (ack == true) {
 		// clear TWI interrupt flag, prepare to receive next byte and acknowledge
-		TWCR |= _BV(TWEN) | _BV(TWIE) | _BV(TWINT) | _BV(TWEA);
+		TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWINT) | _BV(TWEA);
 	} else {
 		// clear TWI interrupt flag, prepare to receive next byte and dont acknowledge
-		TWCR |= _BV(TWEN) | _BV(TWIE) | _BV(TWINT);
+		// (TWEA has to be cleared, otherwise next byte is still acknowledged)
+		TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWINT);
 	}
 }
 
 ISR(TWI_vect) {
+#ifdef TWI_ISR_TIMING
+	uint16_t start = TCNT1;
+#endif
 
 	// react on TWI status and handle different cases
 	// TWSR - TWI Statu Register
@@ -201,45 +498,50 @@ ISR(TWI_vect) {
 	switch (status) {
 	// own address has been acknowledged (own SLA+R received, acknoledge sent)
 		case TW_SR_SLA_ACK:   			// addressed, returned ack
+		case TW_SR_ARB_LOST_SLA_ACK: {	// lost arbitration, returned ack
+			// start new write
+			twiOnSlaveReceiveStart();
+			twiReply(true);
+			break;
+		}
 		case TW_SR_GCALL_ACK:			// addressed generally, returned ack
-		case TW_SR_ARB_LOST_SLA_ACK:	// lost arbitration, returned ack
 		case TW_SR_ARB_LOST_GCALL_ACK: {	// lost arbitration, returned ack
-			// indicate that rx buffer can be overwritten and ack
-			_twiRxBufferIndex = 0;
+			twiOnSlaveReceiveStart();
+			_twiRxGeneralCall = true;
+			twiStatIncrement(TWI_STAT_GENERAL_CALLS);
 			twiReply(true);
 			break;
 		}
-		case TW_SR_DATA_ACK: 			// data received, returned ack
+		case TW_SR_DATA_ACK: {			// data received, returned ack
+			// store byte and nack the next one if it doesn't fit
+			twiReply(twiOnSlaveReceive(TWDR));
+			break;
+		}
 		case TW_SR_GCALL_DATA_ACK: {	// data received generally, returned ack
-			// if there is still room in the rx buffer
-			if (_twiRxBufferIndex < TWI_BUFFER_LENGTH) {
-				// put byte in buffer and ack
-				_twiRxBuffer[_twiRxBufferIndex++] = TWDR;
-				twiReply(true);
-			} else {
-				// otherwise nack
-				twiReply(false);
-			}
+#ifdef TWI_GENERAL_CALL_COMMIT
+			// only stored, the main loop executes it (see twiGetGeneralCall)
+			_twiGeneralCallData = TWDR;
+			_twiGeneralCallReceived = true;
+#endif
+			twiReply(true);
 			break;
 		}
-		case TW_SR_STOP: {				// stop or repeated start condition received		{
-			// put a null char after data if there's room
-			if (_twiRxBufferIndex < TWI_BUFFER_LENGTH) {
-				_twiRxBuffer[_twiRxBufferIndex] = '\0';
-			}
-			twiStop();
-			// routine to process received data
-			twiOnSlaveReceive(_twiRxBuffer, _twiRxBufferIndex);
-			// since we submit rx buffer to main routine, we can reset it
-			_twiRxBufferIndex = 0;
+		case TW_SR_STOP: {				// stop or repeated start condition received
+			// complete write is passed to the main loop
+			twiOnSlaveReceiveEnd();
 			// ack future responses and leave slave receiver state
 			twiReleaseBus();
 			break;
 		}
 	    case TW_SR_DATA_NACK:       	// data received, returned nack
 	    case TW_SR_GCALL_DATA_NACK: {	// data received generally, returned nack
-			// nack back at master
-			twiReply(false);
+			// byte didn't fit, whole write is dropped; no stop is reported
+			// in not addressed mode, so the write ends here
+			_twiRxOverflow = true;
+			twiStatIncrement(TWI_STAT_NACKS);
+			twiOnSlaveReceiveEnd();
+			// keep own address recognized
+			twiReply(true);
 			break;
 		}
 	    // Slave Transmitter
@@ -273,6 +575,7 @@ ISR(TWI_vect) {
 	    }
 	    case TW_ST_DATA_NACK: 		// received nack, we are done
 	    case TW_ST_LAST_DATA: {		// received ack, but we are done already!
+			twiStatIncrement(TWI_STAT_READS);
 			// ack future responses
 			twiReply(true);
 			break;
@@ -281,10 +584,24 @@ ISR(TWI_vect) {
 			break;
 		}
 		case TW_BUS_ERROR: {		// bus error, illegal stop/start
-			twiStop();
+			twiStatIncrement(TWI_STAT_BUS_ERRORS);
+			// interrupted write is incomplete, it's dropped as a whole and counted like
+			// the one which hasn't fit into the buffers
+			if (_twiRxLength != 0) {
+				_twiRxOverflow = true;
+			}
+			twiOnSlaveReceiveEnd();
+			// no stop is sent in slave mode, hardware only releases the lines and clears TWSTO
+			TWCR = _BV(TWEN) | _BV(TWIE) | _BV(TWEA) | _BV(TWINT) | _BV(TWSTO);
 			break;
 		}
 	}
+#ifdef TWI_ISR_TIMING
+	uint16_t time = TCNT1 - start;
+	if (time > _twiIsrTimeMax) {
+		_twiIsrTimeMax = time;
+	}
+#endif
 }
 
 #endif
\ No newline at end of file
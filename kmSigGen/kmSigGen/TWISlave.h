@@ -32,12 +32,13 @@
 #define TWISLAVE_H_
 
 #ifndef KMSG_NO_TWI
+#ifndef _TESTS_ENV
 #include <avr/io.h>
 #include <util/twi.h>
 #include <avr/interrupt.h>
-
-volatile uint8_t buffer_address;
-volatile uint8_t rxbuffer[0xFF];
+#else
+#include "TWIMasterEmulator.h"
+#endif
 
 /** 
 This function needs to be called only once to set up the TWI to respond to the address passed into the function.
@@ -45,28 +46,122 @@ This function needs to be called only once to set up the TWI to respond to the a
 */
 void twiInit(uint8_t address);
 
+// range of 7bit addresses not reserved by I2C specification
+#define TWI_ADDRESS_MIN 0x08
+#define TWI_ADDRESS_MAX 0x77
+
+/**
+Changes address the slave responds to, buffers and bus health counters are kept.
+Transaction in progress is completed with the old address.
+@param address TWI address of the slave device (TWI_ADDRESS_MIN to TWI_ADDRESS_MAX)
+*/
+void twiSetAddress(uint8_t address);
+
+/**
+Returns address the slave responds to.
+@result TWI address of the slave device
+*/
+uint8_t twiGetAddress(void);
+
+#ifdef KMSG_TWI_AUTO_ADDRESS
 /**
-This function disables the TWI peripheral completely and therefore isolates the device from the bus.
+Finds free address on the bus, to be called before twiInit with interrupts enabled or not.
+After random delay (so boards powered together don't probe at the same time) addresses are
+probed from the first one upwards as master (start, address with write bit, stop), the first
+address not acknowledged by any device is returned. Address of the transfer that lost arbitration
+to other master is treated as taken.
+@param first first address to be probed
+@result free address or first in case all addresses up to TWI_ADDRESS_MAX are taken
 */
-void twiStop(void);
+uint8_t twiAutoAddress(uint8_t first);
+#endif
+
+// maximum number of words in single transaction (TWI/I2C write)
+#define TWI_TRANSACTION_WORDS (TWI_BUFFER_LENGTH / 4)
 
 /**
-Returns true in case new data is available in the buffer.
+Returns true in case complete transaction (all words of single TWI/I2C write) is available in the buffer.
 @result true in case data has been received and is available from the buffer 
 */
 bool twiIsDataInBuffer(void);
 
 /**
-Returns next data from the buffer. First it should be checked if data is available using twiIsDatainBuffer function.
-@result data from buffer
+Returns data byte of general call received since the previous call. Only the last byte is kept,
+so the main loop has to poll it at least once per general call (only with TWI_GENERAL_CALL_COMMIT).
+@param data received byte
+@result true in case general call has been received
+*/
+bool twiGetGeneralCall(uint8_t *data);
+
+/**
+Returns words of next transaction from the buffer. First it should be checked if data is available using twiIsDataInBuffer function.
+Words are assembled here from bytes stored by the interrupt, transaction which length isn't a multiple of 4 bytes
+is removed from the buffer and counted as dropped.
+@result words buffer for at least TWI_TRANSACTION_WORDS words of the transaction
+@result number of words in the transaction (0 for dropped transaction)
 */
-uint32_t twiGetDataFromBuffer(void);
+uint8_t twiGetTransaction(uint32_t *words);
+
+// TWI/I2C bus health counters
+typedef enum {
+	/// Writes dropped because they haven't fit into the buffers (the master got NACK)
+	/// or have been interrupted by bus error
+	TWI_STAT_OVERFLOWS = 0,
+	/// Writes dropped because their length wasn't a multiple of 4 bytes
+	TWI_STAT_LENGTH_ERRORS,
+	/// Bytes not acknowledged
+	TWI_STAT_NACKS,
+	/// Illegal start or stop conditions
+	TWI_STAT_BUS_ERRORS,
+	/// Addressed with general call
+	TWI_STAT_GENERAL_CALLS,
+	/// Completed reads of the register map
+	TWI_STAT_READS,
+	/// Completed writes (commands and register pointer)
+	TWI_STAT_WRITES,
+	TWI_STAT_COUNT
+} TwiStat;
+
+/**
+Returns value of bus health counter.
+@param stat counter to be returned
+@result number of events since twiInit or twiResetStats, saturated at UINT16_MAX
+*/
+uint16_t twiGetStat(TwiStat stat);
+
+/**
+Clears all bus health counters (and the longest interrupt time in case of TWI_ISR_TIMING).
+*/
+void twiResetStats(void);
+
+/**
+Returns number of transactions waiting in the buffer.
+@result number of transactions
+*/
+uint8_t twiGetTransactionsInBuffer(void);
+
+/**
+Returns number of words waiting in the buffer.
+@result number of words
+*/
+uint8_t twiGetWordsInBuffer(void);
+
+#ifdef TWI_ISR_TIMING
+/**
+Returns the longest execution time of TWI/I2C interrupt measured with Timer1 (running free with F_CPU / 8 clock).
+@result time in microseconds
+*/
+uint16_t twiGetIsrTimeMax(void);
+#endif
 
 /**
-Sets response to the command so it will be returned to master.
-@param response response word to be sent to master device
+Sets content of the register map returned to master. Single byte write from master sets
+the register pointer, following read returns registers from the pointer to the end of the map
+(auto-increment). Write of the commands resets the pointer to the beginning of the map.
+Content is copied when master starts reading, so single read is always consistent.
+@param registers TWI_REGISTERS_LENGTH bytes of the register map
 */
-void twiPutDataResponse(uint32_t response);
+void twiPutRegisters(const uint8_t *registers);
 
 // Interrupt vector
 ISR(TWI_vect);
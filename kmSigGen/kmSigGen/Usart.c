@@ -0,0 +1,141 @@
+/*
+ * Usart.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+
+#ifdef KMSG_USART
+#include <stdint.h>
+#include <stdbool.h>
+#ifndef _TESTS_ENV
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#else
+#include "UsartEmulator.h"
+#endif
+
+#include "Usart.h"
+
+#if !defined(KMSG_ATB) && !defined(_TESTS_ENV)
+#error "KMSG_USART requires KMSG_ATB, RXD/TXD pins (PD0/PD1) are used by LCD"
+#endif
+
+// baud rate register rounded to the nearest value (normal speed, F_CPU / 16)
+#define USART_UBRR ((F_CPU + USART_BAUD * 8UL) / (USART_BAUD * 16UL) - 1)
+
+// indices of round robin buffers are free running and masked on access,
+// so buffer sizes have to be power of two (up to 128)
+#define USART_RX_MASK (USART_RX_BUFFER_LENGTH - 1)
+#define USART_TX_MASK (USART_TX_BUFFER_LENGTH - 1)
+#if (USART_RX_BUFFER_LENGTH & USART_RX_MASK) != 0 || USART_RX_BUFFER_LENGTH > 128
+#error "USART_RX_BUFFER_LENGTH has to be power of two"
+#endif
+#if (USART_TX_BUFFER_LENGTH & USART_TX_MASK) != 0 || USART_TX_BUFFER_LENGTH > 128
+#error "USART_TX_BUFFER_LENGTH has to be power of two"
+#endif
+
+// single producer, single consumer round robin buffers, receive head and
+// transmit tail are written only by interrupts, the other indices only by the main loop
+static uint8_t _usartRxBuffer[USART_RX_BUFFER_LENGTH];
+static volatile uint8_t _usartRxHead = 0;
+static volatile uint8_t _usartRxTail = 0;
+static uint8_t _usartTxBuffer[USART_TX_BUFFER_LENGTH];
+static volatile uint8_t _usartTxHead = 0;
+static volatile uint8_t _usartTxTail = 0;
+
+static volatile uint16_t _usartRxOverflowCount = 0;
+
+// Implementation
+void usartInit(void) {
+	UBRRH = (uint8_t)(USART_UBRR >> 8);
+	UBRRL = (uint8_t)USART_UBRR;
+	UCSRA = 0;
+	// 8 data bits, no parity, 1 stop bit (URSEL selects UCSRC, shared with UBRRH)
+	UCSRC = _BV(URSEL) | _BV(UCSZ1) | _BV(UCSZ0);
+	// transmit interrupt is enabled only when there is data to be sent
+	UCSRB = _BV(RXCIE) | _BV(RXEN) | _BV(TXEN);
+}
+
+bool usartIsDataInBuffer(void) {
+	return (_usartRxHead != _usartRxTail);
+}
+
+uint8_t usartGetByte(void) {
+	uint8_t tail = _usartRxTail;
+	uint8_t result = _usartRxBuffer[tail & USART_RX_MASK];
+	_usartRxTail = tail + 1;
+	return result;
+}
+
+void usartPutByte(uint8_t data) {
+	uint8_t head = _usartTxHead;
+	while ((uint8_t)(head - _usartTxTail) >= USART_TX_BUFFER_LENGTH) {
+		// buffer is full, interrupt sends next byte
+#ifdef _TESTS_ENV
+		usartEmuTransmit();
+#endif
+		continue;
+	}
+	_usartTxBuffer[head & USART_TX_MASK] = data;
+	_usartTxHead = head + 1;
+	UCSRB |= _BV(UDRIE);
+}
+
+uint16_t usartGetOverflowCount(void) {
+	uint16_t result;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+		result = _usartRxOverflowCount;
+	}
+	return result;
+}
+
+ISR(USART_RXC_vect) {
+	// status has to be read before the data register
+	bool overrun = bit_is_set(UCSRA, DOR);
+	uint8_t data = UDR;
+	uint8_t head = _usartRxHead;
+	if ((uint8_t)(head - _usartRxTail) < USART_RX_BUFFER_LENGTH) {
+		_usartRxBuffer[head & USART_RX_MASK] = data;
+		_usartRxHead = head + 1;
+	} else {
+		overrun = true;
+	}
+	if (overrun == true && _usartRxOverflowCount < UINT16_MAX) {
+		_usartRxOverflowCount++;
+	}
+}
+
+ISR(USART_UDRE_vect) {
+	uint8_t tail = _usartTxTail;
+	if (_usartTxHead == tail) {
+		// nothing more to send
+		UCSRB &= ~_BV(UDRIE);
+		return;
+	}
+	UDR = _usartTxBuffer[tail & USART_TX_MASK];
+	_usartTxTail = tail + 1;
+}
+
+#endif
@@ -0,0 +1,81 @@
+/** @file
+ * @brief Interrupt driven USART driver with receive and transmit round robin buffers.
+ * Usart.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  References:
+ *  -# https://ww1.microchip.com/downloads/en/DeviceDoc/Microchip%208bit%20mcu%20AVR%20ATmega8A%20data%20sheet%2040001974A.pdf
+ */
+
+#ifndef USART_H_
+#define USART_H_
+
+#ifdef KMSG_USART
+#include <stdbool.h>
+#include <stdint.h>
+#ifndef _TESTS_ENV
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#else
+#include "UsartEmulator.h"
+#endif
+
+/**
+Initializes USART for 8N1 frames with USART_BAUD baud rate and enables its interrupts.
+Following definitions to be set in config.h file @n
+#define \b USART_BAUD baud rate (e.g. 38400) @n
+#define \b USART_RX_BUFFER_LENGTH size of the receive buffer, power of two (e.g. 64) @n
+#define \b USART_TX_BUFFER_LENGTH size of the transmit buffer, power of two (e.g. 16)
+*/
+void usartInit(void);
+
+/**
+Returns true in case received byte is available in the buffer.
+@result true in case byte has been received
+*/
+bool usartIsDataInBuffer(void);
+
+/**
+Returns next received byte from the buffer. First it should be checked if data is available using usartIsDataInBuffer function.
+@result received byte
+*/
+uint8_t usartGetByte(void);
+
+/**
+Puts byte into the transmit buffer, waits only in case the buffer is full.
+@param data byte to be sent
+*/
+void usartPutByte(uint8_t data);
+
+/**
+Returns number of bytes lost because receive buffer was full or the hardware overrun.
+@result number of lost bytes, saturated at UINT16_MAX
+*/
+uint16_t usartGetOverflowCount(void);
+
+// Interrupt vectors
+ISR(USART_RXC_vect);
+ISR(USART_UDRE_vect);
+
+#endif
+
+#endif /* USART_H_ */
@@ -0,0 +1,168 @@
+/*
+ * UsartEmulator.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifdef _TESTS_ENV
+
+#include <time.h>
+#include "config.h"
+#include "UsartEmulator.h"
+#include "Usart.h"
+#include "ExternalInterface.h"
+#include "SignalGeneratorAD9833.h"
+#include "StringTools.h"
+
+// 8N1 frame on the line: start bit, 8 data bits, stop bit
+#define USART_EMU_BITS_PER_BYTE 10
+// bytes sent by the device waiting for usartEmuReceive
+#define USART_EMU_LINE_LENGTH 256
+// command frame as parsed by ExternalInterface.c: sync, length, payload, CRC-8
+#define USART_EMU_SYNC 0xA5
+#define USART_EMU_STATUS_OK 0x00
+// reply without response word: sync, length, status, CRC-8
+#define USART_EMU_REPLY_LENGTH 4
+
+volatile uint8_t UDR = 0;
+volatile uint8_t UCSRA = 0;
+volatile uint8_t UCSRB = 0;
+volatile uint8_t UCSRC = 0;
+volatile uint8_t UBRRH = 0;
+volatile uint8_t UBRRL = 0;
+
+static uint8_t _usartEmuLine[USART_EMU_LINE_LENGTH];
+static uint16_t _usartEmuLineLength = 0;
+static UsartEmuStats _usartEmuStats;
+
+// private functions
+bool usartEmuCheckReply(void);
+
+// Implementation
+void usartEmuReset(void) {
+	_usartEmuLineLength = 0;
+	usartEmuResetStats();
+}
+
+void usartEmuSend(const uint8_t *data, uint16_t length) {
+	for (uint16_t i = 0; i < length; i++) {
+		// replies are sent on the other line at the same time
+		usartEmuTransmit();
+		UDR = data[i];
+		UCSRA |= _BV(RXC);
+		if ((UCSRB & _BV(RXEN)) != 0 && (UCSRB & _BV(RXCIE)) != 0) {
+			USART_RXC_vect();
+		}
+		UCSRA &= ~_BV(RXC);
+		_usartEmuStats.bytesReceived++;
+	}
+}
+
+void usartEmuTransmit(void) {
+	while ((UCSRB & _BV(UDRIE)) != 0) {
+		USART_UDRE_vect();
+		// interrupt disables itself instead of writing UDR once the buffer is empty
+		if ((UCSRB & _BV(UDRIE)) != 0) {
+			if (_usartEmuLineLength < USART_EMU_LINE_LENGTH) {
+				_usartEmuLine[_usartEmuLineLength++] = UDR;
+			}
+			_usartEmuStats.bytesTransmitted++;
+		}
+	}
+}
+
+uint16_t usartEmuReceive(uint8_t *buffer, uint16_t length) {
+	usartEmuTransmit();
+	uint16_t result = (_usartEmuLineLength < length) ? _usartEmuLineLength : length;
+	for (uint16_t i = 0; i < result; i++) {
+		buffer[i] = _usartEmuLine[i];
+	}
+	_usartEmuLineLength = 0;
+	return result;
+}
+
+void usartEmuResetStats(void) {
+	_usartEmuStats.bytesReceived = 0;
+	_usartEmuStats.bytesTransmitted = 0;
+	_usartEmuStats.badReplies = 0;
+}
+
+UsartEmuStats usartEmuGetStats(void) {
+	UsartEmuStats result = _usartEmuStats;
+	result.rxTimeUs = (uint64_t)result.bytesReceived * USART_EMU_BITS_PER_BYTE * 1000000UL / USART_BAUD;
+	result.txTimeUs = (uint64_t)result.bytesTransmitted * USART_EMU_BITS_PER_BYTE * 1000000UL / USART_BAUD;
+	return result;
+}
+
+/*
+ * Function usartEmuCheckReply
+ * Desc     checks that the device has replied to the last frame with success status
+ * Output   true in case of correct reply
+ */
+bool usartEmuCheckReply(void) {
+	uint8_t reply[USART_EMU_REPLY_LENGTH + 1];
+	if (usartEmuReceive(reply, sizeof(reply)) != USART_EMU_REPLY_LENGTH) {
+		return false;
+	}
+	uint8_t crc = strCrc8(strCrc8(0, reply[1]), reply[2]);
+	return (reply[0] == USART_EMU_SYNC && reply[1] == 1
+			&& reply[2] == USART_EMU_STATUS_OK && reply[3] == crc);
+}
+
+uint32_t usartEmuBenchmark(uint8_t burst, uint32_t commands) {
+	uint8_t frame[USART_FRAME_LENGTH + 3];
+	if (burst == 0 || burst > USART_FRAME_LENGTH / 4) {
+		burst = USART_FRAME_LENGTH / 4;
+	}
+	usartEmuReceive(frame, 0);
+	clock_t start = clock();
+	uint32_t sent = 0;
+	while (sent < commands) {
+		uint8_t count = (commands - sent < burst) ? commands - sent : burst;
+		uint8_t length = count * 4;
+		frame[0] = USART_EMU_SYNC;
+		frame[1] = length;
+		uint8_t crc = strCrc8(0, length);
+		for (uint8_t i = 0; i < length; i++) {
+			// frequency register commands MSB first, each one different from the previous one
+			uint32_t word = (0x01UL << 29) | ((sent + i / 4) & SG_FREQ_REG_MASK);
+			frame[2 + i] = word >> (24 - 8 * (i & 0x03));
+			crc = strCrc8(crc, frame[2 + i]);
+		}
+		frame[2 + length] = crc;
+		for (uint8_t i = 0; i < length + 3; i++) {
+			usartEmuSend(&frame[i], 1);
+			extLoop();
+		}
+		if (usartEmuCheckReply() == false) {
+			_usartEmuStats.badReplies++;
+		}
+		sent += count;
+	}
+	clock_t elapsed = clock() - start;
+	if (elapsed == 0) {
+		elapsed = 1;
+	}
+	return (uint64_t)commands * CLOCKS_PER_SEC / elapsed;
+}
+
+#endif
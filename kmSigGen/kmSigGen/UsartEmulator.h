@@ -0,0 +1,148 @@
+/** @file
+ * @brief Host-side serial line model feeding Usart.c interrupts with bytes of command frames.
+ * UsartEmulator.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Available only in test environment (_TESTS_ENV defined). In such case Usart.c
+ *  uses USART registers defined here instead of avr-libc ones. The host side of the line
+ *  passes every byte to USART_RXC_vect() and collects bytes sent with USART_UDRE_vect().
+ *  Line time is modeled with 10 bits (8N1) per byte at USART_BAUD.
+ *  Example of the host build (with own driver providing usr* functions used by ExternalInterface.c):
+ *  gcc -D_TESTS_ENV -DF_CPU=8000000UL -DKMSG_USART Usart.c UsartEmulator.c ExternalInterface.c
+ *  TWISlave.c TWIMasterEmulator.c SignalGeneratorAD9833.c StringTools.c driver.c
+ *
+ *  References:
+ * -# https://ww1.microchip.com/downloads/en/DeviceDoc/Microchip%208bit%20mcu%20AVR%20ATmega8A%20data%20sheet%2040001974A.pdf
+ */
+
+#ifndef USARTEMULATOR_H_
+#define USARTEMULATOR_H_
+
+#ifdef _TESTS_ENV
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// host replacements of avr-libc definitions used by Usart.c
+#ifndef _BV
+#define _BV(bit) (1 << (bit))
+#endif
+#define bit_is_set(sfr, bit) ((sfr) & _BV(bit))
+#define RXC 7
+#define DOR 3
+#define RXCIE 7
+#define UDRIE 5
+#define RXEN 4
+#define TXEN 3
+#define URSEL 7
+#define UCSZ1 2
+#define UCSZ0 1
+
+// interrupts are never nested on the host, so atomic blocks are plain blocks
+// (TWIMasterEmulator.h and EEPROMEmulator.h define the same)
+#ifndef ATOMIC_BLOCK
+#define ATOMIC_RESTORESTATE
+#define ATOMIC_BLOCK(type) for (uint8_t _usartEmuAtomic = 1; _usartEmuAtomic != 0; _usartEmuAtomic = 0)
+#define ISR(vector) void vector(void)
+#endif
+
+extern volatile uint8_t UDR;
+extern volatile uint8_t UCSRA;
+extern volatile uint8_t UCSRB;
+extern volatile uint8_t UCSRC;
+extern volatile uint8_t UBRRH;
+extern volatile uint8_t UBRRL;
+
+/**
+Interrupts of Usart.c, called by the line model for every byte.
+*/
+void USART_RXC_vect(void);
+void USART_UDRE_vect(void);
+
+/**
+Line traffic statistics collected since last usartEmuResetStats call.
+*/
+typedef struct {
+	/// bytes sent by the host (RX line of the device)
+	uint32_t bytesReceived;
+	/// bytes sent by the device (TX line of the device)
+	uint32_t bytesTransmitted;
+	/// reply frames with status other than success or with wrong CRC
+	uint32_t badReplies;
+	/// line time of received bytes in microseconds
+	uint32_t rxTimeUs;
+	/// line time of transmitted bytes in microseconds
+	uint32_t txTimeUs;
+} UsartEmuStats;
+
+/**
+Resets the line model and clears statistics. Usart.c state is kept, so usartInit has to be called separately.
+*/
+void usartEmuReset(void);
+
+/**
+Sends bytes to the device, every byte is passed to the receive interrupt.
+@param data bytes to be sent
+@param length number of bytes
+*/
+void usartEmuSend(const uint8_t *data, uint16_t length);
+
+/**
+Runs transmit interrupt as long as it's enabled, bytes sent by the device are collected by the host.
+Called also by usartPutByte when its buffer is full, as interrupts don't run concurrently on the host.
+*/
+void usartEmuTransmit(void);
+
+/**
+Returns bytes collected by the host since the previous call (usartEmuTransmit is called before).
+@param buffer result
+@param length size of the buffer, bytes not fitting into it are lost
+@result number of bytes returned
+*/
+uint16_t usartEmuReceive(uint8_t *buffer, uint16_t length);
+
+/**
+Clears statistics, to be called before transfers which traffic is to be measured.
+*/
+void usartEmuResetStats(void);
+
+/**
+Returns statistics collected since last usartEmuResetStats call.
+@result line traffic statistics
+*/
+UsartEmuStats usartEmuGetStats(void);
+
+/**
+Sends frames of frequency register commands, burst commands each, and checks reply of every frame
+(the same commands as twiEmuBenchmark). extLoop is called after every byte, as the main loop polls
+external interfaces faster than bytes arrive. usartInit has to be called before.
+Line rate can be calculated from usartEmuGetStats(): rxTimeUs for frames streamed without waiting
+(replies are sent on the other line at the same time), rxTimeUs + txTimeUs in case every reply is awaited.
+@param burst commands in single frame (up to USART_FRAME_LENGTH / 4)
+@param commands total number of commands
+@result commands executed per second of the host time
+*/
+uint32_t usartEmuBenchmark(uint8_t burst, uint32_t commands);
+
+#endif
+
+#endif /* USARTEMULATOR_H_ */
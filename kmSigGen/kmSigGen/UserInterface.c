@@ -29,9 +29,15 @@
 #ifndef _TESTS_ENV
 #include <avr/io.h>
 #include <util/delay.h>
+#else
+// pins of the button and rotary encoder (config.h), read by host replacements of Buttons.c and RotaryEncoder.c
+#define PC1 1
+#define PC2 2
+#define PC3 3
 #endif
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #ifndef KMSG_NO_STDIO
 #include <stdio.h>
 #endif
@@ -48,21 +54,42 @@
 #include "Settings.h"
 #include "ExternalInterface.h"
 #include "StringTools.h"
+#include "TWISlave.h"
 
-#define MENU_COORDS_SIZE_OF 4
+// fields of the main screen that need to be redrawn
+#define UI_MAIN_DIRTY_WAVE 0x01
+#define UI_MAIN_DIRTY_FREQ 0x02
+// position of the frequency field on the second line of the main screen (after wave type and '@')
+#define UI_MAIN_FREQ_POS (sizeof(STR_NONE) + sizeof(STR_FREQUENCY_SHORT) - 2)
 
 typedef struct  {
 	uint8_t x;
 	uint8_t y;
 } UInt8Pair;
 
+// frequency given by 4 digits after the dot in decimal representation
+#define UI_FREQ_DEC_SCALE 10000UL
+// SG_MAX_FREQ in decimal representation with MHz multiplier
+#define UI_FREQ_DEC_MAX_MEGA ((uint32_t)(SG_MAX_FREQ * UI_FREQ_DEC_SCALE / 1000000UL))
+
 typedef struct {
-	uint16_t frequencyHi;
-	uint16_t frequencyLo;
-	FreqMultiplier multiplier;
+	uint32_t freqReg;
 	UIWaveType waveType;
 } SignalGeneratorParams;
 
+// decimal representation of the frequency, used only for display and in frequency editor
+typedef struct {
+	uint32_t frequencyBcd; // packed BCD with 4 digits after the dot (e.g. 0x01234567 for 123.4567)
+	FreqMultiplier multiplier;
+	UIWaveType waveType;
+} FreqEditParams;
+
+// coefficients of conversion from the frequency register to decimal representation
+typedef struct {
+	uint32_t coef;
+	uint8_t shift;
+} FreqRange;
+
 typedef enum {
 	MENU_INIT = 0,
 	MENU_POWER_SAVE_SHOW,
@@ -71,21 +98,49 @@ typedef enum {
 	MENU_SPLASH_WAIT,
 	MENU_MAIN_SHOW,
 	MENU_MAIN,
-	MENU_SELECT_AMP_FREQ_WAVE_SHOW,
-	MENU_SELECT_AMP_FREQ_WAVE,
+	MENU_TABLE_SHOW,
+	MENU_TABLE_SELECT,
 	MENU_EDIT_FREQ_SHOW,
 	MENU_EDIT_FREQ_SELECT,
 	MENU_EDIT_FREQ,
-	MENU_EDIT_FREQ_APPLY,
-	MENU_EDIT_FREQ_CANCEL,
-	MENU_EDIT_WAVE_SHOW,
-	MENU_EDIT_WAVE,
-	MENU_LOAD_SAVE_SHOW,
-	MENU_LOAD_SAVE_SELECT,
-	MENU_PRESETS_SHOW,
-	MENU_PRESETS_SELECT
+	MENU_EDIT_ADDRESS_SHOW,
+	MENU_EDIT_ADDRESS
 } MenuStatess;
 
+// menus described by _menus table
+typedef enum {
+	UI_MENU_SELECT = 0,
+	UI_MENU_LOAD_SAVE,
+	UI_MENU_PRESETS,
+	UI_MENU_WAVE,
+	UI_MENU_APPLY,
+	UI_MENU_CANCEL
+} UIMenuId;
+
+// action executed when menu item is selected, meaning of param depends on action
+typedef enum {
+	MENU_ACTION_STATE = 0, // param - next menu state
+	MENU_ACTION_MENU, // param - UIMenuId of the child menu
+	MENU_ACTION_LOAD_SAVE, // param - LoadSave, continues with presets menu
+	MENU_ACTION_PRESET, // param - preset number
+	MENU_ACTION_WAVE, // param - UIWaveType
+	MENU_ACTION_FREQ_APPLY // param not used
+} UIMenuAction;
+
+typedef struct {
+	const char *text; // string in flash
+	UInt8Pair coords; // position of the selector, text is printed one character after
+	uint8_t action;
+	uint8_t param;
+} UIMenuItem;
+
+typedef struct {
+	const char *title; // string in flash printed at (0, 0), NULL if none
+	uint8_t currentItem; // item selected after menu is shown (1 - first item)
+	uint8_t itemNo;
+	const UIMenuItem *items; // table in flash
+} UIMenu;
+
 enum FreqSetupState {
 	FS_BOF = 0, // defines first item in the menu array _freqSetupState
 	FS_EOF = 11, // defines last item in the menu array _freqSetupState
@@ -110,6 +165,87 @@ typedef enum {
 	PRESET_SAVE = 1
 } LoadSave;
 
+static const char _strMenuReturn[] PROGMEM = STR_MENU_RETURN;
+static const char _strMenuFrequency[] PROGMEM = STR_MENU_FREQUENCY;
+static const char _strMenuWave[] PROGMEM = STR_MENU_WAVE;
+static const char _strMenuPresets[] PROGMEM = STR_MENU_PRESETS;
+static const char _strMenuLoad[] PROGMEM = STR_MENU_LOAD;
+static const char _strMenuSave[] PROGMEM = STR_MENU_SAVE;
+#ifndef KMSG_NO_TWI
+static const char _strMenuTwiAddress[] PROGMEM = STR_MENU_TWI_ADDRESS;
+#endif
+static const char _strMenuPreset1[] PROGMEM = STR_MENU_PRESET1;
+static const char _strMenuPreset2[] PROGMEM = STR_MENU_PRESET2;
+static const char _strMenuPreset3[] PROGMEM = STR_MENU_PRESET3;
+static const char _strMenuPreset4[] PROGMEM = STR_MENU_PRESET4;
+static const char _strMenuWaveSquare[] PROGMEM = STR_MENU_WAVE_SQUARE;
+static const char _strMenuWaveSine[] PROGMEM = STR_MENU_WAVE_SINE;
+static const char _strMenuWaveTriangle[] PROGMEM = STR_MENU_WAVE_TRIANGLE;
+static const char _strMenuWaveNone[] PROGMEM = STR_MENU_WAVE_NONE;
+static const char _strApply[] PROGMEM = STR_APPLY;
+static const char _strCancel[] PROGMEM = STR_CANCEL;
+static const char _strYes[] PROGMEM = STR_YES;
+static const char _strNo[] PROGMEM = STR_NO;
+#ifndef KMSG_NO_TWI
+static const char _strTwiAddress[] PROGMEM = STR_TWI_ADDRESS;
+#endif
+
+static const UIMenuItem _menuSelectItems[] PROGMEM = {
+	{ _strMenuReturn, { 0x00, 0x00 }, MENU_ACTION_STATE, MENU_MAIN_SHOW },
+	{ _strMenuFrequency, { 0x08, 0x00 }, MENU_ACTION_STATE, MENU_EDIT_FREQ_SHOW },
+	{ _strMenuWave, { 0x00, 0x01 }, MENU_ACTION_MENU, UI_MENU_WAVE },
+	{ _strMenuPresets, { 0x08, 0x01 }, MENU_ACTION_MENU, UI_MENU_LOAD_SAVE }
+};
+
+static const UIMenuItem _menuLoadSaveItems[] PROGMEM = {
+	{ _strMenuLoad, { 0x00, 0x00 }, MENU_ACTION_LOAD_SAVE, PRESET_LOAD },
+	{ _strMenuSave, { 0x00, 0x01 }, MENU_ACTION_LOAD_SAVE, PRESET_SAVE },
+#ifndef KMSG_NO_TWI
+	{ _strMenuTwiAddress, { 0x0C, 0x01 }, MENU_ACTION_STATE, MENU_EDIT_ADDRESS_SHOW }
+#endif
+};
+
+static const UIMenuItem _menuPresetsItems[] PROGMEM = {
+	{ _strMenuPreset1, { 0x00, 0x00 }, MENU_ACTION_PRESET, 1 },
+	{ _strMenuPreset2, { 0x08, 0x00 }, MENU_ACTION_PRESET, 2 },
+	{ _strMenuPreset3, { 0x00, 0x01 }, MENU_ACTION_PRESET, 3 },
+	{ _strMenuPreset4, { 0x08, 0x01 }, MENU_ACTION_PRESET, 4 }
+};
+
+static const UIMenuItem _menuWaveItems[] PROGMEM = {
+	{ _strMenuWaveSquare, { 0x00, 0x00 }, MENU_ACTION_WAVE, UI_SIG_SQUARE },
+	{ _strMenuWaveSine, { 0x08, 0x00 }, MENU_ACTION_WAVE, UI_SIG_SINE },
+	{ _strMenuWaveTriangle, { 0x00, 0x01 }, MENU_ACTION_WAVE, UI_SIG_TRIANGLE },
+	{ _strMenuWaveNone, { 0x08, 0x01 }, MENU_ACTION_WAVE, UI_SIG_NONE }
+};
+
+static const UIMenuItem _menuApplyItems[] PROGMEM = {
+	{ _strYes, { 0x07, 0x00 }, MENU_ACTION_FREQ_APPLY, 0 },
+	{ _strNo, { 0x0C, 0x00 }, MENU_ACTION_STATE, MENU_EDIT_FREQ_SHOW }
+};
+
+static const UIMenuItem _menuCancelItems[] PROGMEM = {
+	{ _strYes, { 0x07, 0x00 }, MENU_ACTION_STATE, MENU_MAIN_SHOW },
+	{ _strNo, { 0x0C, 0x00 }, MENU_ACTION_STATE, MENU_EDIT_FREQ_SHOW }
+};
+
+// indexed by UIMenuId
+static const UIMenu _menus[] PROGMEM = {
+	{ NULL, 1, 4, _menuSelectItems },
+	{ NULL, 1, sizeof(_menuLoadSaveItems) / sizeof(UIMenuItem), _menuLoadSaveItems },
+	{ NULL, 1, 4, _menuPresetsItems },
+	{ NULL, 1, 4, _menuWaveItems },
+	{ _strApply, 1, 2, _menuApplyItems },
+	{ _strCancel, 2, 2, _menuCancelItems }
+};
+
+// indexed by FreqMultiplier (from STR_MULT_NONE), coefficients are calculated at compile time
+static const FreqRange _freqRanges[] PROGMEM = {
+	{ SG_DEC_COEF(SG_MCLK * UI_FREQ_DEC_SCALE, 18), 18 },
+	{ SG_DEC_COEF(SG_MCLK * UI_FREQ_DEC_SCALE / 1000UL, 28), 28 },
+	{ SG_DEC_COEF(SG_MCLK * UI_FREQ_DEC_SCALE / 1000000UL, 28), 28 }
+};
+
 static const int8_t _freqSetupStates[] = {
 	FS_CANCEL,
 	FS_WAVE_TYPE,
@@ -126,10 +262,14 @@ static const int8_t _freqSetupStates[] = {
 };
 
 static bool _parametersChanged = false;
+#ifdef KMSG_LIVE_TUNE
+static bool _liveTunePending = false;
+static bool _liveTuneActive = false;
+#endif
 
 static uint8_t _menuTicks = 0;
 static uint8_t _menuItems = 0;
-static UInt8Pair _menuCoords[MENU_COORDS_SIZE_OF];
+static uint8_t _menuId = UI_MENU_SELECT;
 
 static uint8_t _menuState = MENU_INIT;
 static LoadSave _loadSave = PRESET_LOAD;
@@ -137,83 +277,84 @@ static LoadSave _loadSave = PRESET_LOAD;
 static int8_t _freqSetupCurrentState = FS_CANCEL;
 
 static SignalGeneratorParams _signalGeneratorParams;
-static SignalGeneratorParams _signalGeneratorParamsOnEdit;
-static SignalGeneratorParams _signalGeneratorParamsTmp;
+static FreqEditParams _freqEditParams;
 
 static uint16_t _timeout = UINT16_MAX;
+static uint8_t _mainScreenDirty = 0;
+static uint8_t _mainScreenRefreshTimeout = 0;
+#ifdef KMSG_MARQUEE_STEP_TIMEOUT
+static uint8_t _marqueeSteps = 0;
+static uint8_t _marqueePos = 0;
+static uint16_t _marqueeTimeout = 0;
+#endif
 static char _lcdStrBuffer[STR_INTERNAL_BUFFERS_SIZE_OF] = "";
+#ifndef KMSG_NO_TWI
+static uint8_t _twiAddressEdit = TWI_SLAVE_ADDRESS;
+#endif
 
 // private functions
-uint64_t usrSignalGeneratorParamsToFrequency(SignalGeneratorParams params);
-void usrFrequencyToSignalGeneratorParams(uint64_t frequency, SignalGeneratorParams *params);
+uint32_t usrFreqRegToDec(uint32_t freqReg, FreqMultiplier multiplier);
+void usrFreqRegToEditParams(uint32_t freqReg, FreqEditParams *params);
+uint32_t usrEditParamsToFreqReg(const FreqEditParams *params);
+void usrSetGeneratorParameters(const SignalGeneratorParams *params);
+void usrLiveTuneRequest(void);
+void usrLiveTuneRestore(void);
 void usrSetTimeout(uint16_t timeout);
 bool usrTimeoutLoop(void);
 void usrInitDisplayCharacters(void);
-int8_t usrRotValue(int8_t newValue, int8_t minValue, int8_t maxValue);
+int16_t usrRotValue(int16_t newValue, int16_t minValue, int16_t maxValue);
 void usrMenuSignalParameters(void);
+void usrMarqueeShow(uint8_t row, const char *str);
+uint16_t usrMarqueePassTimeout(void);
+void usrMarqueeLoop(void);
 inline void usrNextState(uint8_t nextState);
-void usrMenuShow(uint8_t itemNo, uint8_t currentItem, const char * menuItems[], const UInt8Pair menuCoords[]);
+void usrMenuGetItem(uint8_t itemNo, UIMenuItem *item);
+void usrMenuTableOpen(uint8_t menuId);
+void usrMenuShow(void);
 uint8_t usrGetMenuSelection();
-void usrMenuShow2(uint8_t currentItem, const char * menuItems[]);
-void usrMenuShow2WithText(uint8_t currentItem, const char *text, const char * menuItems[]);
-void usrMenuShow4(uint8_t currentItem, const char * menuItems[]);
+void usrMenuTableSelect(void);
 void usrMenuPowerSaveShow(void);
 void usrMenuPowerSave(void);
 void usrMenuSplash(void);
 inline void usrMenuSplashWait(void);
 inline void usrMenuMainShow(void);
 inline void usrMenuMain(void);
-void usrMenuSelectAmpFreqWaveShow(void);
-void usrMenuSelectAmpFreqWave(void);
-void usrMenuLoadSaveShow(void);
-void usrMenuLoadSaveSelect(void);
-void usrMenuPresetsShow(void);
-void usrMenuPresetsSelect(void);
+void usrMenuMainUpdate(void);
+void usrMenuPresetSelected(uint8_t presetNo);
 void usrMenuFreqShow(void);
-void updateMainMenuIfOnScreen(void);
+void usrInvalidateMainScreen(uint8_t fields);
 void usrMenuFreqSelect(void);
 void usrMenuFreqEdit(void);
 void usrMenuFreqApply(void);
-void usrMenuFreqCancel(void);
-void usrMenuWaveShow(void);
-inline void usrMenuWave(void);
+#ifndef KMSG_NO_TWI
+void usrMenuAddressShow(void);
+void usrMenuAddressEdit(void);
+#endif
 void usrMenuDispatcherLoop(void);
 
 // Implementation
-uint64_t usrSignalGeneratorParamsToFrequency(SignalGeneratorParams params) {
-	uint64_t result = ((uint64_t)params.frequencyHi * 10000 + (uint64_t)params.frequencyLo);
-	switch (params.multiplier) {
-		case STR_MULT_MEGA: {
-		result *= 1000ULL;
-		//no break
-		}
-		case STR_MULT_KILO: {
-		result *= 1000ULL;
-		//no break
-		}
-		default: {
-		// left empty intentionally
-		}
-	}
-	result /= 10;
-	return result;
+uint32_t usrFreqRegToDec(uint32_t freqReg, FreqMultiplier multiplier) {
+	FreqRange range;
+	memcpy_P(&range, &_freqRanges[multiplier - STR_MULT_NONE], sizeof(FreqRange));
+	return sgCalcDec(freqReg, range.coef, range.shift);
 }
 
-void usrFrequencyToSignalGeneratorParams(uint64_t frequency, SignalGeneratorParams *params) {
-	if (frequency >= 1000000000) {
-		params->multiplier = STR_MULT_MEGA;
-		frequency /= 100000;
+void usrFreqRegToEditParams(uint32_t freqReg, FreqEditParams *params) {
+	// the highest multiplier with at least one digit before the dot
+	FreqMultiplier multiplier = STR_MULT_MEGA;
+	uint32_t dec = usrFreqRegToDec(freqReg, multiplier);
+	while (dec < UI_FREQ_DEC_SCALE && multiplier != STR_MULT_NONE) {
+		multiplier--;
+		dec = usrFreqRegToDec(freqReg, multiplier);
 	}
-	else if (frequency >= 1000000) {
-		params->multiplier = STR_MULT_KILO;
-		frequency /= 100;
-	}
-	else {
-		params->multiplier = STR_MULT_NONE;
-		frequency *= 10;
-	}
-	params->frequencyHi = (uint16_t)(frequency / 10000ULL);
-	params->frequencyLo = (uint16_t)(frequency % 10000ULL);
+	params->multiplier = multiplier;
+	params->frequencyBcd = strBinToBcd(dec);
+}
+
+uint32_t usrEditParamsToFreqReg(const FreqEditParams *params) {
+	FreqRange range;
+	memcpy_P(&range, &_freqRanges[params->multiplier - STR_MULT_NONE], sizeof(FreqRange));
+	return sgCalcFreqReg(strBcdToBin(params->frequencyBcd), range.coef, range.shift);
 }
 
 bool usrIsParametersChangedAndReset(void) {
@@ -222,14 +363,36 @@ bool usrIsParametersChangedAndReset(void) {
 	return result;
 }
 
-uint64_t usrGetCurrentFrequency(void) {
-	return usrSignalGeneratorParamsToFrequency(_signalGeneratorParams);
+uint32_t usrGetCurrentFreqReg(void) {
+	return _signalGeneratorParams.freqReg;
 }
 
 UIWaveType usrGetWaveType(void) {
 	return _signalGeneratorParams.waveType;
 }
 
+void usrSetGeneratorParameters(const SignalGeneratorParams *params) {
+	setGeneratorParameters(params->freqReg, ui2sgWaveType(params->waveType));
+}
+
+void usrLiveTuneRequest(void) {
+#ifdef KMSG_LIVE_TUNE
+	// only marked here, so changes made before next usrLoop end with a single write
+	_liveTunePending = true;
+#endif
+}
+
+void usrLiveTuneRestore(void) {
+#ifdef KMSG_LIVE_TUNE
+	if (_liveTuneActive == true) {
+		// generator has edited values, bring back current parameters with one write
+		_liveTuneActive = false;
+		_liveTunePending = false;
+		_parametersChanged = true;
+	}
+#endif
+}
+
 void usrSetTimeout(uint16_t timeout) {
 	_timeout = timeout;
 }
@@ -248,7 +411,7 @@ bool usrTimeoutLoop(void) {
 return false;
 }
 
-void usrInit(uint64_t frequency, UIWaveType waveType) {
+void usrInit(uint32_t freqReg, UIWaveType waveType) {
 	lcdInit(LCD_COLS, LCD_ROWS, LCD_5x8DOTS);
 	lcdBegin(); // PORTD
 	lcdBacklight();
@@ -256,7 +419,7 @@ void usrInit(uint64_t frequency, UIWaveType waveType) {
 	rseInit(RSE_PIN1, RSE_PIN2);
 	btnInit(BUTTON_PIN);
 
-	usrFrequencyToSignalGeneratorParams(frequency, &_signalGeneratorParams);
+	_signalGeneratorParams.freqReg = freqReg;
 	_signalGeneratorParams.waveType = waveType;
 }
 
@@ -270,7 +433,7 @@ void usrInitDisplayCharacters(void) {
 	lcdCreateChar(LCD_WAVE_SINE_NO, LCD_WAVE_SINE);
 }
 
-int8_t usrRotValue(int8_t newValue, int8_t minValue, int8_t maxValue) {
+int16_t usrRotValue(int16_t newValue, int16_t minValue, int16_t maxValue) {
 	if (newValue < minValue) {
 		return maxValue;
 	}
@@ -281,46 +444,113 @@ int8_t usrRotValue(int8_t newValue, int8_t minValue, int8_t maxValue) {
 }
 
 void usrMenuSignalParameters(void) {
+	FreqEditParams displayParams;
+	usrFreqRegToEditParams(_signalGeneratorParams.freqReg, &displayParams);
 	strSignalParametersToStr(_lcdStrBuffer,
 			_signalGeneratorParams.waveType,
-			_signalGeneratorParams.frequencyHi,
-			_signalGeneratorParams.frequencyLo,
-			_signalGeneratorParams.multiplier);
+			displayParams.frequencyBcd,
+			displayParams.multiplier);
 	const char * wiFiAddress = extGetWifiAddress();
-	lcdSetCursor(0, 0);
 	if (strIsEmpty(wiFiAddress) == true) {
-		lcdPrint(STR_MENU_MAIN_SELECT);
+		usrMarqueeShow(0, STR_MENU_MAIN_SELECT);
 	}
 	else {
-		lcdPrint(wiFiAddress);
-		lcdFillSpacesToEndOfTheLine();
+		usrMarqueeShow(0, wiFiAddress);
 	}
 	lcdSetCursor(0, 1);
 	lcdPrint(_lcdStrBuffer);
 }
 
+void usrMarqueeShow(uint8_t row, const char *str) {
+#ifdef KMSG_MARQUEE_STEP_TIMEOUT
+	// display shift moves both rows, so it has to be reverted before DDRAM is rewritten
+	if (_marqueePos != 0) {
+		lcdHome();
+		_marqueePos = 0;
+	}
+	uint8_t length = strlen(str);
+	_marqueeSteps = (length > LCD_COLS) ? length - LCD_COLS : 0;
+	_marqueeTimeout = KMSG_MARQUEE_DWELL_TIMEOUT;
+#endif
+	// complete string (up to LCD_DDRAM_COLS) loaded into DDRAM once, also the invisible part
+	lcdSetCursor(0, row);
+	lcdPrint(str);
+	lcdFillSpacesToEndOfTheLine();
+}
+
+uint16_t usrMarqueePassTimeout(void) {
+#ifdef KMSG_MARQUEE_STEP_TIMEOUT
+	if (_marqueeSteps != 0) {
+		return KMSG_MARQUEE_DWELL_TIMEOUT * 2 + _marqueeSteps * KMSG_MARQUEE_STEP_TIMEOUT;
+	}
+#endif
+	return 0;
+}
+
+void usrMarqueeLoop(void) {
+#ifdef KMSG_MARQUEE_STEP_TIMEOUT
+	if (_marqueeSteps == 0) {
+		return;
+	}
+	if (_marqueeTimeout != 0) {
+		_marqueeTimeout--;
+		return;
+	}
+	if (_marqueePos < _marqueeSteps) {
+		// single shift command per step instead of rewriting characters
+		lcdScrollDisplayLeft();
+		_marqueePos++;
+		_marqueeTimeout = (_marqueePos < _marqueeSteps) ? KMSG_MARQUEE_STEP_TIMEOUT : KMSG_MARQUEE_DWELL_TIMEOUT;
+	} else {
+		// return home brings the display back to the original position, single pass only
+		// as display shift moves also the other row
+		lcdHome();
+		_marqueePos = 0;
+		_marqueeSteps = 0;
+	}
+#endif
+}
+
 void usrNextState(uint8_t nextState) {
 	_menuState = nextState;
 }
 
-void usrMenuShow(uint8_t itemNo, uint8_t currentItem, const char * menuItems[], const UInt8Pair menuCoords[]) {
-	_menuItems = 0;
-	_menuTicks = 0;
+void usrMenuGetItem(uint8_t itemNo, UIMenuItem *item) {
+	UIMenu menu;
+	memcpy_P(&menu, &_menus[_menuId], sizeof(UIMenu));
+	memcpy_P(item, &menu.items[itemNo], sizeof(UIMenuItem));
+}
+
+void usrMenuTableOpen(uint8_t menuId) {
+	_menuId = menuId;
+	usrNextState(MENU_TABLE_SHOW);
+}
+
+void usrMenuShow(void) {
+	UIMenu menu;
+	UIMenuItem item;
+	memcpy_P(&menu, &_menus[_menuId], sizeof(UIMenu));
 	lcdClear();
-	currentItem--; // convert from item number to loop number
-	for (int i = 0; i < itemNo; i++)  {
-		const char *menuItem = menuItems[i];
-		const UInt8Pair menuCoord = menuCoords[i];
-		_menuCoords[i] = menuCoords[i];
-		if (i == currentItem) {
-			lcdSetCursor(menuCoord.x, menuCoord.y);
-			lcdWrite(STR_MENU_SELECTOR_CHAR);
+	uint8_t currentItem = menu.currentItem - 1; // convert from item number to loop number
+	for (uint8_t i = 0; i < menu.itemNo; i++) {
+		memcpy_P(&item, &menu.items[i], sizeof(UIMenuItem));
+		// item representing current wave type is selected instead of the default one
+		if (item.action == MENU_ACTION_WAVE && item.param == _signalGeneratorParams.waveType) {
+			currentItem = i;
 		}
-		lcdSetCursor(menuCoord.x + 1, menuCoord.y);
-		lcdPrint(menuItem);
+		lcdSetCursor(item.coords.x + 1, item.coords.y);
+		lcdPrintP(item.text);
 	}
-	_menuItems = itemNo;
+	if (menu.title != NULL) {
+		lcdSetCursor(0, 0);
+		lcdPrintP(menu.title);
+	}
+	usrMenuGetItem(currentItem, &item);
+	lcdSetCursor(item.coords.x, item.coords.y);
+	lcdWrite(STR_MENU_SELECTOR_CHAR);
+	_menuItems = menu.itemNo;
 	_menuTicks = currentItem;
+	usrNextState(MENU_TABLE_SELECT);
 }
 
 uint8_t usrGetMenuSelection() {
@@ -337,46 +567,62 @@ uint8_t usrGetMenuSelection() {
 		int8_t currentMenuTicks = _menuTicks + rseCurrentValue;
 		currentMenuTicks %= rseMaxValue;
 		if (currentMenuTicks < 0 ) {
-			currentMenuTicks = rseMaxValue - currentMenuTicks - 2;
+			currentMenuTicks += rseMaxValue;
 		}
 		uint8_t currentMenuItem = currentMenuTicks;
 		_menuTicks = currentMenuTicks;
 		if (currentMenuItem != previousMenuItem) {
-			lcdSetCursor(_menuCoords[previousMenuItem].x, _menuCoords[previousMenuItem].y);
+			UIMenuItem item;
+			usrMenuGetItem(previousMenuItem, &item);
+			lcdSetCursor(item.coords.x, item.coords.y);
 			lcdWrite(STR_MENU_EMPTY_CHAR);
-			lcdSetCursor(_menuCoords[currentMenuItem].x, _menuCoords[currentMenuItem].y);
+			usrMenuGetItem(currentMenuItem, &item);
+			lcdSetCursor(item.coords.x, item.coords.y);
 			lcdWrite(STR_MENU_SELECTOR_CHAR);
 		}
 	}
 	return 0; // 0 means no menu selected
 }
 
-void usrMenuShow2(uint8_t currentItem, const char * menuItems[]) {
-	static const UInt8Pair menuCoords[] = {
-			{0x00, 0x00},
-			{0x00, 0x01}
-	};
-	usrMenuShow(2, currentItem, menuItems, menuCoords);
-}
-
-void usrMenuShow2WithText(uint8_t currentItem, const char *text, const char * menuItems[]) {
-	static const UInt8Pair menuCoords[] = {
-			{0x07, 0x00},
-			{0x0C, 0x00}
-	};
-	usrMenuShow(2, currentItem, menuItems, menuCoords);
-	lcdSetCursor(0, 0);
-	lcdPrint(text);
-}
-
-void usrMenuShow4(uint8_t currentItem, const char * menuItems[]) {
-	static const UInt8Pair menuCoords[] = {
-		{0x00, 0x00},
-		{0x08, 0x00},
-		{0x00, 0x01},
-		{0x08, 0x01}
-	};
-	usrMenuShow(4, currentItem, menuItems, menuCoords);
+void usrMenuTableSelect(void) {
+	const uint8_t menuSelection = usrGetMenuSelection();
+	if (menuSelection == 0) {
+		// button not pressed
+		return;
+	}
+	UIMenuItem item;
+	usrMenuGetItem(menuSelection - 1, &item);
+	switch (item.action) {
+		case MENU_ACTION_STATE : {
+			usrNextState(item.param);
+			break;
+		}
+		case MENU_ACTION_MENU : {
+			usrMenuTableOpen(item.param);
+			break;
+		}
+		case MENU_ACTION_LOAD_SAVE : {
+			_loadSave = (LoadSave)item.param;
+			usrMenuTableOpen(UI_MENU_PRESETS);
+			break;
+		}
+		case MENU_ACTION_PRESET : {
+			usrMenuPresetSelected(item.param);
+			usrNextState(MENU_MAIN_SHOW);
+			break;
+		}
+		case MENU_ACTION_WAVE : {
+			_signalGeneratorParams.waveType = (UIWaveType)item.param;
+			_parametersChanged = true;
+			usrNextState(MENU_MAIN_SHOW);
+			break;
+		}
+		case MENU_ACTION_FREQ_APPLY : {
+			usrMenuFreqApply();
+			usrNextState(MENU_MAIN_SHOW);
+			break;
+		}
+	}
 }
 
 void usrMenuPowerSaveShow(void) {
@@ -396,22 +642,24 @@ void usrMenuPowerSave(void) {
 }
 
 void usrMenuSplash(void) {
-	usrSetTimeout(KMSG_SPLASH_SCREEN_TIMEOUT);
 	lcdClear();
 	lcdPrint(APP_NAME " " APP_VERSION);
 	usrNextState(MENU_SPLASH_WAIT);
 	btnReset();
 	usrInitDisplayCharacters();
-	lcdSetCursor(0, 1);
-	lcdPrint(extGetSplashString());
-	lcdFillSpacesToEndOfTheLine();
+	usrMarqueeShow(1, extGetSplashString());
+	usrSetTimeout(KMSG_SPLASH_SCREEN_TIMEOUT + usrMarqueePassTimeout());
 }
 
 void usrMenuSplashWait(void) {
 	if (extIsSplashStringChanged() == true) {
-		lcdSetCursor(0, 1);
-		lcdPrint(extGetSplashString());
+		usrMarqueeShow(1, extGetSplashString());
+		// long splash string stays on screen until it's scrolled once
+		if (usrMarqueePassTimeout() != 0) {
+			usrSetTimeout(usrMarqueePassTimeout());
+		}
 	}
+	usrMarqueeLoop();
 	if (usrTimeoutLoop() == true || btnPressed() == true) {
 		usrNextState(MENU_MAIN_SHOW);
 		btnReset();
@@ -419,8 +667,11 @@ void usrMenuSplashWait(void) {
 }
 
 void usrMenuMainShow(void) {
+	usrLiveTuneRestore();
 	lcdClear();
 	usrMenuSignalParameters();
+	_mainScreenDirty = 0;
+	_mainScreenRefreshTimeout = 0;
 	usrNextState(MENU_MAIN);
 #ifdef KMSG_SCREEN_SAVER_TIMEOUT
 	usrSetTimeout(KMSG_SCREEN_SAVER_TIMEOUT); // power saver after 30 sec
@@ -434,167 +685,101 @@ void usrMenuMain(void) {
 	}
 	if (btnPressed() == true) {
 		btnReset();
-		usrNextState(MENU_SELECT_AMP_FREQ_WAVE_SHOW);
+		usrMenuTableOpen(UI_MENU_SELECT);
 	}
 	if(extIsWifiAddressChanged() == true) {
-		lcdSetCursor(0, 0);
-		lcdPrint(extGetWifiAddress());
-		lcdFillSpacesToEndOfTheLine();
+		usrMarqueeShow(0, extGetWifiAddress());
+	}
+	usrMarqueeLoop();
+	// redraw fields changed from external interface, but not more often than
+	// once per KMSG_MAIN_SCREEN_REFRESH_TIMEOUT loops
+	if (_mainScreenRefreshTimeout != 0) {
+		_mainScreenRefreshTimeout--;
+	} else if (_mainScreenDirty != 0) {
+		usrMenuMainUpdate();
+		_mainScreenRefreshTimeout = KMSG_MAIN_SCREEN_REFRESH_TIMEOUT;
 	}
 }
 
-void usrMenuSelectAmpFreqWaveShow(void) {
-	lcdClear();
-	static const char * menuItems[] = {
-			STR_MENU_RETURN,
-			STR_MENU_FREQUENCY,
-			STR_MENU_WAVE,
-			STR_MENU_PRESETS
-	};
-	usrMenuShow4(1, menuItems);
-	usrNextState(MENU_SELECT_AMP_FREQ_WAVE);
-}
-
-void usrMenuSelectAmpFreqWave(void) {
-	uint8_t menuSelection = usrGetMenuSelection();
-	switch (menuSelection) {
-		// Return
-		case 1 : {
-			usrNextState(MENU_MAIN_SHOW);
-			break;
-		}
-		// Frequency
-		case 2 : {
-			usrNextState(MENU_EDIT_FREQ_SHOW);
-			break;
-		}
-		// Wave
-		case 3 : {
-			usrNextState(MENU_EDIT_WAVE_SHOW);
-			break;
-		}
-		// Presets
-		case 4 : {
-			usrNextState(MENU_LOAD_SAVE_SHOW);
-			break;
-		}
-		default : {
-			// button not pressed
-		}
+void usrMenuMainUpdate(void) {
+	if ((_mainScreenDirty & UI_MAIN_DIRTY_WAVE) != 0) {
+		lcdSetCursor(0, 1);
+		lcdPrint(strWaveTypeToStr(_signalGeneratorParams.waveType));
 	}
+	if ((_mainScreenDirty & UI_MAIN_DIRTY_FREQ) != 0) {
+		FreqEditParams displayParams;
+		usrFreqRegToEditParams(_signalGeneratorParams.freqReg, &displayParams);
+		strSignalFrequencyToStr(_lcdStrBuffer, displayParams.frequencyBcd);
+		lcdSetCursor(UI_MAIN_FREQ_POS, 1);
+		lcdPrint(_lcdStrBuffer);
+		lcdPrint(strSignalMultiplierToStr(displayParams.multiplier));
+	}
+	_mainScreenDirty = 0;
 }
 
-void usrMenuLoadSaveShow(void) {
-	lcdClear();
-	static const char * menuItems[] = {
-			STR_MENU_LOAD,
-			STR_MENU_SAVE,
-	};
-	usrMenuShow2(1, menuItems);
-	usrNextState(MENU_LOAD_SAVE_SELECT);
-
-}
-
-void usrMenuLoadSaveSelect(void) {
-	uint8_t menuSelection = usrGetMenuSelection();
-	switch (menuSelection) {
-		// Load
-		case 1 : {
-			_loadSave = PRESET_LOAD;
-			usrNextState(MENU_PRESETS_SHOW);
-			break;
-		}
-		// Save
-		case 2 : {
-			_loadSave = PRESET_SAVE;
-			usrNextState(MENU_PRESETS_SHOW);
+void usrMenuPresetSelected(uint8_t presetNo) {
+	switch (_loadSave) {
+		case PRESET_LOAD : {
+			settingsGetPreset(presetNo, &_signalGeneratorParams.waveType, &_signalGeneratorParams.freqReg);
+			_parametersChanged = true;
 			break;
 		}
-		default : {
-			// button not pressed
-		}
-	}
-}
-
-void usrMenuPresetsShow(void) {
-	lcdClear();
-	static const char * menuItems[] = {
-			STR_MENU_PRESET1,
-			STR_MENU_PRESET2,
-			STR_MENU_PRESET3,
-			STR_MENU_PRESET4
-	};
-	usrMenuShow4(1, menuItems);
-	usrNextState(MENU_PRESETS_SELECT);
-}
-
-void usrMenuPresetsSelect(void) {
-	uint8_t menuSelection = usrGetMenuSelection();
-	if (menuSelection > 0) {
-		switch (_loadSave) {
-			case PRESET_LOAD : {
-				UIWaveType waveType = UI_SIG_NONE;
-				uint64_t frequency = 0;
-				settingsGetPreset(menuSelection, &waveType, &frequency);
-				usrFrequencyToSignalGeneratorParams(frequency, &_signalGeneratorParams);
-				_signalGeneratorParams.waveType = waveType;
-				_parametersChanged = true;
-				break;
-			}
-			case PRESET_SAVE : {
+		case PRESET_SAVE : {
 #ifndef KMSG_NO_EEPROM
-				uint64_t frequency = usrSignalGeneratorParamsToFrequency(_signalGeneratorParams);
-				settingsSavePreset(menuSelection, _signalGeneratorParams.waveType, frequency);
-				break;
+			settingsSavePreset(presetNo, _signalGeneratorParams.waveType, _signalGeneratorParams.freqReg);
 #endif
-			}
+			break;
 		}
-	usrNextState(MENU_MAIN_SHOW);
 	}
 }
 
 void usrMenuFreqShow(void) {
+	usrLiveTuneRestore();
 	lcdClear();
 	_freqSetupCurrentState = FS_CANCEL;
 	lcdSetCursor(_freqSetupCurrentState, 0);
 	lcdWrite(LCD_CURSOR_DOWN_NO);
-	strSignalFrequencyToStr(_lcdStrBuffer,
-		_signalGeneratorParams.frequencyHi,
-		_signalGeneratorParams.frequencyLo);
+	usrFreqRegToEditParams(_signalGeneratorParams.freqReg, &_freqEditParams);
+	_freqEditParams.waveType = _signalGeneratorParams.waveType;
+	strSignalFrequencyToStr(_lcdStrBuffer, _freqEditParams.frequencyBcd);
 	lcdSetCursor(FS_CANCEL, 1);
 	lcdWrite(LCD_CURSOR_LEFT_NO);
-	lcdWrite(strWaveTypeToSingleChar(_signalGeneratorParams.waveType));
+	lcdWrite(strWaveTypeToSingleChar(_freqEditParams.waveType));
 	lcdWrite(STR_FREQUENCY_SHORT_CHAR);
 	lcdPrint(_lcdStrBuffer); // formatted signal frequency
-	lcdPrint(strSignalMultiplierToStr(_signalGeneratorParams.multiplier));
+	lcdPrint(strSignalMultiplierToStr(_freqEditParams.multiplier));
 	lcdSetCursor(FS_APPLY, 1);
 	lcdWrite(LCD_CHAR_CHECK_MARK_NO);
 	usrNextState(MENU_EDIT_FREQ_SELECT);
-	_signalGeneratorParamsOnEdit = _signalGeneratorParams;
 }
 
-void updateMainMenuIfOnScreen(void) {
-	if (_menuState == MENU_MAIN) {
-		usrMenuMainShow();
-	}
+void usrInvalidateMainScreen(uint8_t fields) {
+	// only marks fields to be redrawn, the main screen is refreshed in usrMenuMain
+	// so external updates neither clear the screen nor re-arm the screen saver
+	_mainScreenDirty |= fields;
 }
 
-void usrSetFrequency(uint64_t frequency) {
-	// recalculate frequency to on-screen structure
-	usrFrequencyToSignalGeneratorParams(frequency, &_signalGeneratorParamsTmp);
-	// copy wave type from current settings
-	_signalGeneratorParamsTmp.waveType = _signalGeneratorParams.waveType;
-	// copy into current value
-	_signalGeneratorParams = _signalGeneratorParamsTmp;
+void usrSetFreqReg(uint32_t freqReg) {
+	_signalGeneratorParams.freqReg = freqReg & SG_FREQ_REG_MASK;
 	// mark parameters as changed so new value will be passed to signal generator
 	_parametersChanged = true;
-	updateMainMenuIfOnScreen();
+	usrInvalidateMainScreen(UI_MAIN_DIRTY_FREQ);
 }
 
 void usrSetWaveType(UIWaveType waveType) {
 	_signalGeneratorParams.waveType = waveType;
 	_parametersChanged = true;
-	updateMainMenuIfOnScreen();
+	usrInvalidateMainScreen(UI_MAIN_DIRTY_WAVE);
+}
+
+void usrSyncParameters(uint32_t freqReg, UIWaveType waveType) {
+	_signalGeneratorParams.freqReg = freqReg & SG_FREQ_REG_MASK;
+	_signalGeneratorParams.waveType = waveType;
+#ifdef KMSG_LIVE_TUNE
+	// generator holds current parameters again, nothing to restore after editing
+	_liveTuneActive = false;
+#endif
+	usrInvalidateMainScreen(UI_MAIN_DIRTY_WAVE | UI_MAIN_DIRTY_FREQ);
 }
 
 void usrMenuFreqSelect(void) {
@@ -602,22 +787,20 @@ void usrMenuFreqSelect(void) {
 		btnReset();
 		switch (_freqSetupStates[_freqSetupCurrentState]) {
 			case FS_CANCEL : {
-				static const char * menuItems[] = { STR_YES, STR_NO };
-				usrMenuShow2WithText(2, STR_CANCEL, menuItems);
-				usrNextState(MENU_EDIT_FREQ_CANCEL);
+				usrMenuTableOpen(UI_MENU_CANCEL);
 				break;
 			}
 			case FS_APPLY : {
-				static const char * menuItems[] = { STR_YES, STR_NO };
-				usrMenuShow2WithText(1, STR_APPLY, menuItems);
-				uint64_t freq = sgCalcNearestFreq(usrSignalGeneratorParamsToFrequency(_signalGeneratorParamsOnEdit));
-				usrFrequencyToSignalGeneratorParams(freq, &_signalGeneratorParamsTmp);
-				strSignalFrequencyToStr(_lcdStrBuffer, _signalGeneratorParamsTmp.frequencyHi, _signalGeneratorParamsTmp.frequencyLo);
+				// menu shown at once, the second line shows frequency to be set
+				_menuId = UI_MENU_APPLY;
+				usrMenuShow();
+				FreqEditParams nearestParams;
+				usrFreqRegToEditParams(usrEditParamsToFreqReg(&_freqEditParams), &nearestParams);
+				strSignalFrequencyToStr(_lcdStrBuffer, nearestParams.frequencyBcd);
 				lcdSetCursor(0, 1);
 				lcdWrite('~');
 				lcdPrint(_lcdStrBuffer);
-				lcdPrint(strSignalMultiplierToStr(_signalGeneratorParamsTmp.multiplier));
-				usrNextState(MENU_EDIT_FREQ_APPLY);
+				lcdPrint(strSignalMultiplierToStr(nearestParams.multiplier));
 				break;
 			}
 			default : {
@@ -647,177 +830,83 @@ void usrMenuFreqEdit(void) {
 	const int8_t rseCurrentValue = rseGetLastChangeAndReset();
 	if (rseCurrentValue != 0) {
 		lcdSetCursor(_freqSetupStates[_freqSetupCurrentState], 1);
-		int16_t frequencyHi = _signalGeneratorParamsOnEdit.frequencyHi;
-		int16_t frequencyLo = _signalGeneratorParamsOnEdit.frequencyLo;
-		switch (_freqSetupStates[_freqSetupCurrentState]) {
+		uint32_t frequencyBcd = _freqEditParams.frequencyBcd;
+		const int8_t freqSetupState = _freqSetupStates[_freqSetupCurrentState];
+		switch (freqSetupState) {
 			case FS_WAVE_TYPE : {
-				_signalGeneratorParamsOnEdit.waveType = (UIWaveType)
-						usrRotValue(_signalGeneratorParamsOnEdit.waveType + rseCurrentValue, UI_SIG_SQUARE, UI_SIG_NONE);
-				lcdWrite(strWaveTypeToSingleChar(_signalGeneratorParamsOnEdit.waveType));
+				_freqEditParams.waveType = (UIWaveType)
+						usrRotValue(_freqEditParams.waveType + rseCurrentValue, UI_SIG_SQUARE, UI_SIG_NONE);
+				lcdWrite(strWaveTypeToSingleChar(_freqEditParams.waveType));
+				usrLiveTuneRequest();
 				break;
 			}
 			case FS_MULT : {
-				_signalGeneratorParamsOnEdit.multiplier = (FreqMultiplier)
-						usrRotValue(_signalGeneratorParamsOnEdit.multiplier + rseCurrentValue, STR_MULT_NONE, STR_MULT_MEGA);
-				lcdPrint(strSignalMultiplierToStr(_signalGeneratorParamsOnEdit.multiplier));
+				_freqEditParams.multiplier = (FreqMultiplier)
+						usrRotValue(_freqEditParams.multiplier + rseCurrentValue, STR_MULT_NONE, STR_MULT_MEGA);
+				lcdPrint(strSignalMultiplierToStr(_freqEditParams.multiplier));
+				usrLiveTuneRequest();
 				break;
 			}
-			case FS_1000 : {
-				frequencyHi += rseCurrentValue * 1000;
-				break;
-			}
-			case FS_100 : {
-				frequencyHi += rseCurrentValue * 100;
-				break;
-			}
-			case FS_10 : {
-				frequencyHi += rseCurrentValue * 10;
-				break;
-			}
-			case FS_1 : {
-				frequencyHi += rseCurrentValue;
-				break;
-			}
-			case FS_1_10 : {
-				frequencyLo += rseCurrentValue * 1000;
-				break;
-			}
-			case FS_1_100 : {
-				frequencyLo += rseCurrentValue * 100;
-				break;
-			}
-			case FS_1_1000 : {
-				frequencyLo += rseCurrentValue * 10;
-				break;
-			}
-			case FS_1_10000 : {
-				frequencyLo += rseCurrentValue;
-				break;
+			default : {
+				// BCD digit under the cursor, FS_1000 - FS_1 before the dot and FS_1_10 - FS_1_10000 after it
+				uint8_t digit = (freqSetupState < FS_DOT) ? (FS_1 - freqSetupState + 4) : (FS_1_10000 - freqSetupState);
+				frequencyBcd = strBcdAddToDigit(frequencyBcd, digit, rseCurrentValue);
 			}
 		}
-		if (frequencyLo < 0) {
-			frequencyLo += 10000;
-			frequencyHi--;
-		}
-		if (frequencyLo > 9999) {
-			frequencyLo = 0;
-			frequencyHi++;
-		}
-		if (frequencyHi < 0) {
-			frequencyHi = 0;
-		}
-		if (frequencyHi > 999) {
-			frequencyHi = 999;
+		if (_freqEditParams.multiplier == STR_MULT_MEGA &&
+			strBcdToBin(frequencyBcd) > UI_FREQ_DEC_MAX_MEGA) {
+			frequencyBcd = strBinToBcd(UI_FREQ_DEC_MAX_MEGA);
 		}
-		if (_signalGeneratorParamsOnEdit.multiplier == STR_MULT_MEGA) {
-			SignalGeneratorParams tmpGeneratorParams = _signalGeneratorParamsOnEdit;
-			tmpGeneratorParams.frequencyHi = frequencyHi;
-			tmpGeneratorParams.frequencyLo = frequencyLo;
-
-			uint64_t freq = usrSignalGeneratorParamsToFrequency(tmpGeneratorParams);
-			if (freq > (uint64_t)SG_MAX_FREQ * (uint64_t)1000ULL) {
-				freq = (uint64_t)SG_MAX_FREQ * (uint64_t)1000ULL;
-				usrFrequencyToSignalGeneratorParams(freq, &tmpGeneratorParams);
-				frequencyHi = tmpGeneratorParams.frequencyHi;
-				frequencyLo = tmpGeneratorParams.frequencyLo;
-			}
-		}
-		if (_signalGeneratorParamsOnEdit.frequencyHi != (uint16_t)frequencyHi ||
-			_signalGeneratorParamsOnEdit.frequencyLo != (uint16_t)frequencyLo) {
-			strSignalFrequencyToStr(_lcdStrBuffer,
-					frequencyHi,
-					frequencyLo);
+		if (_freqEditParams.frequencyBcd != frequencyBcd) {
+			strSignalFrequencyToStr(_lcdStrBuffer, frequencyBcd);
 			lcdSetCursor(FS_1000, 1);
 			lcdPrint(_lcdStrBuffer);
-			_signalGeneratorParamsOnEdit.frequencyHi = frequencyHi;
-			_signalGeneratorParamsOnEdit.frequencyLo = frequencyLo;
+			_freqEditParams.frequencyBcd = frequencyBcd;
+			usrLiveTuneRequest();
 		}
 	lcdSetCursor(_freqSetupStates[_freqSetupCurrentState], 1);
 	}
 }
 
 void usrMenuFreqApply(void) {
-	switch (usrGetMenuSelection()) {
-		case 1 : {
-#ifdef KMSG_SHOW_APPROX_FREQ
-			_signalGeneratorParams = _signalGeneratorParamsOnEdit;
-#else
-			SignalGeneratorParams signalRecalcParameters = _signalGeneratorParamsOnEdit;
-			uint64_t freq = sgCalcNearestFreq(usrSignalGeneratorParamsToFrequency(signalRecalcParameters));
-			usrFrequencyToSignalGeneratorParams(freq, &signalRecalcParameters);
-			_signalGeneratorParams = signalRecalcParameters;
-#endif
-			_parametersChanged = true;
-			usrNextState(MENU_MAIN_SHOW);
-			break;
-		}
-		case 2 : {
-			usrNextState(MENU_EDIT_FREQ_SHOW);
-			break;
-		}
-	}
+	_signalGeneratorParams.freqReg = usrEditParamsToFreqReg(&_freqEditParams);
+	_signalGeneratorParams.waveType = _freqEditParams.waveType;
+	_parametersChanged = true;
 }
 
-void usrMenuFreqCancel(void) {
-	uint8_t menuSelection = usrGetMenuSelection();
-
-	switch (menuSelection) {
-		// Yes selected
-		case 1 : {
-			usrNextState(MENU_MAIN_SHOW);
-			break;
-		}
-		// No selected
-		case 2 : {
-			usrNextState(MENU_EDIT_FREQ_SHOW);
-			break;
-		}
-	}
+#ifndef KMSG_NO_TWI
+void usrMenuAddressShow(void) {
+	lcdClear();
+	lcdPrintP(_strTwiAddress);
+	_twiAddressEdit = twiGetAddress();
+	strByteToHexStr(_lcdStrBuffer, _twiAddressEdit);
+	lcdSetCursor(0, 1);
+	lcdPrint(_lcdStrBuffer);
+	usrNextState(MENU_EDIT_ADDRESS);
 }
 
-void usrMenuWaveShow(void) {
-	lcdClear();
-	btnReset();
-	static const char * menuItems[] = {
-			STR_MENU_WAVE_SQUARE,
-			STR_MENU_WAVE_SINE,
-			STR_MENU_WAVE_TRIANGLE,
-			STR_MENU_WAVE_NONE
-	};
-	// implicit conversion from waveType to menu number
-	usrMenuShow4(_signalGeneratorParams.waveType, menuItems);
-	usrNextState(MENU_EDIT_WAVE);
-}
-
-void usrMenuWave(void) {
-	const uint8_t menuSelection = usrGetMenuSelection();
-	switch (menuSelection) {
-		// Return
-		case 1 : {
-			_signalGeneratorParams.waveType = UI_SIG_SQUARE;
-			break;
-		}
-		// Frequency
-		case 2 : {
-			_signalGeneratorParams.waveType = UI_SIG_SINE;
-			break;
-		}
-		// Amplification
-		case 3 : {
-			_signalGeneratorParams.waveType = UI_SIG_TRIANGLE;
-			break;
-		}
-		// Wave
-		case 4 : {
-			_signalGeneratorParams.waveType = UI_SIG_NONE;
-			break;
+void usrMenuAddressEdit(void) {
+	if (btnPressed() == true) {
+		btnReset();
+		// new address is used immediately, EEPROM is written only if it's changed
+		if (_twiAddressEdit != twiGetAddress()) {
+#ifndef KMSG_NO_EEPROM
+			settingsSaveTwiAddress(_twiAddressEdit);
+#endif
+			twiSetAddress(_twiAddressEdit);
 		}
-	}
-	if (menuSelection != 0) {
 		usrNextState(MENU_MAIN_SHOW);
-		_parametersChanged = true;
+		return;
+	}
+	const int8_t rseCurrentValue = rseGetLastChangeAndReset();
+	if (rseCurrentValue != 0) {
+		_twiAddressEdit = usrRotValue(_twiAddressEdit + rseCurrentValue, TWI_ADDRESS_MIN, TWI_ADDRESS_MAX);
+		strByteToHexStr(_lcdStrBuffer, _twiAddressEdit);
+		lcdSetCursor(0, 1);
+		lcdPrint(_lcdStrBuffer);
 	}
 }
+#endif
 
 void usrMenuDispatcherLoop(void) {
 	switch (_menuState) {
@@ -849,28 +938,12 @@ void usrMenuDispatcherLoop(void) {
 			usrMenuMain();
 			break;
 		}
-		case MENU_SELECT_AMP_FREQ_WAVE_SHOW: {
-			usrMenuSelectAmpFreqWaveShow();
-			break;
-		}
-		case MENU_SELECT_AMP_FREQ_WAVE: {
-			usrMenuSelectAmpFreqWave();
-			break;
-		}
-		case MENU_LOAD_SAVE_SHOW: {
-			usrMenuLoadSaveShow();
+		case MENU_TABLE_SHOW: {
+			usrMenuShow();
 			break;
 		}
-		case MENU_LOAD_SAVE_SELECT: {
-			usrMenuLoadSaveSelect();
-			break;
-		}
-		case MENU_PRESETS_SHOW: {
-			usrMenuPresetsShow();
-			break;
-		}
-		case MENU_PRESETS_SELECT: {
-			usrMenuPresetsSelect();
+		case MENU_TABLE_SELECT: {
+			usrMenuTableSelect();
 			break;
 		}
 		case MENU_EDIT_FREQ_SHOW: {
@@ -885,22 +958,16 @@ void usrMenuDispatcherLoop(void) {
 			usrMenuFreqEdit();
 			break;
 		}
-		case MENU_EDIT_FREQ_APPLY: {
-			usrMenuFreqApply();
-			break;
-		}
-		case MENU_EDIT_FREQ_CANCEL: {
-			usrMenuFreqCancel();
+#ifndef KMSG_NO_TWI
+		case MENU_EDIT_ADDRESS_SHOW: {
+			usrMenuAddressShow();
 			break;
 		}
-		case MENU_EDIT_WAVE_SHOW: {
-			usrMenuWaveShow();
-			break;
-		}
-		case MENU_EDIT_WAVE: {
-			usrMenuWave();
+		case MENU_EDIT_ADDRESS: {
+			usrMenuAddressEdit();
 			break;
 		}
+#endif
 	}
 }
 
@@ -909,26 +976,16 @@ void usrLoop(void) {
 	btnLoop();
 	usrMenuDispatcherLoop();
 	if (usrIsParametersChangedAndReset() == true) {
-		SgWaveType waveType = SG_SIG_NONE;
-		switch (usrGetWaveType()) {
-			case UI_SIG_SINE : {
-				waveType = SG_SIG_SINE;
-				break;
-			}
-			case UI_SIG_SQUARE : {
-				waveType = SG_SIG_SQUARE;
-				break;
-			}
-			case UI_SIG_TRIANGLE : {
-				waveType = SG_SIG_TRIANGLE;
-				break;
-			}
-			default : {
-				waveType = SG_SIG_NONE;
-			}
-		}
-		setGeneratorParameters(usrGetCurrentFrequency(), waveType);
+		usrSetGeneratorParameters(&_signalGeneratorParams);
+	}
+#ifdef KMSG_LIVE_TUNE
+	// at most one write per loop, intermediate values from the editor are skipped
+	if (_liveTunePending == true) {
+		_liveTunePending = false;
+		_liveTuneActive = true;
+		setGeneratorParameters(usrEditParamsToFreqReg(&_freqEditParams), ui2sgWaveType(_freqEditParams.waveType));
 	}
+#endif
 }
 
 #endif /* USERINTERFACE_C_ */
@@ -46,10 +46,10 @@ typedef enum {
 
 /**
 Initialize and set startup frequency in User Interface.
-@param frequency Desired frequency in Hz multiplied by 1000
+@param freqReg 28bit value of the frequency register (e.g. SG_FREQ_REG(DEFAULT_FREQUENCY))
 @param waveType Wave Type
 */
-void usrInit(uint64_t frequency, UIWaveType waveType);
+void usrInit(uint32_t freqReg, UIWaveType waveType);
 
 /**
 To be periodically issued in the main loop.
@@ -65,15 +65,15 @@ bool usrIsParametersChangedAndReset(void);
 
 /**
 Returns current frequency as set in User Interface.
-@result Current Frequency in User Interface
+@result 28bit value of the frequency register
 */
-uint64_t usrGetCurrentFrequency(void);
+uint32_t usrGetCurrentFreqReg(void);
 
 /**
 Sets frequency in User Interface and updates Signal Generator accordingly.
-@param Frequency Desired frequency to be set
+@param freqReg 28bit value of the frequency register to be set
 */
-void usrSetFrequency(uint64_t frequency);
+void usrSetFreqReg(uint32_t freqReg);
 
 /**
 Returns current Wave Type as set in User Interface.
@@ -87,4 +87,13 @@ Sets Wave Type in User Interface and updates Signal Generator accordingly.
 */
 void usrSetWaveType(UIWaveType waveType);
 
+/**
+Updates frequency and Wave Type in User Interface after they have been already
+written to Signal Generator (e.g. by external module). Signal Generator is not
+written again, the main screen is refreshed in the background.
+@param freqReg 28bit value of the frequency register currently set in Signal Generator
+@param waveType Wave Type currently set in Signal Generator
+*/
+void usrSyncParameters(uint32_t freqReg, UIWaveType waveType);
+
 #endif /* USERINTERFACE_H_ */
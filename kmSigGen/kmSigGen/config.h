@@ -35,14 +35,53 @@
 //#define KMSG_LOCALE "localePl.h"
 
 // EEPROM definition of the ID/VER header
-#define KMSG_MAGIC "KMSG100"
+#define KMSG_MAGIC "KMSG101"
 // last byte is '\0' so it's 8 bytes
 #define KMSG_MAGIC_LENGTH 8
+// firmware version reported in TWI/I2C register map
+#define KMSG_VERSION_MAJOR 1
+#define KMSG_VERSION_MINOR 1
 #define KMSG_MAX_PRESETS 5
-
-// Definition of the TWI/I2C address (0xAD >> 1 ;-)
+// Keep presets and TWI/I2C address in the EEPROM journal written in background, saves interrupted by
+// power loss fall back to the previous value (uncomment line to enable, otherwise they are written directly)
+//#define KMSG_EEPROM_JOURNAL
+// Number of 8 byte records (value, sequence number, CRC-8) of the EEPROM journal keeping presets
+// and TWI/I2C address, each save writes the next record so the writes are spread over whole journal
+#define KMSG_JOURNAL_RECORDS 56
+// Number of journal records waiting in RAM for write to EEPROM (power of two), records are written
+// byte by byte from EE_RDY interrupt, so save blocks only when the queue is full
+#define KMSG_EEPROM_QUEUE 4
+
+// Definition of the default TWI/I2C address (0xAD >> 1 ;-), address set from the menu or with
+// 0x06/0x05 command is stored in EEPROM and used instead
 #define TWI_SLAVE_ADDRESS 0x56
-#define TWI_BUFFER_LENGTH 12
+// At first boot (no address stored in EEPROM) probe addresses from TWI_SLAVE_ADDRESS upwards as master
+// and claim the first one not acknowledged, so boards from one firmware image get unique addresses
+// (uncomment line to enable, boards powered together are separated by random delay up to 0.5 s)
+//#define KMSG_TWI_AUTO_ADDRESS
+// General call data byte selecting staged frequency on all generators on the bus at once,
+// executed with the next poll of external commands (uncomment line to enable 0x02 command and general call)
+//#define TWI_GENERAL_CALL_COMMIT 0x5A
+// maximum length of single TWI/I2C write in bytes, all words of one write are executed together
+#define TWI_BUFFER_LENGTH 64
+// bytes and TWI/I2C writes (transactions) waiting for execution, power of two
+#define TWI_BUFFER_BYTES 128
+#define TWI_BUFFER_TRANSACTIONS 4
+// Bulk string command (0x03) carrying whole splash or WiFi address string in single write
+// (uncomment line to enable, otherwise strings are sent 3 characters per 0x07 command)
+//#define KMSG_BULK_STRINGS
+// Register map of the device state (see ExternalInterface.h) returned by TWI/I2C reads after
+// the response word (uncomment line to enable, otherwise reads return only the response word)
+//#define TWI_REGISTER_MAP
+// size of the register map available for TWI/I2C reads
+#ifdef TWI_REGISTER_MAP
+#define TWI_REGISTERS_LENGTH 42
+#else
+#define TWI_REGISTERS_LENGTH 4
+#endif
+// Longest execution of TWI/I2C interrupt measured with Timer1 and reported in the register map
+// (uncomment line to enable measurement, needs TWI_REGISTER_MAP)
+//#define TWI_ISR_TIMING
 
 // Port / pin definition for SPI (communication with AD9833)
 #define SG_DDR DDRB
@@ -61,7 +100,11 @@
 #endif
 #define LCD_COLS 16
 #define LCD_ROWS 2
+// number of characters in a single line of LCD display data RAM (including invisible part)
+#define LCD_DDRAM_COLS 40
 #define STR_INTERNAL_BUFFERS_SIZE_OF LCD_COLS + 1
+// size of the splash and WiFi address strings received from external interface
+#define STR_EXTERNAL_BUFFERS_SIZE_OF (LCD_DDRAM_COLS + 1)
 
 #define DEBUG_DDR DDRB
 #define DEBUG_PORT PORTB
@@ -104,22 +147,67 @@
 // screen saver enabled after 30 s on the main screen (comment line ot disable screen saver)
 #define KMSG_SCREEN_SAVER_TIMEOUT 30000
 
+// main screen refreshed at most every 100 ms when parameters are changed from external interface
+// (signal generator itself is always updated immediately)
+#define KMSG_MAIN_SCREEN_REFRESH_TIMEOUT 100
+
 // splash screen timeout 1.5s
 #define KMSG_SPLASH_SCREEN_TIMEOUT 1500
 
+// splash and WiFi address strings longer than LCD_COLS scrolled once with display shift every 400 ms
+// (uncomment line to enable marquee, otherwise long strings are cut to LCD_COLS)
+//#define KMSG_MARQUEE_STEP_TIMEOUT 400
+// long string shown still for 2 s before and after scrolling
+#define KMSG_MARQUEE_DWELL_TIMEOUT 2000
+
 // Misc/internal
+// Timer1 runs free with F_CPU / 8 clock, it's a time base for TWI_ISR_TIMING and KMSG_HOP
+// Main loop waits 1 ms per iteration (timeouts are counted in loop iterations),
+// external commands are polled 10 times during the wait
+#define KMSG_LOOP_DELAY_US 1000
+#define KMSG_LOOP_DELAY_STEPS 10
+// At most 16 words of queued TWI/I2C writes are executed in single poll, before
+// the last frequency and wave type are written to the generator
+#define KMSG_EXT_WORDS_BUDGET 16
+
 // Disable using stdio (e.g. sprintf) and use alternative implementation
 #define KMSG_NO_STDIO
 
 // Disable using EEPROM memory routines (settings) and use predefined presets instead
 //#define KMSG_NO_EEPROM
 
-// Show approximate frequencies entered by user instead of real frequency from generator
-#define KMSG_SHOW_APPROX_FREQ
+// Pass every change made in frequency editor to the generator immediately (cancel restores previous frequency)
+// (uncomment line to enable, otherwise the generator is updated only after changes are applied)
+//#define KMSG_LIVE_TUNE
 
 // Disable TwoWire (I2C) routines so it's not possible to control module from external interface
 //#define KMSG_NO_TWI
 
+// Binary command interface on USART (uncomment line to enable), frames carry the same 4 byte
+// commands as TWI/I2C writes; needs KMSG_ATB as RXD/TXD pins are used by LCD on the default board
+//#define KMSG_USART
+// frames executed per second, measured on the line model (kmSigGenTests/TestUsart): single command
+// 548 streamed / 349 awaiting every reply, 32 commands 938 / 910 (TWI/I2C at 100 kHz: 2127 / 2725)
+#define USART_BAUD 38400UL
+// received and transmitted bytes waiting in the buffers, power of two
+#define USART_RX_BUFFER_LENGTH 64
+#define USART_TX_BUFFER_LENGTH 16
+// maximum payload of single USART frame in bytes (multiple of 4, up to 252)
+#define USART_FRAME_LENGTH 128
+// SCPI text commands on USART between binary frames: FREQ, FREQ?, FUNC, SWE:STAR, *IDN?
+// (uncomment line to enable, needs KMSG_USART)
+//#define KMSG_SCPI
+
+// Frequency hopping: table of frequencies uploaded over TWI/I2C played back by Timer1 interrupt
+// (uncomment line to enable, needs 6 bytes of RAM per table entry)
+//#define KMSG_HOP
+#define KMSG_HOP_TABLE_LENGTH 32
+// shortest dwell accepted for the table entry, main loop runs between interrupts of short dwells
+#define KMSG_HOP_MIN_DWELL_US 1500
+// Raw AD9833 words written by 0x04 commands 0x10/0x11 to the generator in single FSYNC frame
+// (uncomment line to enable)
+//#define KMSG_RAW_WORDS
+
 // Disable internal debug features
 #define KMSG_NO_PIN_DEBUG
 
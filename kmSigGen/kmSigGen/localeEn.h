@@ -46,6 +46,7 @@
 
 #define STR_MENU_LOAD "Load Preset"
 #define STR_MENU_SAVE "Save Preset"
+#define STR_MENU_TWI_ADDRESS "I2C"
 
 #define STR_MENU_WAVE_NONE "Off"
 #define STR_MENU_WAVE_SQUARE "Square"
@@ -56,6 +57,7 @@
 #define STR_CANCEL "Cancel"
 #define STR_YES "Yes"
 #define STR_NO "No"
+#define STR_TWI_ADDRESS "I2C address"
 
 #define STR_PWR_SAVER1 "--> kmSigGen <--"
 #define STR_PWR_SAVER2 "  Power  Saver  "
@@ -45,8 +45,9 @@
 #define STR_MENU_PRESET3 "Ustaw.3"
 #define STR_MENU_PRESET4 "Ustaw.4"
 
-#define STR_MENU_LOAD "Wczytaj ustaw."
-#define STR_MENU_SAVE "Zapisz ustaw."
+#define STR_MENU_LOAD "Wczytaj"
+#define STR_MENU_SAVE "Zapisz"
+#define STR_MENU_TWI_ADDRESS "I2C"
 
 #define STR_MENU_WAVE_NONE "Wyl."
 #define STR_MENU_WAVE_SQUARE "Prost."
@@ -57,6 +58,7 @@
 #define STR_CANCEL "Anauluj"
 #define STR_YES "Tak"
 #define STR_NO "Nie"
+#define STR_TWI_ADDRESS "Adres I2C"
 
 #define STR_PWR_SAVER1 "--> kmSigGen <--"
 #define STR_PWR_SAVER2 "    Wygaszacz   "
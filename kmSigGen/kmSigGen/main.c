@@ -32,6 +32,7 @@
 #include "config.h"
 #include "LiquidCrystal.h"
 #include "TWISlave.h"
+#include "Usart.h"
 #include "Debug.h"
 #include "UserInterface.h"
 #include "SignalGeneratorAD9833.h"
@@ -41,22 +42,41 @@
 int main(void) {
 	dbPullUpAllPorts();
 	dbInit(DEBUG_STEPS);
-	usrInit(DEFAULT_FREQUENCY, UI_SIG_SQUARE);
+	usrInit(SG_FREQ_REG(DEFAULT_FREQUENCY), UI_SIG_SQUARE);
 	sgInit();
-	setGeneratorParameters(DEFAULT_FREQUENCY, SG_SIG_SQUARE);
+	setGeneratorParameters(SG_FREQ_REG(DEFAULT_FREQUENCY), SG_SIG_SQUARE);
+
+	// Timer1 running free with F_CPU / 8 clock, time base for interrupt measurement and frequency hopping
+	TCCR1A = 0;
+	TCCR1B = _BV(CS11);
+
+	// settings first, TWI/I2C address is stored there
+	settingsInit();
 
 #ifndef KMSG_NO_TWI
-	sei(); // enable global interrupt for TWI/I2C
-	twiInit(TWI_SLAVE_ADDRESS);
+#ifdef KMSG_TWI_AUTO_ADDRESS
+	if (settingsIsTwiAddressSet() == false) {
+		settingsSaveTwiAddress(twiAutoAddress(TWI_SLAVE_ADDRESS));
+	}
+#endif
+	twiInit(settingsGetTwiAddress());
+#endif
+#ifdef KMSG_USART
+	usartInit();
 #endif
 
-	settingsInit();
+	// enable global interrupt once all peripherals are initialized
+	// (TWI/I2C, USART, EEPROM writes of settings, frequency hopping)
+	sei();
 
 	// Main Loop
 	while (true) {
 		usrLoop();
-		extLoop();
 		dbStep();
-		_delay_ms(1);
+		// external commands are executed also while the loop waits
+		for (uint8_t i = 0; i < KMSG_LOOP_DELAY_STEPS; i++) {
+			extLoop();
+			_delay_us(KMSG_LOOP_DELAY_US / KMSG_LOOP_DELAY_STEPS);
+		}
 	}
 }
@@ -0,0 +1,244 @@
+/*
+ * HostBoards.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include <time.h>
+#include "HostBoards.h"
+#include "HostBus.h"
+
+// room of firmware buffers, in transactions (writes) and in words
+#define HOST_FIRMWARE_TRANSACTIONS TWI_BUFFER_TRANSACTIONS
+#define HOST_FIRMWARE_WORDS (TWI_BUFFER_BYTES / 4)
+
+static HostBoard _hostBoards[HOST_BOARDS_MAX];
+static uint8_t _hostBoardsCount = 0;
+static HostStats _hostStats;
+
+// private functions
+uint32_t hostBoardsTimeUs(void);
+uint16_t hostBoardsNextWrite(const HostBoard *board);
+bool hostBoardsWrite(HostBoard *board);
+bool hostBoardsReadQueue(HostBoard *board);
+void hostBoardsDrop(HostBoard *board);
+
+// Implementation
+uint32_t hostBoardsTimeUs(void) {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint32_t)now.tv_sec * 1000000UL + now.tv_nsec / 1000;
+}
+
+HostBoard *hostBoardsAdd(uint8_t address) {
+	if (_hostBoardsCount >= HOST_BOARDS_MAX || hostBoardsFind(address) != NULL) {
+		return NULL;
+	}
+	HostBoard *board = &_hostBoards[_hostBoardsCount++];
+	memset(board, 0, sizeof(HostBoard));
+	board->address = address;
+	hostBoardsRefresh(board);
+	return board;
+}
+
+uint8_t hostBoardsCount(void) {
+	return _hostBoardsCount;
+}
+
+HostBoard *hostBoardsGet(uint8_t index) {
+	return &_hostBoards[index];
+}
+
+HostBoard *hostBoardsFind(uint8_t address) {
+	for (uint8_t i = 0; i < _hostBoardsCount; i++) {
+		if (_hostBoards[i].address == address) {
+			return &_hostBoards[i];
+		}
+	}
+	return NULL;
+}
+
+bool hostBoardsQueue(HostBoard *board, const uint32_t *words, uint16_t length) {
+	if (length == 0 || length > HOST_WRITE_WORDS || board->queueLength + length > HOST_QUEUE_WORDS) {
+		return false;
+	}
+	memcpy(&board->queue[board->queueLength], words, length * sizeof(uint32_t));
+	board->queueLength += length;
+	return true;
+}
+
+bool hostBoardsRefresh(HostBoard *board) {
+	board->online = hostBusRead(board->address, 0x00, board->registers, TWI_REGISTERS_LENGTH);
+	if (board->online == true) {
+		board->freeTransactions = HOST_FIRMWARE_TRANSACTIONS - board->registers[EXT_REG_QUEUE_TRANSACTIONS];
+		board->freeWords = HOST_FIRMWARE_WORDS - board->registers[EXT_REG_QUEUE_WORDS];
+	}
+	return board->online;
+}
+
+/*
+ * Function hostBoardsReadQueue
+ * Desc     refreshes room left in firmware buffers from EXT_REG_QUEUE_* registers
+ * Input    board: board to be refreshed
+ * Output   true in case board has responded
+ */
+bool hostBoardsReadQueue(HostBoard *board) {
+	uint8_t *queue = &board->registers[EXT_REG_QUEUE_TRANSACTIONS];
+	board->online = hostBusRead(board->address, EXT_REG_QUEUE_TRANSACTIONS, queue, 2);
+	if (board->online == true) {
+		board->freeTransactions = HOST_FIRMWARE_TRANSACTIONS - queue[0];
+		board->freeWords = HOST_FIRMWARE_WORDS - queue[1];
+	}
+	return board->online;
+}
+
+/*
+ * Function hostBoardsNextWrite
+ * Desc     counts words of whole commands from the head of the queue fitting into single write
+ * Input    board: board with commands queued
+ * Output   number of words of the next write
+ */
+uint16_t hostBoardsNextWrite(const HostBoard *board) {
+	uint16_t result = 0;
+	while (result < board->queueLength) {
+		uint16_t length = hostGetCommandLength(board->queue[result]);
+		if (result + length > HOST_WRITE_WORDS || result + length > board->queueLength) {
+			break;
+		}
+		result += length;
+	}
+	return result;
+}
+
+/*
+ * Function hostBoardsWrite
+ * Desc     writes next batch of commands in case firmware buffers have room for it
+ * Input    board: board with commands queued
+ * Output   true in case batch has been written
+ */
+bool hostBoardsWrite(HostBoard *board) {
+	uint16_t length = hostBoardsNextWrite(board);
+	if (length == 0) {
+		// command longer than single write (or with missing data words) is never accepted
+		hostBoardsDrop(board);
+		return false;
+	}
+	if (board->freeTransactions == 0 || board->freeWords < length) {
+		return false;
+	}
+	uint8_t data[TWI_BUFFER_LENGTH];
+	for (uint16_t i = 0; i < length * 4; i++) {
+		// words are sent MSB first
+		data[i] = board->queue[i / 4] >> (24 - 8 * (i % 4));
+	}
+	if (hostBusWrite(board->address, data, length * 4) == false) {
+		// write NACKed by busy board is dropped as a whole, it's repeated once room is known
+		board->retries++;
+		board->freeTransactions = 0;
+		return false;
+	}
+	board->queueLength -= length;
+	memmove(board->queue, &board->queue[length], board->queueLength * sizeof(uint32_t));
+	board->freeTransactions--;
+	board->freeWords -= length;
+	_hostStats.writes++;
+	return true;
+}
+
+/*
+ * Function hostBoardsDrop
+ * Desc     discards all commands queued for the board
+ * Input    board: board which has not accepted its commands
+ */
+void hostBoardsDrop(HostBoard *board) {
+	for (uint16_t i = 0; i < board->queueLength; i += hostGetCommandLength(board->queue[i])) {
+		board->errors++;
+	}
+	board->queueLength = 0;
+}
+
+bool hostBoardsFlush(void) {
+	uint32_t start = hostBoardsTimeUs();
+	bool result = true;
+	bool pending = false;
+	bool touched[HOST_BOARDS_MAX] = {false};
+	for (uint8_t i = 0; i < _hostBoardsCount; i++) {
+		HostBoard *board = &_hostBoards[i];
+		for (uint16_t j = 0; j < board->queueLength; j += hostGetCommandLength(board->queue[j])) {
+			_hostStats.commands++;
+		}
+		touched[i] = (board->queueLength > 0);
+		pending |= touched[i];
+	}
+	if (pending == false) {
+		return true;
+	}
+	_hostStats.flushes++;
+	while (pending == true) {
+		// single write to every board in turn, so boards execute while others are written
+		bool written = false;
+		pending = false;
+		for (uint8_t i = 0; i < _hostBoardsCount; i++) {
+			HostBoard *board = &_hostBoards[i];
+			if (board->queueLength > 0) {
+				written |= hostBoardsWrite(board);
+				pending |= (board->queueLength > 0);
+			}
+		}
+		if (pending == true && written == false) {
+			bool timeout = (hostBoardsTimeUs() - start > HOST_FLUSH_TIMEOUT_US);
+			hostBusPoll();
+			for (uint8_t i = 0; i < _hostBoardsCount; i++) {
+				HostBoard *board = &_hostBoards[i];
+				if (board->queueLength > 0 && (timeout == true || hostBoardsReadQueue(board) == false)) {
+					hostBoardsDrop(board);
+					result = false;
+				}
+			}
+		}
+	}
+	// latency includes execution, so responses and registers read afterwards are up to date
+	bool executing = true;
+	while (executing == true && hostBoardsTimeUs() - start <= HOST_FLUSH_TIMEOUT_US) {
+		hostBusPoll();
+		executing = false;
+		for (uint8_t i = 0; i < _hostBoardsCount; i++) {
+			if (touched[i] == true) {
+				touched[i] = (hostBoardsReadQueue(&_hostBoards[i]) == true
+						&& _hostBoards[i].freeTransactions < HOST_FIRMWARE_TRANSACTIONS);
+				executing |= touched[i];
+			}
+		}
+	}
+	uint32_t latency = hostBoardsTimeUs() - start;
+	_hostStats.latencyLastUs = latency;
+	_hostStats.latencySumUs += latency;
+	if (latency > _hostStats.latencyMaxUs) {
+		_hostStats.latencyMaxUs = latency;
+	}
+	return result;
+}
+
+HostStats hostBoardsGetStats(void) {
+	return _hostStats;
+}
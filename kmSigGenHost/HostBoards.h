@@ -0,0 +1,136 @@
+/** @file
+ * @brief Boards on the TWI/I2C bus with queues of commands written in pipelined batches.
+ * HostBoards.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Commands are queued per board and written in batches: each write carries as many
+ *  whole commands as fit into TWI_BUFFER_LENGTH and writes are sent round robin to all
+ *  boards, so one board executes its batch while the next ones are written. Room left
+ *  in the firmware buffers is tracked on the host and refreshed from EXT_REG_QUEUE_*
+ *  registers, so writes are not dropped (NACKed) by busy boards.
+ */
+
+#ifndef HOSTBOARDS_H_
+#define HOSTBOARDS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "HostProtocol.h"
+
+// boards handled by single daemon and commands waiting for each of them
+#define HOST_BOARDS_MAX 32
+#define HOST_QUEUE_WORDS 256
+// longest time of single flush (waiting for execution included)
+#define HOST_FLUSH_TIMEOUT_US 500000UL
+
+/**
+Board on the bus and its queue of commands.
+*/
+typedef struct {
+	/// 7bit address
+	uint8_t address;
+	/// false once board has not responded
+	bool online;
+	/// register map read with last hostBoardsRefresh
+	uint8_t registers[TWI_REGISTERS_LENGTH];
+	/// commands (with their data words) waiting to be written
+	uint32_t queue[HOST_QUEUE_WORDS];
+	uint16_t queueLength;
+	/// room left in firmware buffers, as known by the host
+	uint8_t freeTransactions;
+	uint8_t freeWords;
+	/// writes repeated after NACK and commands dropped as board has not responded
+	uint32_t retries;
+	uint32_t errors;
+} HostBoard;
+
+/**
+Statistics of all flushes since start.
+*/
+typedef struct {
+	/// calls of hostBoardsFlush with any command queued
+	uint32_t flushes;
+	/// commands and writes sent to all boards
+	uint32_t commands;
+	uint32_t writes;
+	/// time from the first write until all boards executed their commands
+	uint32_t latencyLastUs;
+	uint32_t latencyMaxUs;
+	uint64_t latencySumUs;
+} HostStats;
+
+/**
+Adds board to the table and reads its register map.
+@param address 7bit address
+@result board, NULL in case table is full or address already added
+*/
+HostBoard *hostBoardsAdd(uint8_t address);
+
+/**
+Returns number of boards in the table.
+@result number of boards
+*/
+uint8_t hostBoardsCount(void);
+
+/**
+Returns board from the table.
+@param index position in the table (up to hostBoardsCount() - 1)
+@result board
+*/
+HostBoard *hostBoardsGet(uint8_t index);
+
+/**
+Finds board by its address.
+@param address 7bit address
+@result board, NULL in case board is not in the table
+*/
+HostBoard *hostBoardsFind(uint8_t address);
+
+/**
+Queues single command with its data words, they are always sent in the same write.
+@param board target board
+@param words command followed by data words
+@param length number of words (up to HOST_WRITE_WORDS)
+@result false in case command doesn't fit into the queue
+*/
+bool hostBoardsQueue(HostBoard *board, const uint32_t *words, uint16_t length);
+
+/**
+Writes all queued commands to all boards and waits until boards have executed them.
+@result true in case all commands have been delivered
+*/
+bool hostBoardsFlush(void);
+
+/**
+Reads register map of the board.
+@param board board to be refreshed
+@result true in case board has responded
+*/
+bool hostBoardsRefresh(HostBoard *board);
+
+/**
+Returns statistics of all flushes since start.
+@result statistics
+*/
+HostStats hostBoardsGetStats(void);
+
+#endif /* HOSTBOARDS_H_ */
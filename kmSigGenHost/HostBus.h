@@ -0,0 +1,72 @@
+/** @file
+ * @brief TWI/I2C bus access of the host, implemented for Linux i2c-dev and for emulated device.
+ * HostBus.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Backend is selected at link time: HostBusI2c.c talks to /dev/i2c-N adapter,
+ *  HostBusMock.c drives firmware sources compiled for the host (see kmSigGenHost.c).
+ */
+
+#ifndef HOSTBUS_H_
+#define HOSTBUS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+Opens the bus.
+@param device path of i2c-dev adapter (e.g. /dev/i2c-1), ignored by emulated device
+@result true in case bus is ready
+*/
+bool hostBusOpen(const char *device);
+
+/**
+Closes the bus.
+*/
+void hostBusClose(void);
+
+/**
+Writes bytes to the device with start and stop condition.
+@param address 7bit address
+@param data bytes to be written
+@param length number of bytes
+@result true in case all bytes have been acknowledged
+*/
+bool hostBusWrite(uint8_t address, const uint8_t *data, uint8_t length);
+
+/**
+Sets register pointer and reads registers from it with repeated start.
+@param address 7bit address
+@param pointer address of the first register
+@param buffer result
+@param length number of bytes to be read
+@result true in case device has responded
+*/
+bool hostBusRead(uint8_t address, uint8_t pointer, uint8_t *buffer, uint8_t length);
+
+/**
+Gives devices time to execute queued writes (short sleep on real bus,
+single main loop iteration of emulated device).
+*/
+void hostBusPoll(void);
+
+#endif /* HOSTBUS_H_ */
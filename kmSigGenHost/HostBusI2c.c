@@ -0,0 +1,69 @@
+/*
+ * HostBusI2c.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include "HostBus.h"
+
+// time given to devices between polls of their queues, main loop of the firmware takes 1 ms
+#define HOST_BUS_POLL_US 250
+
+static int _hostBusFile = -1;
+
+// Implementation
+bool hostBusOpen(const char *device) {
+	_hostBusFile = open(device, O_RDWR);
+	return (_hostBusFile >= 0);
+}
+
+void hostBusClose(void) {
+	if (_hostBusFile >= 0) {
+		close(_hostBusFile);
+		_hostBusFile = -1;
+	}
+}
+
+bool hostBusWrite(uint8_t address, const uint8_t *data, uint8_t length) {
+	struct i2c_msg message = {address, 0, length, (uint8_t *)data};
+	struct i2c_rdwr_ioctl_data transfer = {&message, 1};
+	return (ioctl(_hostBusFile, I2C_RDWR, &transfer) >= 0);
+}
+
+bool hostBusRead(uint8_t address, uint8_t pointer, uint8_t *buffer, uint8_t length) {
+	// single transfer, so no other master can move the pointer before the read
+	struct i2c_msg messages[2] = {
+		{address, 0, 1, &pointer},
+		{address, I2C_M_RD, length, buffer}
+	};
+	struct i2c_rdwr_ioctl_data transfer = {messages, 2};
+	return (ioctl(_hostBusFile, I2C_RDWR, &transfer) >= 0);
+}
+
+void hostBusPoll(void) {
+	usleep(HOST_BUS_POLL_US);
+}
@@ -0,0 +1,93 @@
+/*
+ * HostBusMock.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "config.h"
+#include "HostBus.h"
+#include "TWIMasterEmulator.h"
+#include "TWISlave.h"
+#include "ExternalInterface.h"
+#include "SignalGeneratorAD9833.h"
+#include "UserInterface.h"
+#include "Settings.h"
+
+// state of the User Interface followed by the emulated device (UserInterface.c is not linked)
+static uint32_t _mockFreqReg = SG_FREQ_REG(DEFAULT_FREQUENCY);
+static UIWaveType _mockWaveType = DEFAULT_WAVE_TYPE;
+// address stored by the emulated device (Settings.c is not linked), kept only until exit
+static uint8_t _mockTwiAddress = TWI_SLAVE_ADDRESS;
+
+// Implementation
+uint32_t usrGetCurrentFreqReg(void) {
+	return _mockFreqReg;
+}
+
+UIWaveType usrGetWaveType(void) {
+	return _mockWaveType;
+}
+
+void usrSyncParameters(uint32_t freqReg, UIWaveType waveType) {
+	_mockFreqReg = freqReg;
+	_mockWaveType = waveType;
+}
+
+void settingsSaveTwiAddress(uint8_t address) {
+	_mockTwiAddress = address;
+}
+
+uint8_t settingsGetTwiAddress(void) {
+	return _mockTwiAddress;
+}
+
+bool settingsIsWriteDone(void) {
+	return true;
+}
+
+bool hostBusOpen(const char *device) {
+	// single device at the stored address (TWI_SLAVE_ADDRESS at start), other addresses are not acknowledged
+	(void)device;
+	twiInit(settingsGetTwiAddress());
+	twiEmuReset();
+	extLoop();
+	return true;
+}
+
+void hostBusClose(void) {
+}
+
+bool hostBusWrite(uint8_t address, const uint8_t *data, uint8_t length) {
+	return (twiEmuWrite(address, data, length, true) == length + 1);
+}
+
+bool hostBusRead(uint8_t address, uint8_t pointer, uint8_t *buffer, uint8_t length) {
+	if (twiEmuWrite(address, &pointer, 1, false) != 2) {
+		twiEmuStop();
+		return false;
+	}
+	return (twiEmuRead(address, buffer, length, true) == length);
+}
+
+void hostBusPoll(void) {
+	extLoop();
+}
@@ -0,0 +1,166 @@
+/*
+ * HostProtocol.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <string.h>
+#include "HostProtocol.h"
+#include "SignalGeneratorAD9833.h"
+
+#define HOST_CMD_POS_L1 29
+#define HOST_CMD_POS_L2 24
+#define HOST_CMD_MASK_L2 0x1F
+#define HOST_CMD_WAVE 0x00
+#define HOST_CMD_FREQ_REG 0x01
+#define HOST_CMD_STRING 0x03
+#define HOST_CMD_HOP 0x04
+#define HOST_CMD_STATUS 0x06
+#define HOST_HOP_UPLOAD 0x00
+#define HOST_STATUS_TWI_ADDRESS 0x05
+#define HOST_RAW_WORDS 0x11
+#define HOST_STRING_SELECTOR_BIT 25
+
+static const char *_hostWaveTypeNames[] = {"none", "square", "sine", "triangle"};
+
+// Implementation
+uint32_t hostCmdWave(HostWaveType waveType) {
+	// AD9833 control bits decoded by firmware: OPBITEN (bit 5) and MODE (bit 1)
+	switch (waveType) {
+		case HOST_WAVE_SINE : {
+			return 0x00000000UL;
+		}
+		case HOST_WAVE_TRIANGLE : {
+			return 0x00000002UL;
+		}
+		case HOST_WAVE_SQUARE : {
+			return 0x00000020UL;
+		}
+		default : {
+			return 0x00000022UL;
+		}
+	}
+}
+
+uint32_t hostCmdFreqReg(uint32_t freqReg) {
+	return ((uint32_t)HOST_CMD_FREQ_REG << HOST_CMD_POS_L1) | (freqReg & SG_FREQ_REG_MASK);
+}
+
+uint32_t hostCmdStatus(uint8_t status) {
+	return ((uint32_t)HOST_CMD_STATUS << HOST_CMD_POS_L1) | ((uint32_t)(status & HOST_CMD_MASK_L2) << HOST_CMD_POS_L2);
+}
+
+uint32_t hostCmdTwiAddress(uint8_t address) {
+	// complement of the address on bits 8 - 15 guards against accidental change
+	return hostCmdStatus(HOST_STATUS_TWI_ADDRESS) | ((uint32_t)(uint8_t)~address << 8) | (address & 0x7F);
+}
+
+uint8_t hostCmdRaw(const uint16_t *raw, uint8_t count, uint32_t *words) {
+	if (count > HOST_RAW_MAX_WORDS) {
+		count = HOST_RAW_MAX_WORDS;
+	}
+	words[0] = ((uint32_t)HOST_CMD_HOP << HOST_CMD_POS_L1) | ((uint32_t)HOST_RAW_WORDS << HOST_CMD_POS_L2) | count;
+	uint8_t length = 1 + (count + 1) / 2;
+	for (uint8_t i = 1; i < length; i++) {
+		words[i] = 0;
+	}
+	// two AD9833 words per command word, MSB first
+	for (uint8_t i = 0; i < count; i++) {
+		words[1 + i / 2] |= (uint32_t)raw[i] << ((i % 2 == 0) ? 16 : 0);
+	}
+	return length;
+}
+
+uint8_t hostCmdString(bool wifiAddress, const char *str, uint32_t *words) {
+	uint8_t length = 0;
+	while (str[length] != '\0' && length < STR_EXTERNAL_BUFFERS_SIZE_OF - 1) {
+		length++;
+	}
+	words[0] = ((uint32_t)HOST_CMD_STRING << HOST_CMD_POS_L1) | length;
+	if (wifiAddress == true) {
+		words[0] |= 1UL << HOST_STRING_SELECTOR_BIT;
+	}
+	uint8_t result = 1 + (length + 3) / 4;
+	for (uint8_t i = 1; i < result; i++) {
+		words[i] = 0;
+	}
+	for (uint8_t i = 0; i < length; i++) {
+		// characters are sent MSB first, 4 in each word
+		words[1 + i / 4] |= (uint32_t)(uint8_t)str[i] << (24 - 8 * (i % 4));
+	}
+	return result;
+}
+
+uint16_t hostGetCommandLength(uint32_t word) {
+	uint8_t commandL1 = word >> HOST_CMD_POS_L1;
+	uint8_t commandL2 = (word >> HOST_CMD_POS_L2) & HOST_CMD_MASK_L2;
+	if (commandL1 == HOST_CMD_HOP && commandL2 == HOST_HOP_UPLOAD) {
+		return 1 + 2 * (word & 0xFF);
+	}
+	if (commandL1 == HOST_CMD_HOP && commandL2 == HOST_RAW_WORDS) {
+		return 1 + ((word & 0xFF) + 1) / 2;
+	}
+	if (commandL1 == HOST_CMD_STRING) {
+		return 1 + ((word & 0xFF) + 3) / 4;
+	}
+	return 1;
+}
+
+uint32_t hostFreqToFreqReg(double frequency) {
+	if (frequency <= 0.0) {
+		return 0;
+	}
+	double freqReg = frequency * (double)(1UL << SG_FREQ_REG_BITS) / (double)SG_MCLK + 0.5;
+	if (freqReg > (double)SG_FREQ_REG_MAX) {
+		return SG_FREQ_REG_MAX;
+	}
+	return (uint32_t)freqReg;
+}
+
+double hostFreqRegToFreq(uint32_t freqReg) {
+	return (double)(freqReg & SG_FREQ_REG_MASK) * (double)SG_MCLK / (double)(1UL << SG_FREQ_REG_BITS);
+}
+
+bool hostWaveTypeFromStr(const char *str, HostWaveType *waveType) {
+	for (uint8_t i = 0; i < sizeof(_hostWaveTypeNames) / sizeof(_hostWaveTypeNames[0]); i++) {
+		if (strcmp(str, _hostWaveTypeNames[i]) == 0) {
+			*waveType = (HostWaveType)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char *hostWaveTypeToStr(HostWaveType waveType) {
+	if (waveType > HOST_WAVE_TRIANGLE) {
+		return _hostWaveTypeNames[HOST_WAVE_NONE];
+	}
+	return _hostWaveTypeNames[waveType];
+}
+
+uint32_t hostGetRegister(const uint8_t *registers, uint8_t address, uint8_t length) {
+	uint32_t result = 0;
+	for (uint8_t i = 0; i < length; i++) {
+		result = (result << 8) | registers[address + i];
+	}
+	return result;
+}
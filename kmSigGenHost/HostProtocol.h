@@ -0,0 +1,152 @@
+/** @file
+ * @brief Command words and register map of kmSigGen TWI/I2C interface, as seen from the host.
+ * HostProtocol.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Commands are encoded the same way ExternalInterface.c decodes them, buffer sizes
+ *  and register addresses come from firmware headers (config.h, ExternalInterface.h),
+ *  so the host always matches the firmware built from the same tree.
+ */
+
+#ifndef HOSTPROTOCOL_H_
+#define HOSTPROTOCOL_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "config.h"
+#include "ExternalInterface.h"
+
+#if !defined(TWI_REGISTER_MAP) || !defined(KMSG_BULK_STRINGS) || !defined(KMSG_RAW_WORDS)
+#error "kmSigGenHost needs firmware built with TWI_REGISTER_MAP, KMSG_BULK_STRINGS and KMSG_RAW_WORDS (see config.h)"
+#endif
+
+// words of the longest write accepted by the firmware
+#define HOST_WRITE_WORDS (TWI_BUFFER_LENGTH / 4)
+// words of the bulk string command (command word and 4 characters per word)
+#define HOST_STRING_WORDS (1 + (STR_EXTERNAL_BUFFERS_SIZE_OF - 1 + 3) / 4)
+
+// AD9833 words of the single raw write command
+#define HOST_RAW_MAX_WORDS 16
+
+// Wave types as reported in EXT_REG_WAVE_TYPE register
+typedef enum {
+	HOST_WAVE_NONE = 0,
+	HOST_WAVE_SQUARE = 1,
+	HOST_WAVE_SINE = 2,
+	HOST_WAVE_TRIANGLE = 3
+} HostWaveType;
+
+/**
+Returns command (0x00) setting the wave type.
+@param waveType wave type
+@result command word
+*/
+uint32_t hostCmdWave(HostWaveType waveType);
+
+/**
+Returns command (0x01) setting the frequency register.
+@param freqReg 28bit value of the frequency register
+@result command word
+*/
+uint32_t hostCmdFreqReg(uint32_t freqReg);
+
+/**
+Returns status command (0x06) selecting the response read from EXT_REG_RESPONSE.
+@param status second level command (0x00 - 0x04)
+@result command word
+*/
+uint32_t hostCmdStatus(uint8_t status);
+
+/**
+Returns status command (0x06/0x05) changing TWI/I2C address of the device, the device stores
+the address in EEPROM and responds only to it after the write (response included).
+@param address new 7bit address (0x08 - 0x77)
+@result command word
+*/
+uint32_t hostCmdTwiAddress(uint8_t address);
+
+/**
+Encodes raw write command (0x04/0x11) passing AD9833 words (control, FREQ0/1, PHASE0/1) to the
+generator in single FSYNC frame, words beyond HOST_RAW_MAX_WORDS are cut. With B28 set frequency
+register writes have to come in pairs (LSBs, then MSBs), otherwise the firmware ignores the command.
+@param raw AD9833 words
+@param count number of AD9833 words
+@param words result, at least 1 + HOST_RAW_MAX_WORDS / 2 long
+@result number of words of the command
+*/
+uint8_t hostCmdRaw(const uint16_t *raw, uint8_t count, uint32_t *words);
+
+/**
+Encodes bulk string command (0x03), characters beyond the firmware buffer are cut.
+@param wifiAddress false for the splash string, true for WiFi address
+@param str string to be sent
+@param words result, at least HOST_STRING_WORDS long
+@result number of words of the command
+*/
+uint8_t hostCmdString(bool wifiAddress, const char *str, uint32_t *words);
+
+/**
+Returns number of words of the command including its data words, the same way firmware counts them.
+@param word command word
+@result number of words
+*/
+uint16_t hostGetCommandLength(uint32_t word);
+
+/**
+Calculates frequency register for the frequency, limited to the maximum frequency.
+@param frequency frequency in Hz
+@result 28bit value of the frequency register
+*/
+uint32_t hostFreqToFreqReg(double frequency);
+
+/**
+Calculates frequency from frequency register.
+@param freqReg 28bit value of the frequency register
+@result frequency in Hz
+*/
+double hostFreqRegToFreq(uint32_t freqReg);
+
+/**
+Finds wave type by its name (none, square, sine, triangle).
+@param str name of the wave type
+@param waveType result
+@result true in case name is known
+*/
+bool hostWaveTypeFromStr(const char *str, HostWaveType *waveType);
+
+/**
+Returns name of the wave type.
+@param waveType wave type
+@result name of the wave type
+*/
+const char *hostWaveTypeToStr(HostWaveType waveType);
+
+/**
+Returns value of the register from the register map (multi-byte registers are big endian).
+@param registers register map read from the device
+@param address address of the register
+@param length length of the register in bytes (1 - 4)
+@result value of the register
+*/
+uint32_t hostGetRegister(const uint8_t *registers, uint8_t address, uint8_t length);
+
+#endif /* HOSTPROTOCOL_H_ */
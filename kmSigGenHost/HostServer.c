@@ -0,0 +1,407 @@
+/*
+ * HostServer.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "HostServer.h"
+#include "HostBoards.h"
+
+#define HOST_SERVER_RECEIVE_TIMEOUT_US 200000
+#define HOST_SERVER_RESPONSE_LENGTH 16384
+#define HOST_SERVER_VALUE_LENGTH 64
+
+/**
+Request received in the current cycle.
+*/
+typedef struct {
+	int socket;
+	/// HTTP status of the response (0 until request is executed)
+	int status;
+	bool post;
+	bool stats;
+	/// board selected in the path, NULL for all boards
+	HostBoard *board;
+	/// commands dropped for selected boards before the flush
+	uint32_t errors;
+} HostRequest;
+
+static int _hostServerSocket = -1;
+static char _hostServerResponse[HOST_SERVER_RESPONSE_LENGTH];
+
+// private functions
+bool hostServerReceive(int socket, char *text);
+void hostServerParse(HostRequest *request, char *text);
+bool hostServerApply(HostBoard *board, const char *body);
+uint32_t hostServerErrors(const HostRequest *request);
+const char *hostJsonFind(const char *json, const char *key);
+bool hostJsonGetNumber(const char *json, const char *key, double *value);
+bool hostJsonGetString(const char *json, const char *key, char *value, uint8_t length);
+int hostServerPrintBoard(char *buffer, int size, const HostBoard *board);
+void hostServerRespond(HostRequest *request);
+void hostServerSend(int socket, int status, const char *body);
+
+// Implementation
+bool hostServerOpen(uint16_t port) {
+	_hostServerSocket = socket(AF_INET, SOCK_STREAM, 0);
+	if (_hostServerSocket < 0) {
+		return false;
+	}
+	int reuse = 1;
+	setsockopt(_hostServerSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	// API is available only locally
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(_hostServerSocket, (struct sockaddr *)&address, sizeof(address)) < 0
+			|| listen(_hostServerSocket, HOST_SERVER_CLIENTS) < 0) {
+		hostServerClose();
+		return false;
+	}
+	// all pending connections are accepted in single cycle
+	fcntl(_hostServerSocket, F_SETFL, O_NONBLOCK);
+	return true;
+}
+
+void hostServerClose(void) {
+	if (_hostServerSocket >= 0) {
+		close(_hostServerSocket);
+		_hostServerSocket = -1;
+	}
+}
+
+void hostServerLoop(void) {
+	fd_set sockets;
+	FD_ZERO(&sockets);
+	FD_SET(_hostServerSocket, &sockets);
+	struct timeval timeout = {0, HOST_SERVER_CYCLE_MS * 1000L};
+	if (select(_hostServerSocket + 1, &sockets, NULL, NULL, &timeout) <= 0) {
+		return;
+	}
+	HostRequest requests[HOST_SERVER_CLIENTS];
+	uint8_t count = 0;
+	bool flush = false;
+	char text[HOST_SERVER_REQUEST_LENGTH];
+	while (count < HOST_SERVER_CLIENTS) {
+		int client = accept(_hostServerSocket, NULL, NULL);
+		if (client < 0) {
+			break;
+		}
+		HostRequest *request = &requests[count++];
+		memset(request, 0, sizeof(HostRequest));
+		request->socket = client;
+		if (hostServerReceive(client, text) == false) {
+			request->status = 400;
+			continue;
+		}
+		hostServerParse(request, text);
+		flush |= (request->post == true && request->status == 0);
+	}
+	if (flush == true) {
+		hostBoardsFlush();
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		hostServerRespond(&requests[i]);
+		close(requests[i].socket);
+	}
+}
+
+/*
+ * Function hostServerReceive
+ * Desc     reads request headers and body (up to Content-Length)
+ * Input    socket: client socket
+ * Output   text: request terminated with '\0', HOST_SERVER_REQUEST_LENGTH long
+ *          true in case complete request has been received
+ */
+bool hostServerReceive(int socket, char *text) {
+	struct timeval timeout = {0, HOST_SERVER_RECEIVE_TIMEOUT_US};
+	setsockopt(socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	int length = 0;
+	while (length < HOST_SERVER_REQUEST_LENGTH - 1) {
+		int received = recv(socket, &text[length], HOST_SERVER_REQUEST_LENGTH - 1 - length, 0);
+		if (received <= 0) {
+			return false;
+		}
+		length += received;
+		text[length] = '\0';
+		char *body = strstr(text, "\r\n\r\n");
+		if (body != NULL) {
+			char *contentLength = strstr(text, "Content-Length:");
+			int bodyLength = (contentLength != NULL && contentLength < body) ? atoi(contentLength + 15) : 0;
+			if (body + 4 + bodyLength <= text + length) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+/*
+ * Function hostServerParse
+ * Desc     selects board from the path and queues commands of POST requests
+ * Input    request: request to be filled
+ *          text: complete request
+ */
+void hostServerParse(HostRequest *request, char *text) {
+	request->post = (strncmp(text, "POST ", 5) == 0);
+	if (request->post == false && strncmp(text, "GET ", 4) != 0) {
+		request->status = 405;
+		return;
+	}
+	char *path = strchr(text, ' ') + 1;
+	if (strncmp(path, "/stats ", 7) == 0 && request->post == false) {
+		request->stats = true;
+		return;
+	}
+	if (strncmp(path, "/boards", 7) != 0 || (path[7] != ' ' && path[7] != '/')) {
+		request->status = 404;
+		return;
+	}
+	if (path[7] == '/') {
+		char *end;
+		request->board = hostBoardsFind(strtoul(&path[8], &end, 0));
+		if (request->board == NULL || *end != ' ') {
+			request->status = 404;
+			return;
+		}
+	}
+	if (request->post == true) {
+		const char *body = strstr(path, "\r\n\r\n") + 4;
+		request->errors = hostServerErrors(request);
+		for (uint8_t i = 0; i < hostBoardsCount(); i++) {
+			HostBoard *board = hostBoardsGet(i);
+			if ((request->board == NULL || request->board == board) && hostServerApply(board, body) == false) {
+				request->status = 400;
+			}
+		}
+	}
+}
+
+/*
+ * Function hostServerApply
+ * Desc     queues commands for parameters found in JSON body
+ * Input    board: target board
+ *          body: JSON object
+ * Output   true in case any parameter has been found and all of them are correct
+ */
+bool hostServerApply(HostBoard *board, const char *body) {
+	bool result = false;
+	char value[HOST_SERVER_VALUE_LENGTH];
+	double number;
+	uint32_t words[HOST_STRING_WORDS];
+	if (hostJsonGetString(body, "wave", value, sizeof(value)) == true) {
+		HostWaveType waveType;
+		if (hostWaveTypeFromStr(value, &waveType) == false) {
+			return false;
+		}
+		words[0] = hostCmdWave(waveType);
+		result = hostBoardsQueue(board, words, 1);
+	}
+	if (hostJsonGetNumber(body, "frequency", &number) == true) {
+		words[0] = hostCmdFreqReg(hostFreqToFreqReg(number));
+		result = hostBoardsQueue(board, words, 1);
+	} else if (hostJsonGetNumber(body, "freqReg", &number) == true) {
+		words[0] = hostCmdFreqReg((uint32_t)number);
+		result = hostBoardsQueue(board, words, 1);
+	}
+	if (hostJsonGetString(body, "splash", value, sizeof(value)) == true) {
+		result = hostBoardsQueue(board, words, hostCmdString(false, value, words));
+	}
+	if (hostJsonGetString(body, "wifi", value, sizeof(value)) == true) {
+		result = hostBoardsQueue(board, words, hostCmdString(true, value, words));
+	}
+	return result;
+}
+
+/*
+ * Function hostServerErrors
+ * Desc     sums commands dropped for boards selected by the request
+ * Input    request: request with selected board
+ * Output   number of dropped commands
+ */
+uint32_t hostServerErrors(const HostRequest *request) {
+	uint32_t result = 0;
+	for (uint8_t i = 0; i < hostBoardsCount(); i++) {
+		HostBoard *board = hostBoardsGet(i);
+		if (request->board == NULL || request->board == board) {
+			result += board->errors;
+		}
+	}
+	return result;
+}
+
+/*
+ * Function hostJsonFind
+ * Desc     finds value of the key in flat JSON object
+ * Input    json: JSON object
+ *          key: name of the key
+ * Output   first character of the value, NULL in case key is not found
+ */
+const char *hostJsonFind(const char *json, const char *key) {
+	size_t length = strlen(key);
+	for (const char *position = strchr(json, '"'); position != NULL; position = strchr(position + 1, '"')) {
+		if (strncmp(position + 1, key, length) == 0 && position[length + 1] == '"') {
+			position += length + 2;
+			while (*position == ' ' || *position == '\t') {
+				position++;
+			}
+			if (*position != ':') {
+				return NULL;
+			}
+			position++;
+			while (*position == ' ' || *position == '\t') {
+				position++;
+			}
+			return position;
+		}
+	}
+	return NULL;
+}
+
+bool hostJsonGetNumber(const char *json, const char *key, double *value) {
+	const char *position = hostJsonFind(json, key);
+	if (position == NULL) {
+		return false;
+	}
+	char *end;
+	*value = strtod(position, &end);
+	return (end != position);
+}
+
+bool hostJsonGetString(const char *json, const char *key, char *value, uint8_t length) {
+	const char *position = hostJsonFind(json, key);
+	if (position == NULL || *position != '"') {
+		return false;
+	}
+	uint8_t i = 0;
+	for (position++; *position != '"' && *position != '\0'; position++) {
+		if (*position == '\\' && position[1] != '\0') {
+			position++;
+		}
+		if (i < length - 1) {
+			value[i++] = *position;
+		}
+	}
+	value[i] = '\0';
+	return (*position == '"');
+}
+
+/*
+ * Function hostServerPrintBoard
+ * Desc     prints state of the board as JSON object
+ * Input    buffer: result
+ *          size: size of the buffer
+ *          board: board with register map read
+ * Output   number of characters printed
+ */
+int hostServerPrintBoard(char *buffer, int size, const HostBoard *board) {
+	const uint8_t *registers = board->registers;
+	uint32_t freqReg = hostGetRegister(registers, EXT_REG_FREQ_REG, 4);
+	return snprintf(buffer, size,
+			"{\"address\":%u,\"online\":%s,\"frequency\":%.3f,\"freqReg\":%u,\"wave\":\"%s\","
+			"\"version\":\"%u.%u\",\"eepromBusy\":%s,\"queueTransactions\":%u,\"queueWords\":%u,"
+			"\"generatorWrites\":%u,\"commandsCoalesced\":%u,\"twiOverflows\":%u,\"twiDrops\":%u,"
+			"\"twiBusErrors\":%u,\"twiNacks\":%u,\"twiIsrMaxUs\":%u,\"retries\":%u,\"errors\":%u}",
+			board->address, (board->online == true) ? "true" : "false",
+			hostFreqRegToFreq(freqReg), freqReg,
+			hostWaveTypeToStr((HostWaveType)registers[EXT_REG_WAVE_TYPE]),
+			registers[EXT_REG_VERSION], registers[EXT_REG_VERSION + 1],
+			((registers[EXT_REG_SELECT] & 0x08) != 0) ? "true" : "false",
+			registers[EXT_REG_QUEUE_TRANSACTIONS], registers[EXT_REG_QUEUE_WORDS],
+			hostGetRegister(registers, EXT_REG_GENERATOR_WRITES, 2),
+			hostGetRegister(registers, EXT_REG_COMMANDS_COALESCED, 2),
+			hostGetRegister(registers, EXT_REG_TWI_OVERFLOWS, 2),
+			hostGetRegister(registers, EXT_REG_TWI_DROPS, 2),
+			hostGetRegister(registers, EXT_REG_TWI_BUS_ERRORS, 2),
+			hostGetRegister(registers, EXT_REG_TWI_NACKS, 2),
+			hostGetRegister(registers, EXT_REG_TWI_ISR_MAX, 2),
+			board->retries, board->errors);
+}
+
+/*
+ * Function hostServerRespond
+ * Desc     prepares and sends response of the executed request
+ * Input    request: executed request
+ */
+void hostServerRespond(HostRequest *request) {
+	char *buffer = _hostServerResponse;
+	int size = HOST_SERVER_RESPONSE_LENGTH;
+	if (request->status != 0) {
+		snprintf(buffer, size, "{\"ok\":false}");
+	} else if (request->stats == true) {
+		HostStats stats = hostBoardsGetStats();
+		uint32_t average = (stats.flushes > 0) ? stats.latencySumUs / stats.flushes : 0;
+		snprintf(buffer, size, "{\"flushes\":%u,\"commands\":%u,\"writes\":%u,"
+				"\"latencyLastUs\":%u,\"latencyMaxUs\":%u,\"latencyAvgUs\":%u}",
+				stats.flushes, stats.commands, stats.writes, stats.latencyLastUs, stats.latencyMaxUs, average);
+	} else if (request->post == true) {
+		bool delivered = (hostServerErrors(request) == request->errors);
+		snprintf(buffer, size, "{\"ok\":%s,\"latencyUs\":%u}",
+				(delivered == true) ? "true" : "false", hostBoardsGetStats().latencyLastUs);
+		if (delivered == false) {
+			request->status = 502;
+		}
+	} else if (request->board != NULL) {
+		hostBoardsRefresh(request->board);
+		hostServerPrintBoard(buffer, size, request->board);
+	} else {
+		int length = snprintf(buffer, size, "[");
+		for (uint8_t i = 0; i < hostBoardsCount() && length < size - 2; i++) {
+			HostBoard *board = hostBoardsGet(i);
+			hostBoardsRefresh(board);
+			if (i > 0) {
+				buffer[length++] = ',';
+			}
+			length += hostServerPrintBoard(&buffer[length], size - length, board);
+		}
+		if (length < size - 1) {
+			snprintf(&buffer[length], size - length, "]");
+		}
+	}
+	hostServerSend(request->socket, (request->status != 0) ? request->status : 200, buffer);
+}
+
+/*
+ * Function hostServerSend
+ * Desc     sends HTTP response with JSON body
+ * Input    socket: client socket
+ *          status: HTTP status
+ *          body: JSON document
+ */
+void hostServerSend(int socket, int status, const char *body) {
+	char header[128];
+	int length = snprintf(header, sizeof(header), "HTTP/1.0 %d %s\r\nContent-Type: application/json\r\n"
+			"Content-Length: %zu\r\nConnection: close\r\n\r\n", status, (status == 200) ? "OK" : "Error", strlen(body));
+	send(socket, header, length, MSG_NOSIGNAL);
+	send(socket, body, strlen(body), MSG_NOSIGNAL);
+}
@@ -0,0 +1,66 @@
+/** @file
+ * @brief Local HTTP server with JSON API controlling boards of the daemon.
+ * HostServer.h
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  API (JSON bodies, numbers in decimal, addresses also as 0x hex in the path):
+ *  GET  /boards            - state of all boards read from their register maps
+ *  GET  /boards/ADDRESS    - state of single board
+ *  POST /boards            - parameters applied to all boards, e.g. {"frequency": 1000.5, "wave": "sine"}
+ *  POST /boards/ADDRESS    - parameters applied to single board, keys: frequency (Hz), freqReg,
+ *                            wave (none, square, sine, triangle), splash, wifi
+ *  GET  /stats             - latency and throughput of flushes
+ *  All requests accepted in the same cycle are executed with single flush, so commands
+ *  of concurrent clients are batched together.
+ */
+
+#ifndef HOSTSERVER_H_
+#define HOSTSERVER_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// clients handled in single cycle and size of the request (headers and body)
+#define HOST_SERVER_CLIENTS 16
+#define HOST_SERVER_REQUEST_LENGTH 2048
+// time of waiting for requests in single cycle
+#define HOST_SERVER_CYCLE_MS 100
+
+/**
+Opens listening socket on the loopback interface.
+@param port TCP port
+@result true in case socket is ready
+*/
+bool hostServerOpen(uint16_t port);
+
+/**
+Waits for requests up to HOST_SERVER_CYCLE_MS, executes all of them with single flush
+and sends responses. To be called in the main loop of the daemon.
+*/
+void hostServerLoop(void);
+
+/**
+Closes listening socket.
+*/
+void hostServerClose(void);
+
+#endif /* HOSTSERVER_H_ */
@@ -0,0 +1,169 @@
+/*
+ * kmSigGenHost.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Host daemon controlling kmSigGen boards over Linux i2c-dev adapter, with local HTTP/JSON API
+ *  (see HostServer.h). Firmware headers are shared, so the daemon has to be built from the same tree
+ *  as the firmware of the boards (config.h), which needs TWI_REGISTER_MAP, KMSG_BULK_STRINGS
+ *  and KMSG_RAW_WORDS enabled. Build for the real bus:
+ *  gcc -std=gnu99 -O2 -I../kmSigGen/kmSigGen kmSigGenHost.c HostBoards.c HostProtocol.c
+ *  HostServer.c HostBusI2c.c -o kmSigGenHost
+ *  Build with emulated board (firmware sources compiled for the host, single board at TWI_SLAVE_ADDRESS):
+ *  gcc -std=gnu99 -O2 -D_TESTS_ENV -DF_CPU=8000000UL -I../kmSigGen/kmSigGen kmSigGenHost.c
+ *  HostBoards.c HostProtocol.c HostServer.c HostBusMock.c ../kmSigGen/kmSigGen/TWISlave.c
+ *  ../kmSigGen/kmSigGen/TWIMasterEmulator.c ../kmSigGen/kmSigGen/ExternalInterface.c
+ *  ../kmSigGen/kmSigGen/SignalGeneratorAD9833.c ../kmSigGen/kmSigGen/StringTools.c -o kmSigGenHostMock
+ *  Usage:
+ *  kmSigGenHost [-d /dev/i2c-1] [-a 0x56,0x57,...] [-p 8056] [-b commands]
+ *  -b runs benchmark of the bus with given number of commands per burst size instead of the server
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "HostBus.h"
+#include "HostBoards.h"
+#include "HostProtocol.h"
+#include "HostServer.h"
+
+#define HOST_DEFAULT_DEVICE "/dev/i2c-1"
+#define HOST_DEFAULT_PORT 8056
+
+static volatile sig_atomic_t _hostRunning = 1;
+
+// private functions
+void hostStop(int signal);
+bool hostAddBoards(char *addresses);
+void hostBenchmark(uint32_t commands);
+
+// Implementation
+void hostStop(int signal) {
+	(void)signal;
+	_hostRunning = 0;
+}
+
+/*
+ * Function hostAddBoards
+ * Desc     adds boards from comma separated list of addresses
+ * Input    addresses: list of addresses (decimal or 0x hex)
+ * Output   true in case all boards have responded
+ */
+bool hostAddBoards(char *addresses) {
+	bool result = true;
+	for (char *address = strtok(addresses, ","); address != NULL; address = strtok(NULL, ",")) {
+		HostBoard *board = hostBoardsAdd(strtoul(address, NULL, 0) & 0x7F);
+		if (board == NULL || board->online == false) {
+			fprintf(stderr, "board %s not available\n", address);
+			result = false;
+		}
+	}
+	return result;
+}
+
+/*
+ * Function hostBenchmark
+ * Desc     sends frequency commands to all boards in bursts of growing size and prints
+ *          throughput and latency of flushes (execution on boards included)
+ * Input    commands: number of commands sent to each board for every burst size
+ */
+void hostBenchmark(uint32_t commands) {
+	for (uint8_t burst = 1; burst <= HOST_WRITE_WORDS; burst <<= 1) {
+		HostStats before = hostBoardsGetStats();
+		struct timespec start, end;
+		clock_gettime(CLOCK_MONOTONIC, &start);
+		for (uint32_t sent = 0; sent < commands; sent += burst) {
+			for (uint8_t i = 0; i < hostBoardsCount(); i++) {
+				for (uint8_t j = 0; j < burst; j++) {
+					// each command different from the previous one, so none of them is skipped
+					uint32_t word = hostCmdFreqReg(sent + j + 1);
+					hostBoardsQueue(hostBoardsGet(i), &word, 1);
+				}
+			}
+			hostBoardsFlush();
+		}
+		clock_gettime(CLOCK_MONOTONIC, &end);
+		HostStats after = hostBoardsGetStats();
+		double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+		uint32_t flushes = after.flushes - before.flushes;
+		printf("burst %2u: %10.0f commands/s, %u writes, latency avg %u us, max %u us\n", burst,
+				(after.commands - before.commands) / seconds, after.writes - before.writes,
+				(flushes > 0) ? (uint32_t)((after.latencySumUs - before.latencySumUs) / flushes) : 0,
+				after.latencyMaxUs);
+	}
+}
+
+int main(int argc, char *argv[]) {
+	const char *device = HOST_DEFAULT_DEVICE;
+	char defaultAddress[8];
+	snprintf(defaultAddress, sizeof(defaultAddress), "0x%02X", TWI_SLAVE_ADDRESS);
+	char *addresses = defaultAddress;
+	uint16_t port = HOST_DEFAULT_PORT;
+	uint32_t benchmark = 0;
+	int option;
+	while ((option = getopt(argc, argv, "d:a:p:b:")) != -1) {
+		switch (option) {
+			case 'd' : {
+				device = optarg;
+				break;
+			}
+			case 'a' : {
+				addresses = optarg;
+				break;
+			}
+			case 'p' : {
+				port = atoi(optarg);
+				break;
+			}
+			case 'b' : {
+				benchmark = strtoul(optarg, NULL, 0);
+				break;
+			}
+			default : {
+				fprintf(stderr, "usage: %s [-d device] [-a address,...] [-p port] [-b commands]\n", argv[0]);
+				return 1;
+			}
+		}
+	}
+	if (hostBusOpen(device) == false) {
+		fprintf(stderr, "cannot open %s\n", device);
+		return 1;
+	}
+	// boards not responding are kept in the table and reported as offline
+	hostAddBoards(addresses);
+	if (benchmark > 0) {
+		hostBenchmark(benchmark);
+	} else if (hostServerOpen(port) == true) {
+		signal(SIGINT, hostStop);
+		signal(SIGTERM, hostStop);
+		while (_hostRunning != 0) {
+			hostServerLoop();
+		}
+		hostServerClose();
+	} else {
+		fprintf(stderr, "cannot listen on port %u\n", port);
+	}
+	hostBusClose();
+	return 0;
+}
@@ -0,0 +1,52 @@
+#!/bin/sh
+#
+# FlashSize.sh
+#
+#  Created on: Oct 18, 2026
+#      Author: Krzysztof Moskwa
+#      License: GPL-3.0-or-later
+#
+#  Builds the firmware of the given git revisions with avr-gcc, using flags of the Release
+#  configuration of kmSigGen.cproj, and prints avr-size of every build. Fails if any build
+#  doesn't fit ATmega8A (8192 bytes of flash, 1024 bytes of RAM, stack not included).
+#  Usage (also "make size REVS=..."):
+#  FlashSize.sh [revision...] - without revisions the working tree is built
+#  e.g. FlashSize.sh 180b1d7 HEAD compares the first release with the current one
+#
+
+FLASH_SIZE=8192
+RAM_SIZE=1024
+CC=avr-gcc
+SIZE=avr-size
+CFLAGS="-mmcu=atmega8a -std=gnu99 -Os -DF_CPU=8000000L -DNDEBUG -funsigned-char -funsigned-bitfields \
+-fpack-struct -fshort-enums -ffunction-sections -fdata-sections"
+LDFLAGS="-mmcu=atmega8a -Wl,--gc-sections -lm"
+
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+
+# Function flashSizeBuild
+# Desc     builds firmware sources found in the directory (emulators excluded) and prints their size
+# Input    $1: name of the build, $2: directory with firmware sources
+# Output   0 if the build fits the device
+flashSizeBuild() {
+	elf="$TMP/$1.elf"
+	sources=$(ls "$2"/*.c | grep -v "Emulator\.c$")
+	# linker reports overflow of the text region already, size is printed anyway
+	$CC $CFLAGS $sources $LDFLAGS -Wl,--noinhibit-exec -o "$elf" || return 1
+	$SIZE "$elf" | tail -n 1 | awk -v name="$1" -v flash=$FLASH_SIZE -v ram=$RAM_SIZE '{
+		printf "%-12s flash %5u/%u  ram %4u/%u\n", name, $1 + $2, flash, $2 + $3, ram
+		exit ($1 + $2 > flash || $2 + $3 > ram) }'
+}
+
+result=0
+if [ $# -eq 0 ]; then
+	flashSizeBuild "worktree" "$ROOT/kmSigGen/kmSigGen" || result=1
+fi
+for revision in "$@"; do
+	mkdir -p "$TMP/$revision"
+	git -C "$ROOT" archive "$revision" kmSigGen/kmSigGen | tar -x -C "$TMP/$revision" || exit 1
+	flashSizeBuild "$revision" "$TMP/$revision/kmSigGen/kmSigGen" || result=1
+done
+exit $result
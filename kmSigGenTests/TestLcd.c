@@ -0,0 +1,290 @@
+/*
+ * TestLcd.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Regression test of the user interface on the HD44780 model (LiquidCrystalEmulator.h).
+ *  Menu transitions are driven with scripted button and rotary encoder input (host replacements
+ *  of Buttons.c and RotaryEncoder.c below). After every transition the expected text has to be
+ *  visible, the controller can't be written while busy and the display traffic can't exceed
+ *  the golden values of the table. Traffic lower than golden is reported, so the table can be
+ *  updated after optimizations. Built with marquee (KMSG_MARQUEE_STEP_TIMEOUT) and
+ *  KMSG_BULK_STRINGS, run by "make test" (see Makefile).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "config.h"
+#include "version.h"
+#include "LiquidCrystalEmulator.h"
+#include "EEPROMEmulator.h"
+#include "TWIMasterEmulator.h"
+#include "TWISlave.h"
+#include "Buttons.h"
+#include "RotaryEncoder.h"
+#include "UserInterface.h"
+#include "ExternalInterface.h"
+#include "SignalGeneratorAD9833.h"
+#include "Settings.h"
+
+// WiFi address longer than LCD_COLS, scrolled with the marquee on the main screen
+#define TEST_WIFI_ADDRESS "http://192.168.100.200/"
+// loops of the whole marquee pass, the main screen stays after that
+#define TEST_MARQUEE_PASS_LOOPS (KMSG_MARQUEE_DWELL_TIMEOUT * 2 \
+		+ (sizeof(TEST_WIFI_ADDRESS) - 1 - LCD_COLS) * (KMSG_MARQUEE_STEP_TIMEOUT + 1) + 2)
+// loops following the pass, display can't be scrolled again
+#define TEST_MARQUEE_IDLE_LOOPS 10000
+
+typedef struct {
+	const char *name;
+	int8_t rotation; // encoder change seen by the first usrLoop call of the transition
+	bool button; // button press seen by the first usrLoop call of the transition
+	uint16_t loops; // usrLoop calls of the transition
+	uint8_t row; // row of the expected text
+	const char *text; // text expected in the row once the transition is completed
+	uint16_t commands; // golden instructions of the transition
+	uint16_t dataWrites; // golden data bytes of the transition
+} TestLcdStep;
+
+static const TestLcdStep _testSteps[] = {
+	{ "splash", 0, false, 2, 0, APP_NAME " " APP_VERSION, 9, 86 },
+	{ "splash -> main", 0, true, 2, 0, "Press", 3, 32 },
+	{ "main -> select menu", 0, true, 2, 0, STR_MENU_RETURN, 6, 22 },
+	{ "select: Return -> Freq", 1, false, 1, 0, STR_MENU_FREQUENCY, 2, 2 },
+	{ "select -> frequency editor", 0, true, 2, 1, "MHz", 4, 17 },
+	{ "editor: move to digit 1", 5, false, 1, 1, "MHz", 2, 2 },
+	{ "editor: edit digit", 0, true, 1, 1, "MHz", 2, 0 },
+	{ "editor: change digit", 1, false, 1, 1, "2.0000MHz", 3, 9 },
+	{ "editor: leave digit", 0, true, 1, 1, "2.0000MHz", 1, 0 },
+	{ "editor: move to apply", 6, false, 1, 1, "2.0000MHz", 2, 2 },
+	{ "editor -> apply menu", 0, true, 1, 0, STR_APPLY, 6, 24 },
+	{ "apply -> main", 0, true, 2, 1, "2.0000MHz", 3, 32 },
+	{ "main -> select menu", 0, true, 2, 0, STR_MENU_RETURN, 6, 22 },
+	{ "select: Return -> Freq", 1, false, 1, 0, STR_MENU_FREQUENCY, 2, 2 },
+	{ "select -> frequency editor", 0, true, 2, 1, "2.0000MHz", 4, 17 },
+	{ "editor -> cancel menu", 0, true, 2, 0, STR_CANCEL, 5, 12 },
+	{ "cancel: No -> Yes", -1, false, 1, 0, STR_YES, 2, 2 },
+	{ "cancel -> main", 0, true, 2, 1, "2.0000MHz", 3, 32 },
+	{ "main -> select menu", 0, true, 2, 0, STR_MENU_RETURN, 6, 22 },
+	{ "select: Return -> Wave", 2, false, 1, 1, STR_MENU_WAVE, 2, 2 },
+	{ "select -> wave menu", 0, true, 2, 0, STR_MENU_WAVE_SQUARE, 6, 20 },
+	{ "wave: Square -> Sine", 1, false, 1, 0, STR_MENU_WAVE_SINE, 2, 2 },
+	{ "wave -> main", 0, true, 2, 1, STR_SINE, 3, 32 },
+	{ "main -> select menu", 0, true, 2, 0, STR_MENU_RETURN, 6, 22 },
+	{ "select: Return -> Presets", 3, false, 1, 1, STR_MENU_PRESETS, 2, 2 },
+	{ "select -> load/save menu", 0, true, 2, 0, STR_MENU_LOAD, 5, 26 },
+	{ "load/save: Load -> Save", 1, false, 1, 1, STR_MENU_SAVE, 2, 2 },
+	{ "load/save -> presets menu", 0, true, 2, 0, STR_MENU_PRESET1, 6, 29 },
+	{ "presets: save Preset1 -> main", 0, true, 2, 1, STR_SINE, 3, 32 },
+	{ "main -> select menu", 0, true, 2, 0, STR_MENU_RETURN, 6, 22 },
+	{ "select: Return -> Presets", 3, false, 1, 1, STR_MENU_PRESETS, 2, 2 },
+	{ "select -> load/save menu", 0, true, 2, 0, STR_MENU_LOAD, 5, 26 },
+	{ "load/save: Load -> I2C", 2, false, 1, 1, STR_MENU_TWI_ADDRESS, 2, 2 },
+	{ "load/save -> address editor", 0, true, 2, 1, "0x56", 2, 15 },
+	{ "address: 0x56 -> 0x57", 1, false, 1, 1, "0x57", 1, 4 },
+	{ "address -> main", 0, true, 2, 1, STR_SINE, 3, 32 },
+	{ "main -> power saver", 0, false, KMSG_SCREEN_SAVER_TIMEOUT + 2, 1, STR_PWR_SAVER2, 2, 32 },
+	{ "power saver -> main", 0, true, 2, 1, STR_SINE, 3, 32 }
+};
+
+static int8_t _testRotation = 0;
+static bool _testButton = false;
+static uint32_t _testFailures = 0;
+
+// private functions
+bool testLcdFindText(uint8_t row, const char *text);
+void testLcdFail(const char *name, const char *reason);
+void testLcdStep(const TestLcdStep *step);
+void testLcdLoops(uint16_t loops);
+void testLcdMarquee(void);
+
+// host replacements of Buttons.c and RotaryEncoder.c
+void btnInit(uint8_t pin) {
+	_testButton = false;
+}
+
+void btnLoop(void) {
+}
+
+bool btnPressed(void) {
+	return _testButton;
+}
+
+void btnReset(void) {
+	_testButton = false;
+}
+
+void rseInit(uint8_t pin1, uint8_t pin2) {
+	_testRotation = 0;
+}
+
+void rseLoop(void) {
+}
+
+int8_t rseGetLastChangeAndReset(void) {
+	int8_t result = _testRotation;
+	_testRotation = 0;
+	return result;
+}
+
+// Implementation
+/*
+ * Function testLcdFindText
+ * Desc     checks if the text is visible in the given row of the display
+ * Input    row: display row
+ *          text: expected text
+ * Output   true if the text is found
+ */
+bool testLcdFindText(uint8_t row, const char *text) {
+	char line[LCD_COLS + 1];
+	lcdEmuGetLine(row, line);
+	return (strstr(line, text) != NULL);
+}
+
+/*
+ * Function testLcdFail
+ * Desc     reports failure of the transition
+ * Input    name: name of the transition
+ *          reason: description of the failure
+ */
+void testLcdFail(const char *name, const char *reason) {
+	printf("FAIL %s: %s\n", name, reason);
+	_testFailures++;
+}
+
+/*
+ * Function testLcdStep
+ * Desc     executes single transition and compares its result with the expected one, main loop
+ *          is modeled with extLoop and EEPROM running between usrLoop calls
+ * Input    step: transition to be executed
+ */
+void testLcdStep(const TestLcdStep *step) {
+	lcdEmuResetStats();
+	_testRotation = step->rotation;
+	_testButton = step->button;
+	testLcdLoops(step->loops);
+	LcdEmuStats stats = lcdEmuGetStats();
+	printf("%-32s %5u %5u %6u %8u\n", step->name,
+			stats.commands, stats.dataWrites, stats.nibbles, stats.busTimeUs);
+	if (testLcdFindText(step->row, step->text) == false) {
+		char line[LCD_COLS + 1];
+		lcdEmuGetLine(step->row, line);
+		printf("  expected \"%s\" in row %u: \"%s\"\n", step->text, step->row, line);
+		testLcdFail(step->name, "text not shown");
+	}
+	if (stats.busyViolations != 0) {
+		testLcdFail(step->name, "controller written while busy");
+	}
+	if (stats.commands > step->commands || stats.dataWrites > step->dataWrites) {
+		printf("  golden %u commands, %u data writes\n", step->commands, step->dataWrites);
+		testLcdFail(step->name, "display traffic above golden");
+	} else if (stats.commands < step->commands || stats.dataWrites < step->dataWrites) {
+		printf("  below golden %u commands, %u data writes, table can be updated\n",
+				step->commands, step->dataWrites);
+	}
+}
+
+/*
+ * Function testLcdLoops
+ * Desc     models main loop, extLoop is called and EEPROM is running between usrLoop calls
+ * Input    loops: usrLoop calls
+ */
+void testLcdLoops(uint16_t loops) {
+	for (uint16_t i = 0; i < loops; i++) {
+		usrLoop();
+		extLoop();
+		eeEmuRun(KMSG_LOOP_DELAY_US);
+	}
+}
+
+/*
+ * Function testLcdMarquee
+ * Desc     sends long WiFi address over TWI/I2C while main screen is shown, the address is
+ *          scrolled once and display returns home, so signal parameters in row 1 stay visible
+ */
+void testLcdMarquee(void) {
+	const char *address = TEST_WIFI_ADDRESS;
+	uint8_t length = strlen(address);
+	// bulk string command (0x03) selecting WiFi address buffer, characters follow MSB first
+	uint8_t data[4 + STR_EXTERNAL_BUFFERS_SIZE_OF] = { 0x62, 0x00, 0x00, length };
+	memcpy(&data[4], address, length);
+	twiEmuWrite(twiGetAddress(), data, 4 + ((length + 3) & ~0x03), true);
+
+	uint8_t shiftMax = 0;
+	for (uint16_t i = 0; i < TEST_MARQUEE_PASS_LOOPS; i++) {
+		testLcdLoops(1);
+		if (lcdEmuGetDisplayShift() > shiftMax) {
+			shiftMax = lcdEmuGetDisplayShift();
+		}
+	}
+	printf("%-32s shifted by %u\n", "marquee pass", shiftMax);
+	if (shiftMax != length - LCD_COLS) {
+		testLcdFail("marquee pass", "address not scrolled to the end");
+	}
+	if (lcdEmuGetDisplayShift() != 0 || testLcdFindText(1, STR_SINE) == false) {
+		testLcdFail("marquee pass", "display not returned home");
+	}
+
+	lcdEmuResetStats();
+	testLcdLoops(TEST_MARQUEE_IDLE_LOOPS);
+	LcdEmuStats stats = lcdEmuGetStats();
+	printf("%-32s %5u %5u %6u %8u\n", "marquee idle", stats.commands, stats.dataWrites,
+			stats.nibbles, stats.busTimeUs);
+	if (stats.commands != 0 || lcdEmuGetDisplayShift() != 0 || testLcdFindText(1, STR_SINE) == false) {
+		testLcdFail("marquee idle", "display scrolled again after the pass");
+	}
+}
+
+int main(void) {
+	lcdEmuReset();
+	eeEmuErase();
+	usrInit(SG_FREQ_REG(DEFAULT_FREQUENCY), UI_SIG_SQUARE);
+	sgInit();
+	setGeneratorParameters(SG_FREQ_REG(DEFAULT_FREQUENCY), SG_SIG_SQUARE);
+	settingsInit();
+	twiInit(settingsGetTwiAddress());
+
+	printf("%-32s %5s %5s %6s %8s\n", "transition", "cmds", "data", "nibbls", "bus us");
+	for (uint8_t i = 0; i < sizeof(_testSteps) / sizeof(TestLcdStep); i++) {
+		testLcdStep(&_testSteps[i]);
+	}
+	testLcdMarquee();
+
+	// state changed by the menus
+	if (usrGetWaveType() != UI_SIG_SINE) {
+		testLcdFail("wave menu", "wave type not applied");
+	}
+	if (twiGetAddress() != TWI_SLAVE_ADDRESS + 1 || settingsGetTwiAddress() != TWI_SLAVE_ADDRESS + 1) {
+		testLcdFail("address editor", "address not applied or not saved");
+	}
+	UIWaveType waveType;
+	uint32_t freqReg;
+	settingsGetPreset(1, &waveType, &freqReg);
+	if (waveType != UI_SIG_SINE || freqReg != usrGetCurrentFreqReg()) {
+		testLcdFail("presets menu", "preset not saved");
+	}
+	if (lcdEmuIsBacklight() == false) {
+		testLcdFail("power saver", "backlight not restored");
+	}
+
+	printf("%s: %u failures\n", (_testFailures == 0) ? "PASS" : "FAIL", _testFailures);
+	return (_testFailures == 0) ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/*
+ * TestScpi.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Grammar test of the SCPI parser (ScpiParser.h). Every line of the table is passed to
+ *  scpiParse byte by byte and terminated with LF, the commands completed on the way have to
+ *  match the table together with the frequency of the last SCPI_FREQ and the wave type
+ *  of the last SCPI_FUNC. Built and run by "make test" (see Makefile).
+ */
+
+#include <stdio.h>
+#include "config.h"
+#include "ScpiParser.h"
+#include "SignalGeneratorAD9833.h"
+
+#define TEST_SCPI_COMMANDS 4
+#define TEST_SCPI_FREQ_SCALE 100UL
+#define TEST_SCPI_FREQ_COEF SG_DEC_COEF(SG_MCLK * TEST_SCPI_FREQ_SCALE, SG_FREQ_REG_BITS)
+#define TEST_ZEROS_10 "0000000000"
+
+typedef struct {
+	const char *line; // sent without LF, added by the test
+	ScpiCommand commands[TEST_SCPI_COMMANDS]; // completed commands, SCPI_NONE terminated
+	uint32_t freq; // expected frequency of the last SCPI_FREQ in 0.01Hz units
+	UIWaveType waveType; // expected wave type of the last SCPI_FUNC
+} TestScpiCase;
+
+static const TestScpiCase _testCases[] = {
+	// units and short/long forms
+	{ "FREQ 440", { SCPI_FREQ }, 44000, UI_SIG_NONE },
+	{ "freq 440", { SCPI_FREQ }, 44000, UI_SIG_NONE },
+	{ "FREQuency 440HZ", { SCPI_FREQ }, 44000, UI_SIG_NONE },
+	{ "FREQUENCY 1.8432MHZ", { SCPI_FREQ }, 184320000, UI_SIG_NONE },
+	{ "FREQ 1.8432 mhz", { SCPI_FREQ }, 184320000, UI_SIG_NONE },
+	{ "FREQ 1MAHZ", { SCPI_FREQ }, 100000000, UI_SIG_NONE },
+	{ "FREQ 2.2KHZ", { SCPI_FREQ }, 220000, UI_SIG_NONE },
+	{ "FREQ +.5", { SCPI_FREQ }, 50, UI_SIG_NONE },
+	{ "FREQ 0.005", { SCPI_FREQ }, 1, UI_SIG_NONE },
+	{ "FREQ 0.004", { SCPI_FREQ }, 0, UI_SIG_NONE },
+	{ "FREQ 12.5MHZ", { SCPI_FREQ }, 1250000000, UI_SIG_NONE },
+	{ "  FREQ   440  ", { SCPI_FREQ }, 44000, UI_SIG_NONE },
+	// exponents
+	{ "FREQ 2.5E3HZ", { SCPI_FREQ }, 250000, UI_SIG_NONE },
+	{ "FREQ 2.5e+3 Hz", { SCPI_FREQ }, 250000, UI_SIG_NONE },
+	{ "FREQ 25E-1", { SCPI_FREQ }, 250, UI_SIG_NONE },
+	{ "FREQ 1E-99", { SCPI_FREQ }, 0, UI_SIG_NONE },
+	{ "FREQ 0.00000000000000000001E20", { SCPI_FREQ }, 100, UI_SIG_NONE },
+	{ "FREQ 12345678901234567890E-13", { SCPI_FREQ }, 123456789, UI_SIG_NONE },
+	{ "FREQ 0." TEST_ZEROS_10 TEST_ZEROS_10 TEST_ZEROS_10 TEST_ZEROS_10 TEST_ZEROS_10 TEST_ZEROS_10
+			TEST_ZEROS_10 TEST_ZEROS_10 TEST_ZEROS_10 TEST_ZEROS_10 TEST_ZEROS_10 TEST_ZEROS_10
+			TEST_ZEROS_10 "1", { SCPI_FREQ }, 0, UI_SIG_NONE },
+	// other commands
+	{ "FREQ?", { SCPI_FREQ_QUERY }, 0, UI_SIG_NONE },
+	{ "frequency?", { SCPI_FREQ_QUERY }, 0, UI_SIG_NONE },
+	{ "*IDN?", { SCPI_IDN_QUERY }, 0, UI_SIG_NONE },
+	{ "FUNC SIN", { SCPI_FUNC }, 0, UI_SIG_SINE },
+	{ "FUNCTION SQUARE", { SCPI_FUNC }, 0, UI_SIG_SQUARE },
+	{ "func triangle ", { SCPI_FUNC }, 0, UI_SIG_TRIANGLE },
+	{ "SWE:STAR", { SCPI_SWEEP_START }, 0, UI_SIG_NONE },
+	{ "sweep:start", { SCPI_SWEEP_START }, 0, UI_SIG_NONE },
+	{ "", { SCPI_NONE }, 0, UI_SIG_NONE },
+	{ "\r", { SCPI_NONE }, 0, UI_SIG_NONE },
+	// chaining with ';'
+	{ "FREQ 1KHZ;FUNC TRI;FREQ?", { SCPI_FREQ, SCPI_FUNC, SCPI_FREQ_QUERY }, 100000, UI_SIG_TRIANGLE },
+	{ "FOO;*IDN?", { SCPI_ERROR, SCPI_IDN_QUERY }, 0, UI_SIG_NONE },
+	{ "FREQ 13MHZ;FREQ 440", { SCPI_ERROR, SCPI_FREQ }, 44000, UI_SIG_NONE },
+	{ "FUNC SAW;FUNC SQU", { SCPI_ERROR, SCPI_FUNC }, 0, UI_SIG_SQUARE },
+	// errors
+	{ "FREQ 13MHZ", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ 12500000.01", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ 1E99", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ 1" TEST_ZEROS_10 TEST_ZEROS_10, { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ ", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ abc", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ 1 2", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ 1..2", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ 440GHZ", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ 1E3E3", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQU 440", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQUENCYX 440", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FUNC SAW", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FUNC", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FUNC?", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "SWE:STOP", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "*IDN", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "VERYLONGKEYWORD 1", { SCPI_ERROR }, 0, UI_SIG_NONE },
+	{ "FREQ#440", { SCPI_ERROR }, 0, UI_SIG_NONE }
+};
+
+/*
+ * Function testScpiCase
+ * Desc     parses single line of the table and compares the result
+ * Input    testCase: line with expected result
+ * Output   true if the result is as expected
+ */
+bool testScpiCase(const TestScpiCase *testCase) {
+	ScpiCommand commands[TEST_SCPI_COMMANDS] = { SCPI_NONE };
+	uint8_t count = 0;
+	bool result = true;
+	for (const char *data = testCase->line; ; data++) {
+		ScpiCommand command = scpiParse((*data != '\0') ? *data : '\n');
+		if (command != SCPI_NONE) {
+			if (count < TEST_SCPI_COMMANDS) {
+				commands[count] = command;
+			}
+			count++;
+		}
+		if (*data == '\0') {
+			break;
+		}
+	}
+	printf("%-40.40s", testCase->line);
+	for (uint8_t i = 0; i < TEST_SCPI_COMMANDS; i++) {
+		if (i < count && commands[i] != SCPI_NONE) {
+			printf(" %u", commands[i]);
+		}
+		if (commands[i] != testCase->commands[i]) {
+			result = false;
+		}
+		// single SCPI_FREQ and SCPI_FUNC per line of the table
+		if (testCase->commands[i] == SCPI_FREQ) {
+			uint32_t freqReg = sgCalcFreqReg(testCase->freq, TEST_SCPI_FREQ_COEF, SG_FREQ_REG_BITS);
+			if (scpiGetFreqReg() != freqReg) {
+				printf(" freqReg %lu instead of %lu", (unsigned long)scpiGetFreqReg(), (unsigned long)freqReg);
+				result = false;
+			}
+		}
+		if (testCase->commands[i] == SCPI_FUNC && scpiGetWaveType() != testCase->waveType) {
+			printf(" wave %u instead of %u", scpiGetWaveType(), testCase->waveType);
+			result = false;
+		}
+	}
+	if (count > TEST_SCPI_COMMANDS) {
+		result = false;
+	}
+	printf("%s\n", (result == true) ? "" : " FAIL");
+	return result;
+}
+
+/*
+ * Function testScpiFreqStr
+ * Desc     checks conversion of the frequency register to the string returned by FREQ?
+ * Input    freqReg: value of frequency register
+ *          expected: expected string
+ * Output   true if the result is as expected
+ */
+bool testScpiFreqStr(uint32_t freqReg, const char *expected) {
+	char buffer[SCPI_FREQ_STR_LENGTH];
+	scpiFreqRegToStr(buffer, freqReg);
+	bool result = true;
+	for (uint8_t i = 0; buffer[i] != '\0' || expected[i] != '\0'; i++) {
+		if (buffer[i] != expected[i]) {
+			result = false;
+			break;
+		}
+	}
+	printf("%-40lu %s%s\n", (unsigned long)freqReg, buffer, (result == true) ? "" : " FAIL");
+	return result;
+}
+
+int main(void) {
+	uint32_t failures = 0;
+	scpiInit();
+	printf("%-40s %s\n", "line", "commands");
+	for (uint8_t i = 0; i < sizeof(_testCases) / sizeof(_testCases[0]); i++) {
+		if (testScpiCase(&_testCases[i]) == false) {
+			failures++;
+		}
+	}
+	printf("%-40s %s\n", "freqReg", "FREQ?");
+	if (testScpiFreqStr(0, "0.00") == false) {
+		failures++;
+	}
+	if (testScpiFreqStr(SG_FREQ_REG_MAX, "12500000.00") == false) {
+		failures++;
+	}
+	printf("%s: %u failures\n", (failures == 0) ? "PASS" : "FAIL", failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+/*
+ * TestSettings.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  Consistency of the presets stored by Settings.c on the EEPROM model (EEPROMEmulator.h), built
+ *  with KMSG_EEPROM_JOURNAL.
+ *  Random saves of fixed seeds, with power failures and restarts, are checked with
+ *  eeEmuSettingsCheck, no violation is allowed. Wear of the cells and time CPU waited
+ *  for writes are reported for every seed. Built and run by "make test" (see Makefile).
+ */
+
+#include <stdio.h>
+#include "config.h"
+#include "EEPROMEmulator.h"
+#include "Settings.h"
+
+#define TEST_SETTINGS_SEEDS 5
+#define TEST_SETTINGS_SEED_STEP 7919UL
+#define TEST_SETTINGS_SAVES 20000UL
+
+int main(void) {
+	uint32_t failures = 0;
+	printf("%7s %7s %10s %8s %8s %6s %10s\n", "seed", "saves", "violations",
+			"written", "wearMax", "cells", "wait us");
+	for (uint8_t i = 1; i <= TEST_SETTINGS_SEEDS; i++) {
+		uint32_t violations = eeEmuSettingsCheck(i * TEST_SETTINGS_SEED_STEP, TEST_SETTINGS_SAVES);
+		EeEmuStats stats = eeEmuGetStats();
+		printf("%7lu %7lu %10lu %8lu %8lu %6u %10llu\n", i * TEST_SETTINGS_SEED_STEP, TEST_SETTINGS_SAVES,
+				(unsigned long)violations, (unsigned long)stats.bytesWritten, (unsigned long)stats.wearMax,
+				stats.cellsWritten, (unsigned long long)stats.waitTimeUs);
+		failures += violations;
+	}
+	printf("%s: %lu failures\n", (failures == 0) ? "PASS" : "FAIL", (unsigned long)failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/*
+ * TestTwi.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  Robustness and throughput of the TWI/I2C slave on the bus model (TWIMasterEmulator.h).
+ *  Random status sequences of fixed seeds are passed to the interrupt with twiEmuFuzz, no
+ *  violation is allowed. Then frames of 1 to TWI_BUFFER_LENGTH / 4 frequency commands are
+ *  executed with twiEmuBenchmark, the last command has to reach the generator. Finally frequency
+ *  staged with command 0x02 is committed with general call followed by the next staged one
+ *  (built with TWI_GENERAL_CALL_COMMIT). Built and run by "make test" (see Makefile).
+ */
+
+#include <stdio.h>
+#include "config.h"
+#include "TWIMasterEmulator.h"
+#include "TWISlave.h"
+#include "UserInterface.h"
+#include "ExternalInterface.h"
+#include "SignalGeneratorAD9833.h"
+
+#define TEST_TWI_SEEDS 20
+#define TEST_TWI_SEED_STEP 7919UL
+#define TEST_TWI_EVENTS 100000UL
+#define TEST_TWI_COMMANDS 100000UL
+#define TEST_TWI_STAGED_1 0x0123456UL
+#define TEST_TWI_STAGED_2 0x0654321UL
+
+static const uint8_t _testBursts[] = { 1, 2, 4, 8, 16 };
+
+static uint32_t _testFreqReg = 0;
+static UIWaveType _testWaveType = UI_SIG_SQUARE;
+
+// host replacements of UserInterface.c and Settings.c functions used by ExternalInterface.c
+uint32_t usrGetCurrentFreqReg(void) {
+	return _testFreqReg;
+}
+
+UIWaveType usrGetWaveType(void) {
+	return _testWaveType;
+}
+
+void usrSyncParameters(uint32_t freqReg, UIWaveType waveType) {
+	_testFreqReg = freqReg;
+	_testWaveType = waveType;
+}
+
+bool settingsIsWriteDone(void) {
+	return true;
+}
+
+void settingsSaveTwiAddress(uint8_t address) {
+}
+
+/*
+ * Function testTwiStageWrite
+ * Desc     writes command 0x02 staging frequency for general call commit
+ * Input    freqReg: value of the frequency register
+ */
+void testTwiStageWrite(uint32_t freqReg) {
+	uint32_t word = (0x02UL << 29) | freqReg;
+	uint8_t data[4] = { word >> 24, word >> 16, word >> 8, word };
+	twiEmuWrite(TWI_SLAVE_ADDRESS, data, sizeof(data), true);
+}
+
+/*
+ * Function testTwiGeneralCall
+ * Desc     commits staged frequency with general call while the next frequency is already
+ *          staged by queued write, both generator and User Interface have to get the committed one
+ * Output   number of failures
+ */
+uint32_t testTwiGeneralCall(void) {
+#ifdef TWI_GENERAL_CALL_COMMIT
+	uint8_t commit = TWI_GENERAL_CALL_COMMIT;
+	testTwiStageWrite(TEST_TWI_STAGED_1);
+	extLoop();
+	twiEmuWrite(0x00, &commit, 1, true);
+	testTwiStageWrite(TEST_TWI_STAGED_2);
+	extLoop();
+	printf("general call commit: generator 0x%07lx, UI 0x%07lx, staged %u\n", (unsigned long)sgGetFreqReg(),
+			(unsigned long)_testFreqReg, sgIsStaged());
+	if (sgGetFreqReg() != TEST_TWI_STAGED_1 || _testFreqReg != TEST_TWI_STAGED_1 || sgIsStaged() == false) {
+		printf("FAIL general call commit\n");
+		return 1;
+	}
+#endif
+	return 0;
+}
+
+int main(void) {
+	uint32_t failures = 0;
+	twiInit(TWI_SLAVE_ADDRESS);
+	printf("%7s %10s %10s\n", "seed", "events", "violations");
+	for (uint8_t i = 1; i <= TEST_TWI_SEEDS; i++) {
+		twiEmuReset();
+		uint32_t violations = twiEmuFuzz(i * TEST_TWI_SEED_STEP, TEST_TWI_EVENTS);
+		printf("%7lu %10lu %10lu\n", i * TEST_TWI_SEED_STEP, TEST_TWI_EVENTS, (unsigned long)violations);
+		failures += violations;
+	}
+	// fuzzer leaves random address and statistics, so the benchmark starts from the beginning
+	twiInit(TWI_SLAVE_ADDRESS);
+	printf("TWI %lu Hz, %lu commands per burst size\n", TWI_EMU_SCL_HZ, TEST_TWI_COMMANDS);
+	printf("%5s %12s %12s\n", "burst", "host cmd/s", "bus cmd/s");
+	for (uint8_t i = 0; i < sizeof(_testBursts); i++) {
+		twiEmuReset();
+		twiResetStats();
+		uint32_t hostRate = twiEmuBenchmark(_testBursts[i], TEST_TWI_COMMANDS);
+		TwiEmuStats stats = twiEmuGetStats();
+		printf("%5u %12lu %12lu\n", _testBursts[i], (unsigned long)hostRate,
+				(unsigned long)(TEST_TWI_COMMANDS * 1000000ULL / stats.busTimeUs));
+		// the last command of the benchmark has to reach the generator, no write can be lost
+		if (stats.stalls != 0 || twiGetStat(TWI_STAT_OVERFLOWS) != 0
+				|| sgGetFreqReg() != ((TEST_TWI_COMMANDS - 1) & SG_FREQ_REG_MASK)) {
+			printf("FAIL burst %u: %lu stalls, %u overflows\n", _testBursts[i],
+					(unsigned long)stats.stalls, twiGetStat(TWI_STAT_OVERFLOWS));
+			failures++;
+		}
+	}
+	failures += testTwiGeneralCall();
+	printf("%s: %lu failures\n", (failures == 0) ? "PASS" : "FAIL", (unsigned long)failures);
+	return (failures == 0) ? 0 : 1;
+}
@@ -0,0 +1,163 @@
+/*
+ * TestUsart.c
+ *
+ *  Created on: Oct 18, 2026
+ *      Author: Krzysztof Moskwa
+ *      License: GPL-3.0-or-later
+ *
+ *  Signal Generator based on AVR ATmega8, AD9833/AD9837 module and LCD display
+ *  Copyright (C) 2019  Krzysztof Moskwa
+ *
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *  Throughput of USART command frames on the serial line model (UsartEmulator.h), built with
+ *  KMSG_USART, KMSG_SCPI and KMSG_RAW_WORDS. Frames of 1 to 32 frequency commands are executed by ExternalInterface.c,
+ *  rates are given for frames streamed back to back (replies sent at the same time on TX line)
+ *  and for frames sent after reply to the previous one. Every frame has to be executed and
+ *  replied with success, no byte can be lost. Then payload of the frame with wrong length, made of
+ *  text of SCPI command, has to be skipped. Finally frame changing TWI/I2C address followed by raw
+ *  words with phase word between halves of frequency register has to be replied with rejection
+ *  and the new address. Built and run by "make test" (see Makefile).
+ */
+
+#include <stdio.h>
+#include "config.h"
+#include "UsartEmulator.h"
+#include "Usart.h"
+#include "TWISlave.h"
+#include "UserInterface.h"
+#include "ExternalInterface.h"
+#include "SignalGeneratorAD9833.h"
+#include "StringTools.h"
+
+#define TEST_USART_COMMANDS 100000UL
+// sync, length not multiple of 4, payload and CRC making valid SCPI command
+#define TEST_USART_BAD_FRAME "\xA5\x06" "FREQ 1\n"
+#define TEST_USART_SYNC 0xA5
+#define TEST_USART_ADDRESS 0x30
+#define TEST_USART_STATUS_REJECTED 0x01
+
+static const uint8_t _testBursts[] = { 1, 2, 4, 8, 16, 32 };
+
+static uint32_t _testFreqReg = 0;
+static UIWaveType _testWaveType = UI_SIG_SQUARE;
+
+// host replacements of UserInterface.c and Settings.c functions used by ExternalInterface.c
+uint32_t usrGetCurrentFreqReg(void) {
+	return _testFreqReg;
+}
+
+UIWaveType usrGetWaveType(void) {
+	return _testWaveType;
+}
+
+void usrSyncParameters(uint32_t freqReg, UIWaveType waveType) {
+	_testFreqReg = freqReg;
+	_testWaveType = waveType;
+}
+
+bool settingsIsWriteDone(void) {
+	return true;
+}
+
+void settingsSaveTwiAddress(uint8_t address) {
+}
+
+/*
+ * Function testUsartBadLength
+ * Desc     sends frame with wrong length, its payload can't be executed as SCPI command
+ * Output   number of failures
+ */
+uint32_t testUsartBadLength(void) {
+	uint32_t freqReg = sgGetFreqReg();
+	uint8_t reply[8];
+	usartEmuReceive(reply, 0);
+	usartEmuSend((const uint8_t *)TEST_USART_BAD_FRAME, sizeof(TEST_USART_BAD_FRAME) - 1);
+	extLoop();
+	uint16_t length = usartEmuReceive(reply, sizeof(reply));
+	printf("wrong length frame: %u reply bytes, freqReg 0x%07lx\n", length, (unsigned long)sgGetFreqReg());
+	if (length != 0 || sgGetFreqReg() != freqReg) {
+		printf("FAIL payload of wrong length frame executed\n");
+		return 1;
+	}
+	return 0;
+}
+
+/*
+ * Function testUsartRawRejected
+ * Desc     sends frame with TWI/I2C address change (response 0x06) and three raw words: LSBs of FREQ0,
+ *          PHASE0 and MSBs of FREQ0, the raw words have to be rejected, the address has to be
+ *          changed and returned in the reply
+ * Output   number of failures
+ */
+uint32_t testUsartRawRejected(void) {
+	const uint32_t words[] = {
+		(0x06UL << 29) | (0x05UL << 24) | ((uint32_t)(uint8_t)~TEST_USART_ADDRESS << 8) | TEST_USART_ADDRESS,
+		(0x04UL << 29) | (0x11UL << 24) | 3,
+		0x40010000UL | 0xC000UL,
+		0x40020000UL
+	};
+	uint8_t frame[2 + sizeof(words) + 1];
+	frame[0] = TEST_USART_SYNC;
+	frame[1] = sizeof(words);
+	uint8_t crc = strCrc8(0, frame[1]);
+	for (uint8_t i = 0; i < sizeof(words); i++) {
+		frame[2 + i] = words[i / 4] >> (24 - 8 * (i & 0x03));
+		crc = strCrc8(crc, frame[2 + i]);
+	}
+	frame[sizeof(frame) - 1] = crc;
+	uint32_t freqReg = sgGetFreqReg();
+	uint8_t reply[8] = { 0 };
+	usartEmuReceive(reply, 0);
+	usartEmuSend(frame, sizeof(frame));
+	extLoop();
+	uint16_t length = usartEmuReceive(reply, sizeof(reply));
+	printf("raw words rejected: %u reply bytes, status %u, response 0x%02x, address 0x%02x, freqReg 0x%07lx\n",
+			length, reply[2], reply[6], twiGetAddress(), (unsigned long)sgGetFreqReg());
+	if (length != sizeof(reply) || reply[2] != TEST_USART_STATUS_REJECTED || reply[6] != TEST_USART_ADDRESS
+			|| twiGetAddress() != TEST_USART_ADDRESS || sgGetFreqReg() != freqReg) {
+		printf("FAIL rejected raw words\n");
+		return 1;
+	}
+	return 0;
+}
+
+int main(void) {
+	uint32_t failures = 0;
+	twiInit(TWI_SLAVE_ADDRESS);
+	usartInit();
+	printf("USART %lu baud, %lu commands per burst size\n", USART_BAUD, TEST_USART_COMMANDS);
+	printf("%5s %12s %12s %12s\n", "burst", "host cmd/s", "stream cmd/s", "await cmd/s");
+	for (uint8_t i = 0; i < sizeof(_testBursts); i++) {
+		usartEmuReset();
+		uint32_t hostRate = usartEmuBenchmark(_testBursts[i], TEST_USART_COMMANDS);
+		UsartEmuStats stats = usartEmuGetStats();
+		printf("%5u %12u %12u %12u\n", _testBursts[i], hostRate,
+				(uint32_t)(TEST_USART_COMMANDS * 1000000ULL / stats.rxTimeUs),
+				(uint32_t)(TEST_USART_COMMANDS * 1000000ULL / (stats.rxTimeUs + stats.txTimeUs)));
+		// the last command of the benchmark has to reach the generator
+		if (stats.badReplies != 0 || sgGetFreqReg() != ((TEST_USART_COMMANDS - 1) & SG_FREQ_REG_MASK)) {
+			printf("FAIL burst %u: %u bad replies\n", _testBursts[i], stats.badReplies);
+			failures++;
+		}
+	}
+	failures += testUsartBadLength();
+	failures += testUsartRawRejected();
+	if (usartGetOverflowCount() != 0) {
+		printf("FAIL %u bytes lost\n", usartGetOverflowCount());
+		failures++;
+	}
+	printf("%s: %u failures\n", (failures == 0) ? "PASS" : "FAIL", failures);
+	return (failures == 0) ? 0 : 1;
+}